@@ -0,0 +1,56 @@
+/**
+ * @author Daan Steenbergen
+ * @brief Splits the datagrams from AgOpenGPS into packets
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright 2026 Daan Steenbergen
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <span>
+
+/// @brief A callback interface for handling incoming packets
+/// @param src The source of the packet
+/// @param pgn The PGN of the packet
+/// @param data The data of the packet
+using PacketCallback = std::function<void(std::uint8_t src, std::uint8_t pgn, std::span<std::uint8_t> data)>;
+
+/// @brief Parses the packets of AgIO, independent of the socket they arrive on
+/// @details A packet is the start 0x80 0x81, the source, the PGN, the length of the data, the data and a CRC over
+/// the source up to the last data byte. A datagram may hold several packets, a packet that is cut off is
+/// dropped, so a lost datagram can't corrupt the packets after it.
+class AogPacketParser
+{
+public:
+	static constexpr std::size_t MAX_PACKET_SIZE = 512; ///< Mostly arbitrary, but should be large enough to hold any packet
+	static constexpr std::uint16_t PACKET_START = 0x8081;
+	static constexpr std::size_t HEADER_SIZE = 5; ///< Start, source, PGN and length
+
+	/**
+	 * @brief Set packet handler
+	 * @param packetCallback The callback to use for every complete packet
+	 */
+	void set_packet_handler(PacketCallback packetCallback);
+
+	/**
+	 * @brief Parse a received datagram, the packet handler is called for every complete packet in it
+	 * @param datagram The received data
+	 */
+	void parse(std::span<const std::uint8_t> datagram);
+
+	/**
+	 * @brief Calculate CRC for data
+	 * @param data The data to calculate the CRC for
+	 * @return The calculated CRC
+	 */
+	static std::uint8_t calculate_crc(std::span<const std::uint8_t> data);
+
+private:
+	PacketCallback packetCallback = nullptr;
+	std::array<std::uint8_t, MAX_PACKET_SIZE> buffer; ///< The datagram that is being parsed, the packet handler may modify it
+};
@@ -9,14 +9,21 @@
 #pragma once
 
 #include <boost/asio.hpp>
+#include <chrono>
 #include <memory>
 
 #include "isobus/hardware_integration/can_hardware_plugin.hpp"
 #include "isobus/isobus/isobus_speed_distance_messages.hpp"
 #include "isobus/isobus/nmea2000_message_interface.hpp"
 
+#include "app_clock.hpp"
+#include "dashboard.hpp"
+#include "loop_profiler.hpp"
+#include "loop_watchdog.hpp"
+#include "metrics_server.hpp"
 #include "settings.hpp"
 #include "task_controller.hpp"
+#include "traffic_recorder.hpp"
 #include "udp_connections.hpp"
 
 class Application
@@ -24,16 +31,68 @@ class Application
 public:
 	Application(std::shared_ptr<isobus::CANHardwarePlugin> canDriver);
 
+	/**
+	 * @brief Add a CAN channel next to the one of the task controller, before initialize
+	 * @details The channels are numbered from 1 in the order they are added, e.g. for simulated implements on a
+	 * virtual bus that is shared with the task controller's channel
+	 * @param driver The driver of the channel
+	 */
+	void add_can_driver(std::shared_ptr<isobus::CANHardwarePlugin> driver);
+
+	/**
+	 * @brief Record the datagrams of AgIO and the frames of the task controller's CAN channel, before initialize
+	 * @param path The file to record to
+	 * @return True if the recording was started, false otherwise
+	 */
+	bool record_traffic(const std::string &path);
+
+	/**
+	 * @brief Handle a datagram as if it was received from AgIO, e.g. to replay recorded traffic
+	 * @param datagram The datagram
+	 */
+	void inject_datagram(std::span<const std::uint8_t> datagram);
+
+	static constexpr auto UPDATE_INTERVAL = std::chrono::milliseconds(1); ///< The pace of update when nothing is scheduled sooner
+
 	bool initialize();
 	bool update();
 	void stop();
 
+	/**
+	 * @brief Get the time the next update should run, the main loop shouldn't wait longer than this
+	 * @details Scheduled section changes are sent from update, so a loop that waits until this time switches
+	 * them when they are due instead of up to a full wait later.
+	 * @return One update interval from now, or the next scheduled section change if that is sooner
+	 */
+	AppClock::time_point get_next_update_time() const;
+	const LoopProfiler &get_loop_profiler() const;
+	const LoopWatchdog &get_loop_watchdog() const;
+	std::shared_ptr<MyTCServer> get_task_controller() const; ///< nullptr until initialized
+
+	/**
+	 * @brief Build the data of the section status PGN (0xF0) of a client
+	 * @param state The client
+	 * @return The section control state, the number of sections, the actual states and the override states
+	 */
+	static std::vector<std::uint8_t> build_section_status(const ClientState &state);
+
 private:
+	void send_section_status(const ClientState &state); ///< Sends the section states of a client to AgIO on the status PGN
+	void send_task_totals(std::uint32_t taskId); ///< Sends the totals of a task to AgIO
+	void send_work_statistics(const ClientState &state); ///< Sends the live working width and area of a client to AgIO
+	void send_section_latencies(const ClientState &state); ///< Sends the measured section delays of a client to AgIO
+	void update_dashboard(); ///< Publishes the state of all clients to the dashboard
 	std::shared_ptr<Settings> settings = std::make_shared<Settings>();
 	boost::asio::io_context ioContext = boost::asio::io_context();
 	std::shared_ptr<UdpConnections> udpConnections = std::make_shared<UdpConnections>(settings, ioContext);
+	MetricsServer metricsServer = MetricsServer(ioContext);
+	Dashboard dashboard;
+	LoopProfiler loopProfiler; ///< Times the phases of update
+	LoopWatchdog loopWatchdog; ///< Records the updates that stall, from its own thread
+	TrafficRecorder trafficRecorder;
 
 	std::shared_ptr<isobus::CANHardwarePlugin> canDriver;
+	std::vector<std::shared_ptr<isobus::CANHardwarePlugin>> additionalCanDrivers;
 	std::shared_ptr<MyTCServer> tcServer;
 	std::unique_ptr<isobus::SpeedMessagesInterface> speedMessagesInterface;
 	std::unique_ptr<isobus::NMEA2000MessageInterface> nmea2000MessageInterface;
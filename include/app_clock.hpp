@@ -0,0 +1,81 @@
+/**
+ * @author Daan Steenbergen
+ * @brief The time source of the task controller, real or virtual for simulations
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright 2026 Daan Steenbergen
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+/// @brief A steady clock that can be switched to virtual time
+/// @details By default this is std::chrono::steady_clock. In virtual mode time stands still until the simulation
+/// advances it, so a scripted session runs as fast as the events can be processed and gives the same result
+/// on every run. Waiting until a time in virtual mode skips ahead to it instead of sleeping. Timestamps in the
+/// recorded files come from get_wall_time, which follows this clock so virtual hours stay hours in the files.
+class AppClock
+{
+public:
+	using rep = std::chrono::steady_clock::rep;
+	using period = std::chrono::steady_clock::period;
+	using duration = std::chrono::steady_clock::duration;
+	using time_point = std::chrono::time_point<AppClock>;
+	static constexpr bool is_steady = true;
+
+	/**
+	 * @brief Get the current time
+	 * @return The steady time, or the virtual time in virtual mode
+	 */
+	static time_point now();
+
+	/**
+	 * @brief Get the current time in milliseconds, a drop-in for isobus::SystemTiming::get_timestamp_ms
+	 * @return The time in milliseconds, wraps around like the stack's timestamps
+	 */
+	static std::uint32_t get_timestamp_ms();
+
+	/**
+	 * @brief Check if a timeout has expired since a timestamp from get_timestamp_ms
+	 * @param timestamp_ms The start of the timeout
+	 * @param timeout_ms The timeout
+	 * @return True if the timeout has expired, false otherwise
+	 */
+	static bool time_expired_ms(std::uint32_t timestamp_ms, std::uint32_t timeout_ms);
+
+	/**
+	 * @brief Switch between real and virtual time, virtual time continues from the current time
+	 * @param enable True to use virtual time, false to use the steady clock
+	 */
+	static void set_virtual(bool enable);
+
+	/// @brief Check if the clock runs on virtual time
+	static bool is_virtual();
+
+	/**
+	 * @brief Move virtual time forward, does nothing on real time
+	 * @param time The time to move to, ignored if it is not later than the current time
+	 */
+	static void advance_to(time_point time);
+
+	/**
+	 * @brief Get the calendar time of the current time, for the timestamps in recorded files
+	 * @return The calendar time at the start, or as last set, plus the time of this clock elapsed since then
+	 */
+	static std::chrono::system_clock::time_point get_wall_time();
+
+	/**
+	 * @brief Set the calendar time of the current time, e.g. to the start of a replayed recording
+	 * @param wallTime The calendar time that now() corresponds to
+	 */
+	static void set_wall_time(std::chrono::system_clock::time_point wallTime);
+
+	/**
+	 * @brief Wait until a time, in virtual mode this advances the clock instead
+	 * @param time The time to wait for
+	 */
+	static void sleep_until(time_point time);
+};
@@ -0,0 +1,189 @@
+/**
+ * @author Daan Steenbergen
+ * @brief Parses the command line options shared by the Windows and the headless executable
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright 2026 Daan Steenbergen
+ */
+
+#pragma once
+
+#include "isobus/isobus/can_stack_logger.hpp"
+
+#include "git.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/// @brief The CAN adapters that can be selected with --can_adapter
+enum class CANAdapter
+{
+	NONE,
+	ADAPTER_PCAN_USB,
+	ADAPTER_INNOMAKER_USB2CAN,
+	ADAPTER_RUSOKU_TOUCAN,
+	ADAPTER_SYS_TEC_USB2CAN,
+	ADAPTER_SOCKETCAN,
+	ADAPTER_VIRTUAL,
+};
+
+/// @brief Parses the command line options, the log level is applied right away
+class ArgumentProcessor
+{
+public:
+	ArgumentProcessor(std::vector<std::string> arguments) :
+	  arguments(arguments)
+	{
+	}
+
+	bool process()
+	{
+		for (std::string arg : arguments)
+		{
+			std::transform(arg.begin(), arg.end(), arg.begin(), [](unsigned char c) { return std::tolower(c); });
+			parse_option(arg);
+			parse_parameter(arg);
+		}
+		return true;
+	}
+
+	CANAdapter get_can_adapter() const
+	{
+		return canAdapter;
+	}
+
+	std::string get_can_channel() const
+	{
+		return canChannel;
+	}
+
+	bool is_file_logging() const
+	{
+		return fileLogging;
+	}
+
+	bool is_traffic_recording() const
+	{
+		return trafficRecording;
+	}
+
+private:
+	bool parse_option(std::string option)
+	{
+		if ("--help" == option)
+		{
+			std::cout << "Usage: " << PROJECT_NAME << " [options]\n";
+			std::cout << "Options:\n";
+			std::cout << "  --help\t\tShow this help message\n";
+			std::cout << "  --version\t\tShow the version of the application\n";
+			std::cout << "  --can_adapter=<driver>\tSelect the CAN driver\n";
+			std::cout << "  --can_channel=<channel>\tSelect the CAN channel\n";
+			std::cout << "  --log_level=<level>\tSet the log level (debug, info, warning, error, critical)\n";
+			std::cout << "  --log2file\t\tLog to file\n";
+			std::cout << "  --record_traffic\tRecord the traffic with AgIO and on the CAN bus, for traffic-replay\n";
+			exit(0);
+		}
+		else if ("--version" == option)
+		{
+			std::cout << std::string(git::Describe()) + (git::AnyUncommittedChanges() ? "-dirty" : "") << std::endl;
+			exit(0);
+		}
+		else if ("--log2file" == option)
+		{
+			fileLogging = true;
+		}
+		else if ("--record_traffic" == option)
+		{
+			trafficRecording = true;
+		}
+		else
+		{
+			return false;
+		}
+		return true;
+	}
+
+	bool parse_parameter(std::string parameter)
+	{
+		size_t pos = parameter.find('=');
+		if (pos == std::string::npos)
+		{
+			return false;
+		}
+		std::string key = parameter.substr(0, pos);
+		std::string value = parameter.substr(pos + 1);
+
+		if ("--can_adapter" == key)
+		{
+			static const std::unordered_map<std::string, CANAdapter> adapterMap = {
+#ifdef _WIN32
+				{ "peak-pcan", CANAdapter::ADAPTER_PCAN_USB },
+				{ "innomaker-usb2can", CANAdapter::ADAPTER_INNOMAKER_USB2CAN },
+				{ "rusoku-toucan", CANAdapter::ADAPTER_RUSOKU_TOUCAN },
+				{ "sys-tec-usb2can", CANAdapter::ADAPTER_SYS_TEC_USB2CAN },
+#else
+				{ "socketcan", CANAdapter::ADAPTER_SOCKETCAN },
+#endif
+				{ "virtual", CANAdapter::ADAPTER_VIRTUAL },
+			};
+
+			auto it = adapterMap.find(value);
+			if (it != adapterMap.end())
+			{
+				canAdapter = it->second;
+				return true;
+			}
+
+			std::cout << "Unknown CAN adapter: " << value.c_str() << std::endl;
+			return false;
+		}
+		else if ("--can_channel" == key)
+		{
+			canChannel = value;
+		}
+		else if ("--log_level" == key)
+		{
+			if ("debug" == value)
+			{
+				isobus::CANStackLogger::set_log_level(isobus::CANStackLogger::LoggingLevel::Debug);
+			}
+			else if ("info" == value)
+			{
+				isobus::CANStackLogger::set_log_level(isobus::CANStackLogger::LoggingLevel::Info);
+			}
+			else if ("warning" == value)
+			{
+				isobus::CANStackLogger::set_log_level(isobus::CANStackLogger::LoggingLevel::Warning);
+			}
+			else if ("error" == value)
+			{
+				isobus::CANStackLogger::set_log_level(isobus::CANStackLogger::LoggingLevel::Error);
+			}
+			else if ("critical" == value)
+			{
+				isobus::CANStackLogger::set_log_level(isobus::CANStackLogger::LoggingLevel::Critical);
+			}
+			else
+			{
+				std::cout << "Unknown log level: " << value.c_str() << std::endl;
+				return false;
+			}
+		}
+		else
+		{
+			return false;
+		}
+		return true;
+	}
+
+	std::vector<std::string> arguments;
+	CANAdapter canAdapter = CANAdapter::NONE;
+	std::string canChannel;
+	bool fileLogging = false;
+	bool trafficRecording = false;
+};
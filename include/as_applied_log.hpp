@@ -0,0 +1,141 @@
+/**
+ * @author Daan Steenbergen
+ * @brief A compact, memory-mapped log of what was applied where
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright 2026 Daan Steenbergen
+ */
+
+#pragma once
+
+#include "section_mask.hpp"
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+
+/// @brief An append-only as-applied log, made of fixed size chunks that are memory-mapped one at a time
+/// @details Every chunk starts with a header holding the time range and the bounding box of its records,
+/// followed by fixed size records. Appending a record is a copy into the mapped chunk, and a query only
+/// reads the records of the chunks whose header overlaps the requested area and time range. The file is
+/// in the byte order of the machine that wrote it.
+class AsAppliedLog
+{
+public:
+	static constexpr std::size_t CHUNK_SIZE = 1024 * 1024; ///< A multiple of the mapping granularity of every platform
+	static constexpr std::uint32_t CHUNK_MAGIC = 0x4C414141; ///< "AAAL"
+	static constexpr std::size_t MAX_NUMBER_OF_RATES = 8;
+
+	/// @brief A single position of a single client
+	struct Record
+	{
+		std::uint64_t timestamp_ms; ///< Milliseconds since the Unix epoch
+		std::uint64_t clientName; ///< The full ISO NAME of the client
+		std::array<std::uint64_t, 4> sectionStates; ///< The actual state of every section, one bit each
+		std::int32_t latitude; ///< 1e-7 degrees
+		std::int32_t longitude; ///< 1e-7 degrees
+		std::array<std::int32_t, MAX_NUMBER_OF_RATES> rates; ///< The rates last sent to the rate controlled elements
+		std::uint16_t heading; ///< 0.01 degrees
+		std::uint8_t numberOfSections;
+		std::uint8_t numberOfRates;
+		std::uint32_t reserved;
+	};
+	static_assert(sizeof(Record) == 96, "The record layout is part of the file format");
+
+	/// @brief The header at the start of every chunk, the index of the log
+	struct ChunkHeader
+	{
+		std::uint32_t magic;
+		std::uint32_t numberOfRecords;
+		std::uint64_t firstTimestamp_ms;
+		std::uint64_t lastTimestamp_ms;
+		std::int32_t minimumLatitude;
+		std::int32_t maximumLatitude;
+		std::int32_t minimumLongitude;
+		std::int32_t maximumLongitude;
+		std::array<std::uint8_t, 24> reserved;
+	};
+	static_assert(sizeof(ChunkHeader) == 64, "The chunk header layout is part of the file format");
+
+	static constexpr std::size_t RECORDS_PER_CHUNK = (CHUNK_SIZE - sizeof(ChunkHeader)) / sizeof(Record);
+
+	/// @brief The records a query is interested in, a default constructed query matches everything
+	struct Query
+	{
+		std::int32_t minimumLatitude = INT32_MIN; ///< 1e-7 degrees
+		std::int32_t maximumLatitude = INT32_MAX; ///< 1e-7 degrees
+		std::int32_t minimumLongitude = INT32_MIN; ///< 1e-7 degrees
+		std::int32_t maximumLongitude = INT32_MAX; ///< 1e-7 degrees
+		std::uint64_t startTimestamp_ms = 0;
+		std::uint64_t endTimestamp_ms = UINT64_MAX;
+	};
+
+	AsAppliedLog() = default;
+	~AsAppliedLog();
+	AsAppliedLog(const AsAppliedLog &) = delete;
+	AsAppliedLog &operator=(const AsAppliedLog &) = delete;
+
+	/**
+	 * @brief Open a log for appending, an existing log is continued
+	 * @param path The file to write
+	 * @return True if the log was opened, false otherwise
+	 */
+	bool open(const std::string &path);
+
+	/// @brief Close the log, everything appended so far stays in the file
+	void close();
+
+	/**
+	 * @brief Check whether the log is open for appending
+	 * @return True if open, false otherwise
+	 */
+	bool is_open() const;
+
+	/**
+	 * @brief Append the state of a client at a position
+	 * @details Positions where none of the sections of the client are on are skipped, except for the first
+	 * one after the sections turned off, so transport does not fill the log.
+	 * @param clientName The full ISO NAME of the client
+	 * @param latitude The latitude, in degrees
+	 * @param longitude The longitude, in degrees
+	 * @param heading_deg The heading, in degrees
+	 * @param sectionStates The actual section states
+	 * @param numberOfSections The number of sections of the client
+	 * @param rates The rates of the client, only the first MAX_NUMBER_OF_RATES are recorded
+	 * @param numberOfRates The number of rates
+	 */
+	void append(std::uint64_t clientName,
+	            double latitude,
+	            double longitude,
+	            double heading_deg,
+	            const SectionMask &sectionStates,
+	            std::uint8_t numberOfSections,
+	            const std::int32_t *rates,
+	            std::size_t numberOfRates);
+
+	/**
+	 * @brief Read the records that match a query, chunks outside of the query are skipped
+	 * @param path The log to read, it may be open for appending at the same time
+	 * @param query The area and time range to read
+	 * @param callback Called for every matching record, in the order they were appended
+	 * @return True if the log was read, false otherwise
+	 */
+	static bool query(const std::string &path, const Query &query, const std::function<void(const Record &)> &callback);
+
+private:
+	bool map_chunk(std::size_t index);
+	void unmap_chunk();
+
+#ifdef _WIN32
+	void *fileHandle = nullptr; ///< The HANDLE of the file
+	void *mappingHandle = nullptr; ///< The HANDLE of the mapping of the current chunk
+#else
+	int fileDescriptor = -1;
+#endif
+	std::uint8_t *chunk = nullptr; ///< The mapped chunk that is appended to
+	std::size_t chunkIndex = 0;
+	std::unordered_map<std::uint64_t, bool> workingClients; ///< Whether the last record of a client had any section on
+};
@@ -0,0 +1,158 @@
+/**
+ * @author Daan Steenbergen
+ * @brief Asynchronous logging to the console and rotating log files
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright 2026 Daan Steenbergen
+ */
+
+#pragma once
+
+#include "isobus/isobus/can_stack_logger.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+/// @brief A logging backend that keeps formatting and I/O away from the threads that log
+/// @details A log call copies a compact record, holding a pointer to the format string and the raw argument
+/// values, into a lock-free ring owned by the calling thread. Strings are copied into the records that follow
+/// it. A background thread drains the rings of all threads, formats the records, and writes them to the console
+/// and to a log file that is rotated when it grows too large. If a ring is full the record is dropped and
+/// counted, logging never blocks.
+class AsyncLogger
+{
+public:
+	using Level = isobus::CANStackLogger::LoggingLevel;
+
+	static constexpr std::size_t MAX_NUMBER_OF_ARGUMENTS = 5;
+	static constexpr std::size_t RING_CAPACITY = 1024; ///< Records per thread, a power of two
+	static constexpr std::size_t MAX_STRING_LENGTH = 1024; ///< Longer string arguments are truncated
+	static constexpr std::uint64_t MAX_FILE_SIZE = 10 * 1024 * 1024; ///< The log file is rotated when it reaches this size
+	static constexpr std::size_t NUMBER_OF_ROTATED_FILES = 5; ///< How many rotated log files are kept
+
+	/// @brief How an argument is stored in a record
+	enum class ArgumentType : std::uint8_t
+	{
+		Signed,
+		Unsigned,
+		Floating,
+		Boolean,
+		String ///< The value is the length, the characters follow the record
+	};
+
+	/// @brief A log call, followed by the characters of its string arguments
+	struct Record
+	{
+		std::int64_t timestamp_us; ///< Microseconds since the Unix epoch
+		const char *format; ///< A string literal with a {} per argument, nullptr for text that is written as is
+		std::array<std::uint64_t, MAX_NUMBER_OF_ARGUMENTS> arguments; ///< The raw argument values
+		std::array<ArgumentType, MAX_NUMBER_OF_ARGUMENTS> types;
+		std::uint8_t level; ///< The Level, stored as a byte to keep the record small
+		std::uint8_t numberOfArguments;
+		std::uint8_t numberOfExtensionRecords; ///< The records after this one that hold the string arguments
+	};
+	static_assert(sizeof(Record) == 64, "A record should fill a cache line");
+
+	/**
+	 * @brief Start the background thread, records logged before are kept until then
+	 * @param console The console to write to, usually the original buffer of std::cout
+	 * @param filePath The log file to write to, empty to only write to the console
+	 * @return True if started, false if the log file could not be opened
+	 */
+	static bool start(std::streambuf *console, const std::string &filePath);
+
+	/// @brief Write everything that is still queued and stop the background thread, later records are written directly
+	static void stop();
+
+	/**
+	 * @brief Log a message
+	 * @param level The level of the message
+	 * @param format A string literal with a {} for every argument, it must outlive the logger
+	 * @param arguments Integers, floating point numbers, booleans, enums, and strings, strings are copied
+	 */
+	template<typename... Arguments>
+	static void log(Level level, const char *format, const Arguments &...arguments)
+	{
+		static_assert(sizeof...(Arguments) <= MAX_NUMBER_OF_ARGUMENTS, "Too many arguments for a log record");
+		Record record;
+		record.timestamp_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+		record.format = format;
+		record.level = static_cast<std::uint8_t>(level);
+		record.numberOfArguments = static_cast<std::uint8_t>(sizeof...(Arguments));
+		std::array<std::string_view, MAX_NUMBER_OF_ARGUMENTS> strings;
+		std::size_t index = 0;
+		(set_argument(record, strings, index++, arguments), ...);
+		push(record, strings);
+	}
+
+	/**
+	 * @brief Check whether messages of a level are logged, this follows the level set for the CAN stack
+	 * @param level The level to check
+	 * @return True if messages of the level are logged, false otherwise
+	 */
+	static bool is_enabled(Level level)
+	{
+		return level >= isobus::CANStackLogger::get_log_level();
+	}
+
+	/**
+	 * @brief Log a line of text that is written as is, like the output of std::cout
+	 * @param text The text, without the line ending
+	 */
+	static void log_text(std::string_view text);
+
+	/**
+	 * @brief Get the number of records that were dropped because a ring was full
+	 * @return The number of dropped records
+	 */
+	static std::uint64_t get_number_of_dropped_records();
+
+private:
+	template<typename T>
+	static void set_argument(Record &record, std::array<std::string_view, MAX_NUMBER_OF_ARGUMENTS> &strings, std::size_t index, const T &value)
+	{
+		if constexpr (std::is_same_v<T, bool>)
+		{
+			record.types[index] = ArgumentType::Boolean;
+			record.arguments[index] = value ? 1 : 0;
+		}
+		else if constexpr (std::is_enum_v<T>)
+		{
+			set_argument(record, strings, index, static_cast<std::underlying_type_t<T>>(value));
+		}
+		else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>)
+		{
+			record.types[index] = ArgumentType::Signed;
+			record.arguments[index] = static_cast<std::uint64_t>(static_cast<std::int64_t>(value));
+		}
+		else if constexpr (std::is_integral_v<T>)
+		{
+			record.types[index] = ArgumentType::Unsigned;
+			record.arguments[index] = static_cast<std::uint64_t>(value);
+		}
+		else if constexpr (std::is_floating_point_v<T>)
+		{
+			double floating = static_cast<double>(value);
+			record.types[index] = ArgumentType::Floating;
+			std::memcpy(&record.arguments[index], &floating, sizeof(floating));
+		}
+		else
+		{
+			static_assert(std::is_convertible_v<const T &, std::string_view>, "Unsupported log argument type");
+			std::string_view string(value);
+			strings[index] = string.substr(0, MAX_STRING_LENGTH);
+			record.types[index] = ArgumentType::String;
+			record.arguments[index] = strings[index].size();
+		}
+	}
+
+	static void push(Record &record, const std::array<std::string_view, MAX_NUMBER_OF_ARGUMENTS> &strings);
+};
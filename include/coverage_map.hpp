@@ -0,0 +1,191 @@
+/**
+ * @author Daan Steenbergen
+ * @brief A tile based coverage map for position based section control
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright 2026 Daan Steenbergen
+ */
+
+#pragma once
+
+#include "section_mask.hpp"
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/// @brief Keeps track of the worked area in sparse bitmap tiles and decides which sections overlap it
+/// @details The field is divided in square cells, a set bit means the cell has been worked. Cells are
+/// grouped in fixed-size tiles that are only allocated once something is painted in them, and are found
+/// through an open addressing hash table. The number of tiles of each map is capped, when the cap is reached
+/// the least recently used tile is recycled so the memory of a map stays bounded regardless of the field size.
+/// The cap applies per map, so the total memory grows with the number of connected implements.
+class CoverageMap
+{
+public:
+	/// @brief A point in the local field frame (x = east, y = north), in meters
+	struct Point
+	{
+		double x; ///< East from the origin
+		double y; ///< North from the origin
+	};
+
+	/// @brief The geometry of a section relative to the position reported by AOG (ISO 11783 axes)
+	struct SectionGeometry
+	{
+		double xOffset_m; ///< Offset in the direction of travel
+		double yOffset_m; ///< Offset to the right of the direction of travel
+		double width_m; ///< The working width of the section
+	};
+
+	static constexpr std::int32_t TILE_SHIFT = 8;
+	static constexpr std::int32_t TILE_SIZE = 1 << TILE_SHIFT; ///< Number of cells along each side of a tile
+	static constexpr std::int32_t WORDS_PER_ROW = TILE_SIZE / 64; ///< Number of 64-bit words per tile row
+	static constexpr std::size_t TILE_MEMORY = TILE_SIZE * TILE_SIZE / 8; ///< Bytes of bitmap per tile
+	static constexpr double DEFAULT_CELL_SIZE_M = 0.25; ///< 64x64 meter per tile
+	static constexpr std::size_t DEFAULT_MAX_TILES = 4096; ///< 32 MB per map, enough for roughly 1600 ha
+	static constexpr double DEFAULT_OVERLAP_THRESHOLD = 0.5; ///< Fraction of a section that may be covered before it is turned off
+	static constexpr double MAXIMUM_POSITION_JUMP_M = 10.0; ///< Larger jumps between fixes are not painted
+
+	/**
+	 * @brief Construct a new coverage map
+	 * @param cellSize_m The size of a single cell
+	 * @param maxTiles The maximum number of tiles to keep in memory
+	 */
+	explicit CoverageMap(double cellSize_m = DEFAULT_CELL_SIZE_M, std::size_t maxTiles = DEFAULT_MAX_TILES);
+
+	/**
+	 * @brief Set the maximum number of tiles to keep in memory, this removes all coverage
+	 * @param maxTiles The maximum number of tiles, at least 1
+	 */
+	void set_max_tiles(std::size_t maxTiles);
+
+	/**
+	 * @brief Set the section geometry, this resets the painting state but keeps the coverage
+	 * @param sections The geometry for every section
+	 */
+	void set_sections(std::vector<SectionGeometry> sections);
+
+	/**
+	 * @brief Get the section geometry
+	 * @return The geometry for every section
+	 */
+	const std::vector<SectionGeometry> &get_sections() const;
+
+	/**
+	 * @brief Set the fraction of a section that may be covered before it is considered covered
+	 * @param threshold The fraction, between 0 and 1
+	 */
+	void set_overlap_threshold(double threshold);
+
+	/**
+	 * @brief Paint the swath of the sections that are on and evaluate the coverage ahead
+	 * @param latitude The latitude of the reference position, in degrees
+	 * @param longitude The longitude of the reference position, in degrees
+	 * @param heading_deg The heading, clockwise from north
+	 * @param sectionsOn The sections that are actually on
+	 * @param lookAhead_m How far ahead of each section the coverage is evaluated
+	 */
+	void update(double latitude, double longitude, double heading_deg, const SectionMask &sectionsOn, double lookAhead_m);
+
+	/**
+	 * @brief Check whether a section is ahead of already covered area, as of the last update
+	 * @param section The section index
+	 * @return True if the section would overlap, false otherwise
+	 */
+	bool is_section_covered(std::uint8_t section) const;
+
+	/**
+	 * @brief Get the fraction of the area ahead of a section that is covered, as of the last update
+	 * @param section The section index
+	 * @return The covered fraction, between 0 and 1
+	 */
+	double get_section_coverage(std::uint8_t section) const;
+
+	/**
+	 * @brief Mark a convex quadrilateral as covered
+	 * @param quad The corners of the quadrilateral, in order
+	 */
+	void paint_quad(const std::array<Point, 4> &quad);
+
+	/**
+	 * @brief Get the covered fraction along a line segment
+	 * @param from The start of the segment
+	 * @param to The end of the segment
+	 * @return The covered fraction, between 0 and 1
+	 */
+	double get_coverage(Point from, Point to) const;
+
+	/**
+	 * @brief Check whether a single point is covered
+	 * @param point The point to check
+	 * @return True if the cell containing the point is covered
+	 */
+	bool is_covered(Point point) const;
+
+	/// @brief Remove all coverage and forget the origin
+	void clear();
+
+	/**
+	 * @brief Get the area that has been covered at least once
+	 * @details Counted while painting, so it includes recycled tiles. Painting over a recycled tile counts again.
+	 * @return The covered area in square meters
+	 */
+	double get_covered_area() const;
+
+	/**
+	 * @brief Get the number of allocated tiles
+	 * @return The number of tiles
+	 */
+	std::size_t get_number_of_tiles() const;
+
+	/**
+	 * @brief Get the memory used by the tiles and the hash table
+	 * @return The memory usage in bytes
+	 */
+	std::size_t get_memory_usage() const;
+
+private:
+	static constexpr std::int32_t NO_TILE = -1;
+
+	/// @brief A square block of cells, one bit per cell
+	struct Tile
+	{
+		std::uint64_t key = 0; ///< The packed tile coordinates
+		std::int32_t older = NO_TILE; ///< The previous tile in the usage list, towards the least recently used
+		std::int32_t newer = NO_TILE; ///< The next tile in the usage list, towards the most recently used
+		std::array<std::uint64_t, TILE_SIZE * WORDS_PER_ROW> rows = {}; ///< Row major bitmap
+	};
+
+	static std::uint64_t make_key(std::int32_t tileX, std::int32_t tileY);
+	std::size_t get_home_slot(std::uint64_t key) const;
+	const Tile *find_tile(std::int32_t tileX, std::int32_t tileY) const;
+	Tile *get_or_create_tile(std::int32_t tileX, std::int32_t tileY);
+	void remove_slot(std::size_t slot);
+	void unlink_tile(std::int32_t tileIndex);
+	void link_newest_tile(std::int32_t tileIndex);
+	void fill_span(std::int32_t cellY, std::int32_t cellX0, std::int32_t cellX1);
+	Point to_local(double latitude, double longitude);
+
+	double cellSize_m;
+	std::size_t maxTiles;
+	std::vector<std::unique_ptr<Tile>> tiles; ///< Tile storage, never shrinks
+	std::vector<std::int32_t> slots; ///< Hash table of indices into tiles
+	std::int32_t oldestTile = NO_TILE; ///< The least recently used tile, recycled first
+	std::int32_t newestTile = NO_TILE; ///< The most recently used tile
+	std::uint64_t numberOfCoveredCells = 0; ///< The number of cells that went from uncovered to covered
+
+	std::vector<SectionGeometry> sections;
+	Point previousPosition = { 0.0, 0.0 }; ///< The reference position at the previous fix
+	std::vector<std::array<Point, 2>> previousEdges; ///< Left and right edge of each section at the previous fix
+	SectionMask previousSectionsOn; ///< Which sections were on at the previous fix
+	std::vector<double> sectionCoverage; ///< Covered fraction ahead of each section at the last fix
+	double overlapThreshold = DEFAULT_OVERLAP_THRESHOLD;
+	bool hasPreviousFix = false;
+	bool hasOrigin = false;
+	double originLatitude = 0.0;
+	double originLongitude = 0.0;
+	double metersPerDegreeLongitude = 0.0;
+};
@@ -0,0 +1,124 @@
+/**
+ * @author Daan Steenbergen
+ * @brief A live dashboard on localhost, updated with server-sent events
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright 2026 Daan Steenbergen
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <boost/asio.hpp>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+/// @brief The state shown on the dashboard, copied from the control loop
+struct DashboardSnapshot
+{
+	/// @brief One section of a client, with its place on the implement
+	struct Section
+	{
+		std::uint8_t setpointState = 0; ///< 0 = off, 1 = on, 2 = error, 3 = not installed
+		std::uint8_t actualState = 0; ///< 0 = off, 1 = on, 2 = error, 3 = not installed
+		bool isOverridden = false; ///< Taken over by the operator
+		double xOffset_m = 0.0; ///< Offset in the direction of travel
+		double yOffset_m = 0.0; ///< Offset to the right of the direction of travel
+		double width_m = 0.0;
+	};
+
+	/// @brief A measurement command the TC sent to a client
+	struct Subscription
+	{
+		std::uint16_t ddi = 0;
+		std::uint16_t elementNumber = 0;
+		std::uint32_t timeInterval_ms = 0; ///< 0 if not triggered by time
+		bool isOnChange = false;
+	};
+
+	/// @brief A client with an activated object pool
+	struct Client
+	{
+		std::uint64_t name = 0;
+		std::uint8_t address = 0;
+		std::string designator; ///< The designator of the device object
+		bool isSectionControlEnabled = false;
+		std::uint8_t numberOfBooms = 0;
+		std::vector<Section> sections;
+		std::vector<Subscription> subscriptions;
+	};
+
+	std::vector<Client> clients;
+	std::uint8_t numberOfClients = 0; ///< The clients in use, the vector keeps its capacity between snapshots
+};
+
+/// @brief Serves a dashboard page and streams the latest snapshot to it as server-sent events
+/// @details The dashboard runs on its own thread and io_context. The control loop publishes snapshots into a
+/// triple buffer, which never blocks or allocates once the buffers have grown to size. The dashboard thread
+/// picks up the newest snapshot at most at the configured frame rate and only pushes it when its content changed.
+class Dashboard
+{
+public:
+	static constexpr std::uint16_t DEFAULT_PORT = 9465;
+	static constexpr std::uint8_t DEFAULT_FRAME_RATE = 10;
+
+	Dashboard();
+	~Dashboard();
+	Dashboard(const Dashboard &) = delete;
+	Dashboard &operator=(const Dashboard &) = delete;
+
+	/**
+	 * @brief Start serving the dashboard
+	 * @param port The TCP port to listen on, on the loopback address
+	 * @param frameRate The maximum number of updates per second sent to the browser
+	 * @return True if the dashboard is served, false otherwise
+	 */
+	bool start(std::uint16_t port, std::uint8_t frameRate);
+
+	/// @brief Stop serving the dashboard and its thread
+	void stop();
+
+	/**
+	 * @brief Get the snapshot to fill in, only to be used by the thread that publishes
+	 * @return The snapshot that is not visible to the dashboard thread
+	 */
+	DashboardSnapshot &get_back_buffer();
+
+	/// @brief Make the back buffer the newest snapshot, the previous newest one becomes the back buffer
+	void publish();
+
+	bool is_running() const;
+
+private:
+	struct Connection;
+
+	void accept();
+	void on_frame(); ///< Takes the newest snapshot and pushes it to the subscribers if it changed
+	void schedule_frame();
+	std::string format_snapshot(const DashboardSnapshot &snapshot);
+
+	static constexpr std::uint8_t NEW_SNAPSHOT = 0x04; ///< Set in the middle index when the publisher swapped in a new snapshot
+	static constexpr std::uint8_t INDEX_MASK = 0x03;
+	std::array<DashboardSnapshot, 3> snapshots;
+	std::uint8_t backIndex = 0; ///< Owned by the publisher
+	std::atomic<std::uint8_t> middleIndex = 1;
+	std::uint8_t frontIndex = 2; ///< Owned by the dashboard thread
+
+	boost::asio::io_context ioContext;
+	boost::asio::ip::tcp::acceptor acceptor;
+	boost::asio::steady_timer frameTimer;
+	std::chrono::milliseconds frameInterval = std::chrono::milliseconds(100);
+	std::thread thread;
+	std::vector<std::shared_ptr<Connection>> subscribers;
+	std::string lastEvent; ///< The last pushed snapshot, sent right away to new subscribers
+	std::chrono::steady_clock::time_point lastPush;
+	std::chrono::steady_clock::time_point busLoadStart;
+	std::uint64_t busLoadStartFrames = 0;
+	float busLoad_percent = 0.0f;
+};
@@ -0,0 +1,120 @@
+/**
+ * @author Daan Steenbergen
+ * @brief A journal of typed binary events, rotated and compressed in the background
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright 2026 Daan Steenbergen
+ */
+
+#pragma once
+
+#include "section_mask.hpp"
+
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/// @brief Records what happened with the clients and the connection to AgIO as compact binary events
+/// @details Events are appended to a segment file. Once a segment reaches MAX_SEGMENT_SIZE it is closed and a
+/// background thread compresses it with the JournalCodec, removing the oldest compressed segments when there
+/// are more than MAX_NUMBER_OF_SEGMENTS. Every event is a type byte, a payload length byte, a 64 bit timestamp
+/// in microseconds since the Unix epoch and the payload, all little endian.
+class EventJournal
+{
+public:
+	static constexpr std::uint64_t MAX_SEGMENT_SIZE = 1024 * 1024;
+	static constexpr std::size_t MAX_NUMBER_OF_SEGMENTS = 100;
+	static constexpr std::array<char, 4> SEGMENT_MAGIC = { 'T', 'C', 'E', 'J' };
+	static constexpr std::array<char, 4> COMPRESSED_MAGIC = { 'T', 'C', 'J', 'Z' };
+	static constexpr const char *SEGMENT_EXTENSION = ".tcj";
+	static constexpr const char *COMPRESSED_EXTENSION = ".tcz";
+
+	/// @brief The types of events, the values are part of the file format
+	enum class EventType : std::uint8_t
+	{
+		ClientConnected = 1, ///< NAME, address
+		ClientDisconnected = 2, ///< NAME
+		PoolActivated = 3, ///< NAME, number of sections, number of booms
+		SectionChange = 4, ///< NAME, number of sections, one actual state bit per section
+		ProcessDataAcknowledgeError = 5, ///< NAME, DDI, element number, error codes, command
+		SubnetChange = 6 ///< The three octets of the subnet
+	};
+
+	/// @brief The output formats of the decoder
+	enum class Format : std::uint8_t
+	{
+		Text,
+		Json ///< One object per line
+	};
+
+	EventJournal() = default;
+	~EventJournal();
+	EventJournal(const EventJournal &) = delete;
+	EventJournal &operator=(const EventJournal &) = delete;
+
+	/**
+	 * @brief Start a new segment in a directory, segments of earlier runs that weren't compressed yet are compressed
+	 * @param directory The directory to write the segments to, must exist
+	 * @return True if the journal was opened, false otherwise
+	 */
+	bool open(const std::string &directory);
+
+	/// @brief Close the current segment, the background thread finishes compressing first
+	void close();
+
+	/// @brief Write the buffered events to the segment, e.g. once per second
+	void flush();
+
+	void log_client_connected(std::uint64_t clientName, std::uint8_t address);
+	void log_client_disconnected(std::uint64_t clientName);
+	void log_pool_activated(std::uint64_t clientName, std::uint8_t numberOfSections, std::uint8_t numberOfBooms);
+	void log_section_change(std::uint64_t clientName, std::uint8_t numberOfSections, const SectionMask &actualStates); ///< Only logged when the states differ from the last logged ones
+	void log_process_data_acknowledge_error(std::uint64_t clientName, std::uint16_t ddi, std::uint16_t elementNumber, std::uint8_t errorCodes, std::uint8_t command);
+	void log_subnet_change(const std::array<std::uint8_t, 3> &subnet);
+
+	/**
+	 * @brief Read a segment, compressed or not
+	 * @param path The segment file
+	 * @param events Set to the events in the segment
+	 * @return True if the segment was read, false otherwise
+	 */
+	static bool read_segment(const std::string &path, std::vector<std::uint8_t> &events);
+
+	/**
+	 * @brief Write the events of a segment in a readable format
+	 * @param events The events, as returned by read_segment
+	 * @param format The format to write
+	 * @param output The stream to write to
+	 * @return True if all events were decoded, false if the segment ends in a partial event
+	 */
+	static bool decode(const std::vector<std::uint8_t> &events, Format format, std::ostream &output);
+
+private:
+	void write_event(EventType type, const std::uint8_t *payload, std::uint8_t payloadSize);
+	bool open_segment();
+	void compression_thread();
+	static bool compress_segment(const std::string &path);
+	void remove_old_segments();
+
+	std::string segmentDirectory;
+	std::ofstream segmentFile;
+	std::string segmentPath;
+	std::uint64_t segmentSize = 0;
+	std::uint32_t segmentNumber = 0; ///< Numbers the segments of a run, the name also holds the start time
+	std::unordered_map<std::uint64_t, SectionMask> lastSectionStates; ///< The last logged section states of each client
+
+	std::thread compressionThread;
+	std::mutex compressionMutex;
+	std::condition_variable compressionCondition;
+	std::deque<std::string> segmentsToCompress;
+	bool isStopRequested = false;
+};
@@ -0,0 +1,38 @@
+/**
+ * @author Daan Steenbergen
+ * @brief A small LZ77 codec for the closed segments of the event journal
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright 2026 Daan Steenbergen
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+/// @brief Compresses data with greedy LZ77 matching in the sequence layout of LZ4
+/// @details Every sequence starts with a token holding the number of literals in the upper nibble and the match
+/// length minus 4 in the lower nibble, a nibble of 15 is extended with bytes until one is below 255. The literals
+/// follow, then the 16 bit little endian offset of the match and the extension of the match length. The last
+/// sequence only holds literals. Journal records repeat the same NAMEs and types, which this handles well.
+class JournalCodec
+{
+public:
+	/**
+	 * @brief Compress data
+	 * @param input The data to compress
+	 * @return The compressed data
+	 */
+	static std::vector<std::uint8_t> compress(const std::vector<std::uint8_t> &input);
+
+	/**
+	 * @brief Decompress data
+	 * @param input The compressed data
+	 * @param originalSize The size of the data before it was compressed
+	 * @param output Set to the decompressed data
+	 * @return True if the data was decompressed, false if it is corrupt
+	 */
+	static bool decompress(const std::vector<std::uint8_t> &input, std::size_t originalSize, std::vector<std::uint8_t> &output);
+};
@@ -0,0 +1,128 @@
+/**
+ * @author Daan Steenbergen
+ * @brief Level filtered and rate limited logging macros
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright 2026 Daan Steenbergen
+ */
+
+#pragma once
+
+#include "async_logger.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+/// Log calls below this level are compiled out: 0 = debug, 1 = info, 2 = warning, 3 = error, 4 = critical
+#ifndef TC_LOG_MINIMUM_LEVEL
+#ifdef NDEBUG
+#define TC_LOG_MINIMUM_LEVEL 1
+#else
+#define TC_LOG_MINIMUM_LEVEL 0
+#endif
+#endif
+
+/// @brief Lets a log call site through at most once per interval, counting what it holds back
+class LogRateLimiter
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	/**
+	 * @brief Construct a rate limiter
+	 * @param interval The minimum time between two messages
+	 */
+	explicit LogRateLimiter(std::chrono::milliseconds interval) :
+	  interval(interval)
+	{
+	}
+
+	/**
+	 * @brief Check whether the call site may log now
+	 * @param numberOfSuppressed Set to the number of messages held back since the last one that was let through
+	 * @return True if the message should be logged, false otherwise
+	 */
+	bool try_acquire(std::uint32_t &numberOfSuppressed)
+	{
+		auto now = Clock::now().time_since_epoch().count();
+		auto next = nextAllowed.load(std::memory_order_relaxed);
+		if ((now < next) || !nextAllowed.compare_exchange_strong(next, now + std::chrono::duration_cast<Clock::duration>(interval).count(), std::memory_order_relaxed))
+		{
+			suppressed.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+		numberOfSuppressed = suppressed.exchange(0, std::memory_order_relaxed);
+		return true;
+	}
+
+private:
+	const std::chrono::milliseconds interval;
+	std::atomic<Clock::rep> nextAllowed = 0; ///< Since the clock's epoch
+	std::atomic<std::uint32_t> suppressed = 0;
+};
+
+/// The arguments are only evaluated when the runtime level (--log_level) lets the message through
+#define TC_LOG(level, ...)                          \
+	do                                              \
+	{                                               \
+		if (AsyncLogger::is_enabled(level))         \
+		{                                           \
+			AsyncLogger::log((level), __VA_ARGS__); \
+		}                                           \
+	} while (false)
+
+/// Like TC_LOG, but a call site logs at most once per interval, e.g. for messages that could repeat every cycle
+#define TC_LOG_EVERY(level, interval_ms, ...)                                                                     \
+	do                                                                                                            \
+	{                                                                                                             \
+		if (AsyncLogger::is_enabled(level))                                                                       \
+		{                                                                                                         \
+			static LogRateLimiter tcLogRateLimiter(std::chrono::milliseconds(interval_ms));                       \
+			std::uint32_t tcLogNumberOfSuppressed = 0;                                                            \
+			if (tcLogRateLimiter.try_acquire(tcLogNumberOfSuppressed))                                            \
+			{                                                                                                     \
+				if (tcLogNumberOfSuppressed > 0)                                                                  \
+				{                                                                                                 \
+					AsyncLogger::log((level), "The next message was suppressed {} times", tcLogNumberOfSuppressed); \
+				}                                                                                                 \
+				AsyncLogger::log((level), __VA_ARGS__);                                                           \
+			}                                                                                                     \
+		}                                                                                                         \
+	} while (false)
+
+#if TC_LOG_MINIMUM_LEVEL <= 0
+#define TC_LOG_DEBUG(...) TC_LOG(AsyncLogger::Level::Debug, __VA_ARGS__)
+#define TC_LOG_DEBUG_EVERY(interval_ms, ...) TC_LOG_EVERY(AsyncLogger::Level::Debug, interval_ms, __VA_ARGS__)
+#else
+#define TC_LOG_DEBUG(...) ((void)0)
+#define TC_LOG_DEBUG_EVERY(interval_ms, ...) ((void)0)
+#endif
+
+#if TC_LOG_MINIMUM_LEVEL <= 1
+#define TC_LOG_INFO(...) TC_LOG(AsyncLogger::Level::Info, __VA_ARGS__)
+#define TC_LOG_INFO_EVERY(interval_ms, ...) TC_LOG_EVERY(AsyncLogger::Level::Info, interval_ms, __VA_ARGS__)
+#else
+#define TC_LOG_INFO(...) ((void)0)
+#define TC_LOG_INFO_EVERY(interval_ms, ...) ((void)0)
+#endif
+
+#if TC_LOG_MINIMUM_LEVEL <= 2
+#define TC_LOG_WARNING(...) TC_LOG(AsyncLogger::Level::Warning, __VA_ARGS__)
+#define TC_LOG_WARNING_EVERY(interval_ms, ...) TC_LOG_EVERY(AsyncLogger::Level::Warning, interval_ms, __VA_ARGS__)
+#else
+#define TC_LOG_WARNING(...) ((void)0)
+#define TC_LOG_WARNING_EVERY(interval_ms, ...) ((void)0)
+#endif
+
+#if TC_LOG_MINIMUM_LEVEL <= 3
+#define TC_LOG_ERROR(...) TC_LOG(AsyncLogger::Level::Error, __VA_ARGS__)
+#define TC_LOG_ERROR_EVERY(interval_ms, ...) TC_LOG_EVERY(AsyncLogger::Level::Error, interval_ms, __VA_ARGS__)
+#else
+#define TC_LOG_ERROR(...) ((void)0)
+#define TC_LOG_ERROR_EVERY(interval_ms, ...) ((void)0)
+#endif
+
+#define TC_LOG_CRITICAL(...) TC_LOG(AsyncLogger::Level::Critical, __VA_ARGS__)
+#define TC_LOG_CRITICAL_EVERY(interval_ms, ...) TC_LOG_EVERY(AsyncLogger::Level::Critical, interval_ms, __VA_ARGS__)
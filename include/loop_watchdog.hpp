@@ -0,0 +1,80 @@
+/**
+ * @author Daan Steenbergen
+ * @brief Detects stalls of the main loop from a separate thread
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright 2026 Daan Steenbergen
+ */
+
+#pragma once
+
+#include "loop_profiler.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// @brief Watches the loop counter of a LoopProfiler and records every stall of the main loop
+/// @details When a loop runs longer than the threshold, the phase that is running is captured right away and a
+/// warning is logged, also when the loop never recovers. Once the loop continues, the stall is recorded with its
+/// full duration. The watchdog only reads the profiler's atomics, so it adds nothing to the main loop.
+class LoopWatchdog
+{
+public:
+	using Clock = LoopProfiler::Clock;
+
+	static constexpr std::chrono::milliseconds DEFAULT_THRESHOLD = std::chrono::milliseconds(50); ///< Half of the section status heartbeat
+	static constexpr std::size_t MAX_NUMBER_OF_STALLS = 100; ///< The oldest records are dropped
+
+	/// @brief A snapshot of the main loop taken when it stalled
+	struct Stall
+	{
+		std::chrono::system_clock::time_point time; ///< When the stall was detected
+		std::uint64_t loopNumber = 0; ///< The loop that stalled
+		LoopProfiler::Phase phase = LoopProfiler::Phase::Loop; ///< The running phase, Loop if it was outside of update
+		std::chrono::milliseconds timeInPhase{ 0 }; ///< How long the phase was running when the stall was detected
+		std::chrono::milliseconds duration{ 0 }; ///< The whole loop, 0 while it is still stalled
+	};
+
+	LoopWatchdog() = default;
+	~LoopWatchdog();
+	LoopWatchdog(const LoopWatchdog &) = delete;
+	LoopWatchdog &operator=(const LoopWatchdog &) = delete;
+
+	/**
+	 * @brief Start watching a main loop
+	 * @param profiler The profiler the main loop marks its phases with, must outlive the watchdog thread
+	 * @param threshold Loops that take longer are recorded as stalls
+	 */
+	void start(const LoopProfiler &profiler, std::chrono::milliseconds threshold = DEFAULT_THRESHOLD);
+
+	/// @brief Stop the watchdog thread
+	void stop();
+
+	/**
+	 * @brief Get the recorded stalls, safe to call from any thread
+	 * @return The most recent stalls, oldest first
+	 */
+	std::vector<Stall> get_stalls() const;
+
+	/**
+	 * @brief Get the number of stalls since the start, safe to call from any thread
+	 * @return The number of stalls, including the ones that were dropped from the records
+	 */
+	std::uint64_t get_number_of_stalls() const;
+
+private:
+	void watch(const LoopProfiler &profiler, std::chrono::milliseconds threshold);
+
+	std::thread thread;
+	mutable std::mutex mutex;
+	std::condition_variable stopCondition;
+	bool isStopRequested = false;
+	std::deque<Stall> stalls;
+	std::uint64_t numberOfStalls = 0;
+};
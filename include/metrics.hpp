@@ -0,0 +1,94 @@
+/**
+ * @author Daan Steenbergen
+ * @brief Runtime counters and histograms, exported in the Prometheus text format
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright 2026 Daan Steenbergen
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+/// @brief A histogram with fixed upper bounds, that can be observed from any thread
+/// @details Only the bucket a value falls in is counted, the cumulative counts Prometheus expects are summed when formatted.
+class MetricsHistogram
+{
+public:
+	static constexpr std::size_t MAX_NUMBER_OF_BOUNDS = 12;
+
+	/**
+	 * @brief Construct a histogram
+	 * @param upperBounds The inclusive upper bound of each bucket, ascending, a last bucket counts everything above them
+	 */
+	template<std::size_t N>
+	constexpr explicit MetricsHistogram(const std::array<std::uint32_t, N> &upperBounds) :
+	  numberOfBounds(N)
+	{
+		static_assert(N <= MAX_NUMBER_OF_BOUNDS, "Too many buckets");
+		for (std::size_t i = 0; i < N; i++)
+		{
+			bounds[i] = upperBounds[i];
+		}
+	}
+
+	void observe(std::uint32_t value)
+	{
+		std::size_t bucket = 0;
+		while ((bucket < numberOfBounds) && (value > bounds[bucket]))
+		{
+			bucket++;
+		}
+		counts[bucket].fetch_add(1, std::memory_order_relaxed);
+		sum.fetch_add(value, std::memory_order_relaxed);
+	}
+
+	/**
+	 * @brief Append the histogram in the Prometheus text format
+	 * @param output The text to append to
+	 * @param name The name of the metric, without the _bucket, _sum and _count suffixes
+	 * @param help The description of the metric
+	 * @param scale Multiplies the observed values to get the unit of the metric, e.g. 1e-6 for microseconds to seconds
+	 */
+	void format(std::string &output, const char *name, const char *help, double scale) const;
+
+private:
+	std::array<std::uint32_t, MAX_NUMBER_OF_BOUNDS> bounds = {};
+	std::size_t numberOfBounds;
+	std::array<std::atomic<std::uint64_t>, MAX_NUMBER_OF_BOUNDS + 1> counts = {};
+	std::atomic<std::uint64_t> sum = 0;
+};
+
+/// @brief The counters of the whole application
+/// @details Every counter is a relaxed atomic that is only incremented where the event happens, the CAN
+/// frame counters from the hardware thread and the others from the main loop. Nothing is merged or locked
+/// until the text is formatted for a scrape, so counting never contends with the main loop.
+class Metrics
+{
+public:
+	static constexpr std::size_t MAX_NUMBER_OF_CLIENTS = 32; ///< Clients beyond this share one "other" series
+
+	static void count_udp_packet_received(std::uint8_t pgn);
+	static void count_udp_packet_sent(std::uint8_t pgn);
+	static void count_udp_crc_error();
+	static void count_can_frame_received();
+	static void count_can_frame_sent();
+	static void count_set_value_sent();
+	static void count_process_data_acknowledge_error(std::uint64_t clientName);
+	static void count_section_switch();
+	static void count_loop_stall();
+	static void set_number_of_active_clients(std::uint32_t numberOfClients);
+	static void observe_loop_duration(std::uint32_t duration_us);
+	static void observe_section_latency(std::uint32_t latency_ms);
+	static std::uint64_t get_number_of_can_frames(); ///< Sent and received, e.g. to estimate the bus load
+
+	/**
+	 * @brief Format all metrics in the Prometheus text exposition format (version 0.0.4)
+	 * @return The text to serve on a scrape
+	 */
+	static std::string format();
+};
@@ -0,0 +1,43 @@
+/**
+ * @author Daan Steenbergen
+ * @brief Serves the metrics over HTTP on localhost
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright 2026 Daan Steenbergen
+ */
+
+#pragma once
+
+#include <boost/asio.hpp>
+#include <cstdint>
+
+/// @brief A minimal HTTP server that answers GET /metrics with Metrics::format()
+/// @details Runs on the application's io_context, so requests are handled when the main loop polls it. Only
+/// the loopback address is bound, the metrics are meant for a scraper on the same machine.
+class MetricsServer
+{
+public:
+	static constexpr std::uint16_t DEFAULT_PORT = 9464;
+
+	/**
+	 * @brief Construct a new metrics server
+	 * @param ioContext The IO context to use, must be polled for requests to be handled
+	 */
+	explicit MetricsServer(boost::asio::io_context &ioContext);
+
+	/**
+	 * @brief Start listening for requests
+	 * @param port The TCP port to listen on
+	 * @return True if the server is listening, false otherwise
+	 */
+	bool open(std::uint16_t port);
+
+	/// @brief Stop listening, requests in progress are aborted
+	void close();
+
+private:
+	void accept();
+
+	boost::asio::ip::tcp::acceptor acceptor;
+};
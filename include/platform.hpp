@@ -0,0 +1,33 @@
+/**
+ * @author Daan Steenbergen
+ * @brief The few operating system specific functions the task controller needs
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright 2026 Daan Steenbergen
+ */
+
+#pragma once
+
+#include <ctime>
+#include <filesystem>
+
+/// @brief Wraps the calls that differ between Windows and Linux, so everything else builds on both
+class Platform
+{
+public:
+	/**
+	 * @brief Get the directory the settings, logs and task data are stored in
+	 * @details %APPDATA%\\AOG-TaskController on Windows, $XDG_DATA_HOME/AOG-TaskController (by default
+	 * ~/.local/share/AOG-TaskController) elsewhere. The directory is not created.
+	 * @return The data directory
+	 */
+	static std::filesystem::path get_data_directory();
+
+	/**
+	 * @brief Convert a time to the local calendar time, thread safe unlike std::localtime
+	 * @param time The time to convert
+	 * @return The local calendar time
+	 */
+	static std::tm get_local_time(std::time_t time);
+};
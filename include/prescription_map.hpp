@@ -0,0 +1,116 @@
+/**
+ * @author Daan Steenbergen
+ * @brief A grid based prescription map for variable rate application
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright 2026 Daan Steenbergen
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+/// @brief Holds the rates of a prescription grid and looks them up by position
+/// @details The grid follows the layout of an ISO 11783-10 type 2 grid: equally sized cells in degrees,
+/// starting at the south-west corner. Cells are stored in small square blocks instead of row by row, so
+/// the cells a section sweeps over between two fixes are close together in memory. A lookup is a few
+/// multiplications and a single array access, no search is involved.
+class PrescriptionMap
+{
+public:
+	static constexpr std::int32_t NO_RATE = std::numeric_limits<std::int32_t>::min(); ///< Marks cells without a prescription
+	static constexpr std::int32_t BLOCK_SHIFT = 3;
+	static constexpr std::int32_t BLOCK_SIZE = 1 << BLOCK_SHIFT; ///< Number of cells along each side of a block, 8x8 cells fill four cache lines
+	static constexpr std::uint8_t MAX_SAMPLES_PER_SECTION = 8; ///< Upper limit of the points sampled across a section
+
+	/**
+	 * @brief Load a prescription map from a JSON description of the grid
+	 * @details The description contains the grid definition like the GRD element of ISO-XML
+	 * ("minimumNorth", "minimumEast", "cellNorthSize", "cellEastSize", "columns", "rows"), the "ddi" of the
+	 * setpoint rate, an optional "defaultRate" for outside the grid, and either the rates inline as "rates"
+	 * or the name of a type 2 binary grid file (little endian int32 per cell) as "file".
+	 * @param path The path to the description
+	 * @return True if the map was loaded, false otherwise
+	 */
+	bool load(const std::string &path);
+
+	/**
+	 * @brief Set the grid directly
+	 * @param ddi The setpoint rate DDI the rates are for
+	 * @param minimumNorth The latitude of the south edge of the grid, in degrees
+	 * @param minimumEast The longitude of the west edge of the grid, in degrees
+	 * @param cellNorthSize The height of a cell, in degrees
+	 * @param cellEastSize The width of a cell, in degrees
+	 * @param columns The number of cells from west to east
+	 * @param rows The number of cells from south to north
+	 * @param rates The rates, row by row starting in the south-west corner
+	 * @param defaultRate The rate outside the grid, or NO_RATE
+	 * @return True if the grid is valid, false otherwise
+	 */
+	bool set_grid(std::uint16_t ddi,
+	              double minimumNorth,
+	              double minimumEast,
+	              double cellNorthSize,
+	              double cellEastSize,
+	              std::uint32_t columns,
+	              std::uint32_t rows,
+	              const std::vector<std::int32_t> &rates,
+	              std::int32_t defaultRate = NO_RATE);
+
+	/**
+	 * @brief Check whether a map is loaded
+	 * @return True if a map is loaded, false otherwise
+	 */
+	bool is_loaded() const;
+
+	/**
+	 * @brief Get the setpoint rate DDI the rates are for
+	 * @return The DDI
+	 */
+	std::uint16_t get_ddi() const;
+
+	/**
+	 * @brief Get the rate at a single position
+	 * @param latitude The latitude, in degrees
+	 * @param longitude The longitude, in degrees
+	 * @return The rate, or NO_RATE if there is no prescription for the position
+	 */
+	std::int32_t get_rate(double latitude, double longitude) const;
+
+	/**
+	 * @brief Get the average rate across the width of a section
+	 * @param latitude The latitude of the reference position, in degrees
+	 * @param longitude The longitude of the reference position, in degrees
+	 * @param heading_deg The heading, clockwise from north
+	 * @param xOffset_m The offset of the section in the direction of travel
+	 * @param yOffset_m The offset of the section to the right of the direction of travel
+	 * @param width_m The width of the section
+	 * @return The average rate of the sampled points, or NO_RATE if none of them has a prescription
+	 */
+	std::int32_t get_section_rate(double latitude, double longitude, double heading_deg, double xOffset_m, double yOffset_m, double width_m) const;
+
+	/**
+	 * @brief Get the memory used by the grid
+	 * @return The memory usage in bytes
+	 */
+	std::size_t get_memory_usage() const;
+
+private:
+	std::size_t get_index(std::uint32_t column, std::uint32_t row) const;
+
+	std::vector<std::int32_t> cells; ///< The rates, block by block
+	std::uint32_t numberOfColumns = 0;
+	std::uint32_t numberOfRows = 0;
+	std::uint32_t blocksPerRow = 0;
+	double minimumNorth = 0.0;
+	double minimumEast = 0.0;
+	double rowsPerDegree = 0.0; ///< The inverse of the cell height, so a lookup needs no division
+	double columnsPerDegree = 0.0; ///< The inverse of the cell width
+	double cellSize_m = 0.0; ///< The smallest side of a cell, decides how many points are sampled across a section
+	std::int32_t defaultRate = NO_RATE;
+	std::uint16_t ddi = 0;
+};
@@ -0,0 +1,152 @@
+/**
+ * @author Daan Steenbergen
+ * @brief Keeps the recent history of the process data reported by the clients
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright 2026 Daan Steenbergen
+ */
+
+#pragma once
+
+#include "app_clock.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+/// @brief A fixed-memory time series store for process data values
+/// @details Every series keeps its raw samples in a ring buffer, next to rings of minimum/maximum/mean
+/// rollups per second and per minute. The rollups are updated on insert, so a query at a coarse resolution
+/// never has to look at the raw samples. Once a ring is full its oldest entry is overwritten.
+class ProcessDataHistory
+{
+public:
+	using Clock = AppClock;
+
+	static constexpr std::size_t MAX_NUMBER_OF_SERIES = 64; ///< Values of further series are not kept
+	static constexpr std::size_t NUMBER_OF_RAW_SAMPLES = 600; ///< A minute at 10 Hz
+	static constexpr std::size_t NUMBER_OF_SECONDS = 600; ///< Ten minutes of 1 second rollups
+	static constexpr std::size_t NUMBER_OF_MINUTES = 1440; ///< A day of 1 minute rollups
+
+	/// @brief The resolution of a query
+	enum class Resolution : std::uint8_t
+	{
+		Raw,
+		Second,
+		Minute
+	};
+
+	/// @brief A point of a history, for raw samples the minimum, maximum and mean are the value itself
+	struct Sample
+	{
+		Clock::time_point time; ///< The time of the sample, or the start of the rollup period
+		std::int32_t minimum;
+		std::int32_t maximum;
+		double mean;
+	};
+
+	/**
+	 * @brief Add a value to its series, the series is created the first time it is seen
+	 * @param clientName The full ISO NAME of the client
+	 * @param elementNumber The element the value belongs to
+	 * @param ddi The DDI of the value
+	 * @param value The value
+	 * @param now The time the value was received
+	 */
+	void add(std::uint64_t clientName, std::uint16_t elementNumber, std::uint16_t ddi, std::int32_t value, Clock::time_point now);
+
+	/**
+	 * @brief Get the recent history of a series, oldest first
+	 * @param clientName The full ISO NAME of the client
+	 * @param elementNumber The element the value belongs to
+	 * @param ddi The DDI of the value
+	 * @param resolution The resolution to return the history in
+	 * @param span How far to look back from the newest point
+	 * @param history Filled with the points, the vector is cleared first
+	 * @return True if the series exists, false otherwise
+	 */
+	bool get_history(std::uint64_t clientName,
+	                 std::uint16_t elementNumber,
+	                 std::uint16_t ddi,
+	                 Resolution resolution,
+	                 Clock::duration span,
+	                 std::vector<Sample> &history) const;
+
+	/**
+	 * @brief Get the newest value of a series
+	 * @param clientName The full ISO NAME of the client
+	 * @param elementNumber The element the value belongs to
+	 * @param ddi The DDI of the value
+	 * @param value Set to the newest value
+	 * @return True if the series has a value, false otherwise
+	 */
+	bool get_latest(std::uint64_t clientName, std::uint16_t elementNumber, std::uint16_t ddi, std::int32_t &value) const;
+
+	/// @brief Forget all series of a client, e.g. when it disconnects
+	void remove_client(std::uint64_t clientName);
+
+private:
+	/// @brief A fixed capacity ring, the oldest entry is overwritten when full
+	template<typename T, std::size_t N>
+	struct Ring
+	{
+		std::array<T, N> entries;
+		std::size_t next = 0; ///< Where the next entry is written
+		std::size_t count = 0;
+
+		void push(const T &entry);
+		T &newest();
+		const T &at(std::size_t age) const; ///< 0 is the newest entry
+	};
+
+	/// @brief A raw sample
+	struct RawSample
+	{
+		Clock::time_point time;
+		std::int32_t value;
+	};
+
+	/// @brief The aggregate of a rollup period
+	struct Rollup
+	{
+		Clock::time_point start;
+		std::int32_t minimum;
+		std::int32_t maximum;
+		std::int64_t sum;
+		std::uint32_t count;
+	};
+
+	/// @brief The history of one value
+	struct Series
+	{
+		Ring<RawSample, NUMBER_OF_RAW_SAMPLES> raw;
+		Ring<Rollup, NUMBER_OF_SECONDS> seconds;
+		Ring<Rollup, NUMBER_OF_MINUTES> minutes;
+	};
+
+	/// @brief Identifies a series
+	struct Key
+	{
+		std::uint64_t clientName;
+		std::uint32_t elementAndDdi; ///< Element number in the upper half, DDI in the lower half
+
+		bool operator==(const Key &other) const = default;
+	};
+
+	/// @brief Hashes a key for the lookup table
+	struct KeyHash
+	{
+		std::size_t operator()(const Key &key) const;
+	};
+
+	template<std::size_t N>
+	static void add_to_rollups(Ring<Rollup, N> &rollups, Clock::time_point now, Clock::duration period, std::int32_t value);
+	template<std::size_t N>
+	static void get_rollups(const Ring<Rollup, N> &rollups, Clock::duration span, std::vector<Sample> &history);
+
+	std::unordered_map<Key, std::unique_ptr<Series>, KeyHash> series; ///< Allocated once per series, the rings never grow
+};
@@ -0,0 +1,107 @@
+/**
+ * @author Daan Steenbergen
+ * @brief Measures how long each section takes to follow its setpoint
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright 2026 Daan Steenbergen
+ */
+
+#pragma once
+
+#include "app_clock.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// @brief Matches every setpoint change of a section with the actual state change that follows it
+/// @details The time in between is counted in a fixed-bucket histogram per section and direction, so
+/// memory does not grow with the number of samples and percentiles are read directly from the counts.
+class SectionLatencyProfiler
+{
+public:
+	using Clock = AppClock;
+
+	static constexpr std::uint16_t BUCKET_WIDTH_MS = 20;
+	static constexpr std::uint16_t NUMBER_OF_BUCKETS = 128; ///< The last bucket also counts everything above 2.5 seconds
+	static constexpr std::chrono::milliseconds MAXIMUM_LATENCY = std::chrono::seconds(10); ///< Slower responses are not caused by the setpoint
+
+	/// @brief The latency distribution of one direction of one section
+	struct Histogram
+	{
+		std::array<std::uint16_t, NUMBER_OF_BUCKETS> counts = {};
+		std::uint32_t numberOfSamples = 0;
+
+		void add(std::chrono::milliseconds latency);
+		std::uint32_t get_percentile(float percentile) const; ///< In milliseconds, 0 without samples
+	};
+
+	/**
+	 * @brief Set the number of sections, this discards all measurements
+	 * @param number The number of sections
+	 */
+	void set_number_of_sections(std::uint8_t number);
+
+	/**
+	 * @brief Register the setpoint that was sent for a section, only changes start a measurement
+	 * @param section The section index
+	 * @param on The setpoint that was sent
+	 * @param now The time the setpoint was sent
+	 */
+	void on_setpoint_sent(std::uint8_t section, bool on, Clock::time_point now);
+
+	/**
+	 * @brief Register the actual state reported for a section, a change completes the measurement
+	 * @param section The section index
+	 * @param on The reported actual state
+	 * @param now The time the state was received
+	 */
+	void on_actual_state(std::uint8_t section, bool on, Clock::time_point now);
+
+	/**
+	 * @brief Get the distribution of a section
+	 * @param section The section index
+	 * @param on True for the latency of switching on, false for switching off
+	 * @return The histogram
+	 */
+	const Histogram &get_histogram(std::uint8_t section, bool on) const;
+
+	/**
+	 * @brief Get the delay that compensates the median latency of all sections
+	 * @param on True for switching on, false for switching off
+	 * @return The recommended delay in milliseconds, 0 without samples
+	 */
+	std::uint32_t get_recommended_delay(bool on) const;
+
+	/**
+	 * @brief Get the number of measurements over all sections
+	 * @param on True for switching on, false for switching off
+	 * @return The number of measurements
+	 */
+	std::uint32_t get_number_of_samples(bool on) const;
+
+	/**
+	 * @brief Write the distribution of every section to a CSV file, if anything was measured since the last export
+	 * @param path The file to write
+	 * @return True if the file is up to date, false if writing failed
+	 */
+	bool export_csv(const std::string &path);
+
+private:
+	/// @brief The measurement state of a single section
+	struct SectionState
+	{
+		Histogram onLatency;
+		Histogram offLatency;
+		Clock::time_point setpointTime = {}; ///< When the pending setpoint was sent
+		bool lastSetpoint = false;
+		bool lastActual = false;
+		bool isPending = false; ///< Whether the actual state did not follow the last setpoint yet
+	};
+
+	std::vector<SectionState> sections;
+	bool hasNewSamples = false; ///< Whether anything was measured since the last export
+};
@@ -0,0 +1,88 @@
+/**
+ * @author Daan Steenbergen
+ * @brief Maps AOG's sections onto the physical sections of an implement
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright 2026 Daan Steenbergen
+ */
+
+#pragma once
+
+#include "section_mask.hpp"
+
+#include <cstdint>
+#include <vector>
+
+/// @brief Maps the (at most 64) virtual sections that AOG controls onto the physical sections of the implement
+/// @details AOG divides the implement into a small number of sections of equal width, while the implement
+/// may have many more individually switchable sections. The lateral overlap between both is precomputed as a
+/// sparse matrix, and collapsed into one physical section mask per virtual section, so mapping a request from
+/// AOG is a handful of word-wide OR operations.
+class VirtualSectionMapping
+{
+public:
+	/// @brief The lateral position of a physical section
+	struct LateralSection
+	{
+		std::int32_t yOffset_mm; ///< The offset of the center of the section, positive to the right
+		std::int32_t width_mm; ///< The width of the section
+	};
+
+	/// @brief A single non-zero entry of the overlap matrix
+	struct OverlapEntry
+	{
+		std::uint8_t physicalSection; ///< The physical section index
+		float fraction; ///< The fraction of the physical section's width that lies within the virtual section
+	};
+
+	static constexpr std::uint8_t MAX_VIRTUAL_SECTIONS = 64; ///< Virtual sections are stored in a single word
+	static constexpr float MINIMUM_OVERLAP_FRACTION = 0.5f; ///< A physical section follows every virtual section that covers at least this much of it
+
+	/**
+	 * @brief Divide the width of the implement into equal virtual sections and precompute the mapping
+	 * @param physicalSections The lateral geometry of the physical sections, in section index order
+	 * @param numberOfVirtualSections The number of sections AOG controls
+	 * @return True if the mapping is used, false if sections are mapped one-to-one
+	 */
+	bool configure(const std::vector<LateralSection> &physicalSections, std::uint8_t numberOfVirtualSections);
+
+	/**
+	 * @brief Check whether a mapping is configured
+	 * @return True if AOG's sections are mapped, false if they are used one-to-one
+	 */
+	bool is_enabled() const;
+
+	/**
+	 * @brief Get the number of sections AOG controls
+	 * @return The number of virtual sections
+	 */
+	std::uint8_t get_number_of_virtual_sections() const;
+
+	/**
+	 * @brief Map a request from AOG onto the physical sections
+	 * @param virtualSections The virtual sections that should be on
+	 * @return The physical sections that should be on
+	 */
+	SectionMask to_physical(const SectionMask &virtualSections) const;
+
+	/**
+	 * @brief Map the physical section states back to AOG's sections
+	 * @param physicalSections The physical sections that are on
+	 * @return The virtual sections that have any of their physical sections on
+	 */
+	SectionMask to_virtual(const SectionMask &physicalSections) const;
+
+	/**
+	 * @brief Get the overlap entries of a single virtual section
+	 * @param virtualSection The virtual section index
+	 * @return The physical sections that overlap the virtual section
+	 */
+	std::vector<OverlapEntry> get_overlaps(std::uint8_t virtualSection) const;
+
+private:
+	std::uint8_t numberOfVirtualSections = 0;
+	std::vector<SectionMask> physicalMasks; ///< The physical sections driven by each virtual section
+	std::vector<std::uint32_t> rowOffsets; ///< Start of each virtual section's entries, compressed sparse row format
+	std::vector<OverlapEntry> overlapEntries; ///< The non-zero entries of the overlap matrix
+};
@@ -0,0 +1,147 @@
+/**
+ * @author Daan Steenbergen
+ * @brief A packed one-bit-per-section mask
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright 2026 Daan Steenbergen
+ */
+
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstdint>
+
+constexpr std::uint16_t MAX_NUMBER_OF_SECTIONS = 256; ///< The condensed work state DDIs address at most 256 sections
+
+/// @brief One bit per section, operations work on 64 sections at a time
+class SectionMask
+{
+public:
+	static constexpr std::uint8_t NUMBER_OF_WORDS = MAX_NUMBER_OF_SECTIONS / 64;
+
+	bool test(std::uint16_t section) const
+	{
+		return (section < MAX_NUMBER_OF_SECTIONS) && ((words[section / 64] >> (section % 64)) & 1);
+	}
+
+	void set(std::uint16_t section, bool value = true)
+	{
+		if (section < MAX_NUMBER_OF_SECTIONS)
+		{
+			std::uint64_t bit = 1ULL << (section % 64);
+			words[section / 64] = value ? (words[section / 64] | bit) : (words[section / 64] & ~bit);
+		}
+	}
+
+	bool any() const
+	{
+		return (words[0] | words[1] | words[2] | words[3]) != 0;
+	}
+
+	std::uint16_t count() const
+	{
+		return static_cast<std::uint16_t>(std::popcount(words[0]) + std::popcount(words[1]) + std::popcount(words[2]) + std::popcount(words[3]));
+	}
+
+	void clear()
+	{
+		words.fill(0);
+	}
+
+	/// @brief Get the 16 bits of one condensed work state group
+	std::uint16_t get_group(std::uint8_t group) const
+	{
+		return static_cast<std::uint16_t>(words[group / 4] >> (16 * (group % 4)));
+	}
+
+	/// @brief Replace the 16 bits of one condensed work state group
+	void set_group(std::uint8_t group, std::uint16_t bits)
+	{
+		std::uint8_t shift = 16 * (group % 4);
+		words[group / 4] = (words[group / 4] & ~(0xFFFFULL << shift)) | (static_cast<std::uint64_t>(bits) << shift);
+	}
+
+	/// @brief Get a bitmask of the condensed work state groups that have any bit set
+	std::uint16_t get_groups() const
+	{
+		std::uint16_t groups = 0;
+		for (std::uint8_t group = 0; group < MAX_NUMBER_OF_SECTIONS / 16; group++)
+		{
+			groups |= (get_group(group) != 0) << group;
+		}
+		return groups;
+	}
+
+	/// @brief Call a function with the index of every set bit, in ascending order
+	template<typename Function>
+	void for_each_set(Function function) const
+	{
+		for (std::uint8_t i = 0; i < NUMBER_OF_WORDS; i++)
+		{
+			std::uint64_t remaining = words[i];
+			while (0 != remaining)
+			{
+				function(static_cast<std::uint16_t>(64 * i + std::countr_zero(remaining)));
+				remaining &= remaining - 1; // Clear the lowest set bit
+			}
+		}
+	}
+
+	SectionMask &operator|=(const SectionMask &other)
+	{
+		for (std::uint8_t i = 0; i < NUMBER_OF_WORDS; i++)
+		{
+			words[i] |= other.words[i];
+		}
+		return *this;
+	}
+
+	SectionMask &operator&=(const SectionMask &other)
+	{
+		for (std::uint8_t i = 0; i < NUMBER_OF_WORDS; i++)
+		{
+			words[i] &= other.words[i];
+		}
+		return *this;
+	}
+
+	SectionMask &operator^=(const SectionMask &other)
+	{
+		for (std::uint8_t i = 0; i < NUMBER_OF_WORDS; i++)
+		{
+			words[i] ^= other.words[i];
+		}
+		return *this;
+	}
+
+	friend SectionMask operator|(SectionMask a, const SectionMask &b)
+	{
+		return a |= b;
+	}
+
+	friend SectionMask operator&(SectionMask a, const SectionMask &b)
+	{
+		return a &= b;
+	}
+
+	friend SectionMask operator^(SectionMask a, const SectionMask &b)
+	{
+		return a ^= b;
+	}
+
+	SectionMask operator~() const
+	{
+		SectionMask result;
+		for (std::uint8_t i = 0; i < NUMBER_OF_WORDS; i++)
+		{
+			result.words[i] = ~words[i];
+		}
+		return result;
+	}
+
+	bool operator==(const SectionMask &other) const = default;
+
+	std::array<std::uint64_t, NUMBER_OF_WORDS> words = {}; ///< Section 0 is the least significant bit of the first word
+};
@@ -0,0 +1,116 @@
+/**
+ * @author Daan Steenbergen
+ * @brief A look-ahead scheduler that compensates section switching latencies
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright 2026 Daan Steenbergen
+ */
+
+#pragma once
+
+#include "app_clock.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+/// @brief Times section setpoint changes so the physical switch lands on the boundary.
+/// @details AOG switches its sections a configured look-ahead before the boundary is reached.
+/// Every section on the implement has its own (on/off) latency, so the scheduler converts the
+/// look-ahead into a travelled distance and releases each change once the remaining distance
+/// equals the distance covered during that section's latency.
+class SectionScheduler
+{
+public:
+	using Clock = AppClock;
+
+	/// @brief A section change that is due to be sent to the implement
+	struct SectionChange
+	{
+		std::uint8_t section; ///< The section index
+		bool on; ///< The new desired state of the section
+	};
+
+	/// @brief Below this speed the boundary can't be predicted, so changes are released immediately
+	static constexpr std::int32_t MINIMUM_SPEED_MM_PER_S = 100;
+
+	/**
+	 * @brief Set the number of sections to schedule, this clears any pending changes
+	 * @param number The number of sections
+	 */
+	void set_number_of_sections(std::uint8_t number);
+
+	/**
+	 * @brief Set the latency of a section
+	 * @param section The section index
+	 * @param onLatency_ms The time between the setpoint and the section physically turning on
+	 * @param offLatency_ms The time between the setpoint and the section physically turning off
+	 */
+	void set_section_latency(std::uint8_t section, std::uint32_t onLatency_ms, std::uint32_t offLatency_ms);
+
+	/**
+	 * @brief Set the look-ahead that AOG applies before the boundary
+	 * @param onLookAhead_ms The look-ahead for turning sections on
+	 * @param offLookAhead_ms The look-ahead for turning sections off
+	 */
+	void set_look_ahead(std::uint32_t onLookAhead_ms, std::uint32_t offLookAhead_ms);
+
+	/**
+	 * @brief Check whether changes are delayed at all
+	 * @return True if a look-ahead is configured, false if changes should be sent immediately
+	 */
+	bool is_enabled() const;
+
+	/**
+	 * @brief Update the travel speed, integrates the travelled distance and re-times pending changes
+	 * @param speed_mm_per_s The current speed, negative when reversing
+	 * @param now The time of the speed measurement
+	 */
+	void update_speed(std::int32_t speed_mm_per_s, Clock::time_point now);
+
+	/**
+	 * @brief Schedule a desired state for a section
+	 * @param section The section index
+	 * @param on The desired state as requested by AOG
+	 * @param currentlyOn The state that was last sent to the implement
+	 * @param now The time the desired state was received
+	 */
+	void schedule(std::uint8_t section, bool on, bool currentlyOn, Clock::time_point now);
+
+	/**
+	 * @brief Move all changes that are due into the output list
+	 * @param now The current time
+	 * @param changes The list to append the due changes to
+	 * @return True if any change was due, false otherwise
+	 */
+	bool pop_due_changes(Clock::time_point now, std::vector<SectionChange> &changes);
+
+	/**
+	 * @brief Get the time at which the next pending change is due
+	 * @return The due time, or Clock::time_point::max() if nothing is pending
+	 */
+	Clock::time_point get_next_due_time() const;
+
+private:
+	/// @brief The state of a section that is waiting to be switched
+	struct PendingChange
+	{
+		bool pending = false; ///< Whether or not a change is waiting
+		bool on = false; ///< The desired state
+		std::int64_t boundaryDistance_um = 0; ///< The odometer value at which the boundary is crossed
+		Clock::time_point dueTime; ///< The time at which the change must be sent
+	};
+
+	/// @brief Calculates the time at which a pending change must be sent at the current speed
+	Clock::time_point calculate_due_time(std::uint8_t section, const PendingChange &change) const;
+
+	std::vector<PendingChange> pendingChanges; ///< One slot per section
+	std::vector<std::uint32_t> onLatencies_ms; ///< The turn on latency per section
+	std::vector<std::uint32_t> offLatencies_ms; ///< The turn off latency per section
+	std::uint32_t onLookAhead_ms = 0; ///< The look-ahead AOG uses for turning on
+	std::uint32_t offLookAhead_ms = 0; ///< The look-ahead AOG uses for turning off
+	std::int32_t speed_mm_per_s = 0; ///< The absolute speed of the last update
+	std::int64_t odometer_um = 0; ///< The distance travelled since start, in micrometers
+	Clock::time_point odometerTime; ///< The time of the last odometer update
+};
@@ -10,6 +10,7 @@
 #pragma once
 
 #include <array>
+#include <cstdint>
 #include <string>
 
 /// @brief A class to store/load AOG-TC settings to/from a file
@@ -55,7 +56,77 @@ public:
 	 */
 	static std::string get_filename_path(std::string);
 
+	/**
+	 * @brief Get the absolute path to a directory in the data directory, it is created if needed
+	 * @param directoryName The directory to get the path for
+	 * @return The absolute path to the directory
+	 */
+	static std::string get_directory_path(std::string directoryName);
+
+	/**
+	 * @brief Get the look-ahead AOG applies when turning sections on
+	 * @return The look-ahead in milliseconds, 0 if section changes should be sent immediately
+	 */
+	std::uint32_t get_section_look_ahead_on() const;
+
+	/**
+	 * @brief Get the look-ahead AOG applies when turning sections off
+	 * @return The look-ahead in milliseconds, 0 if section changes should be sent immediately
+	 */
+	std::uint32_t get_section_look_ahead_off() const;
+
+	/**
+	 * @brief Get whether sections over already covered area are turned off by the TC itself
+	 * @return True if coverage based section control is enabled, false otherwise
+	 */
+	bool is_coverage_section_control_enabled() const;
+
+	/**
+	 * @brief Get the memory the coverage map of a single implement may use, every connected implement has its own map
+	 * @return The memory limit per implement in megabytes
+	 */
+	std::uint32_t get_coverage_memory_per_client() const;
+
+	/**
+	 * @brief Get the number of sections AOG divides the implement in
+	 * @return The number of sections, 0 if AOG's sections map one-to-one on the implement's sections
+	 */
+	std::uint8_t get_number_of_virtual_sections() const;
+
+	/**
+	 * @brief Get the prescription map to use for variable rate application
+	 * @return The path to the prescription map, empty if rates are not controlled by the TC
+	 */
+	const std::string &get_prescription_map_path() const;
+
+	/**
+	 * @brief Get the local TCP port the metrics are served on
+	 * @return The port, 0 if the metrics are not served
+	 */
+	std::uint16_t get_metrics_port() const;
+
+	/**
+	 * @brief Get the local TCP port the dashboard is served on
+	 * @return The port, 0 if the dashboard is not served
+	 */
+	std::uint16_t get_dashboard_port() const;
+
+	/**
+	 * @brief Get the maximum number of dashboard updates per second
+	 * @return The frame rate
+	 */
+	std::uint8_t get_dashboard_frame_rate() const;
+
 private:
 	constexpr static std::array<std::uint8_t, 3> DEFAULT_SUBNET = { 192, 168, 5 };
 	std::array<std::uint8_t, 3> configuredSubnet = DEFAULT_SUBNET;
+	std::uint32_t sectionLookAheadOn_ms = 0; ///< The look-ahead for turning sections on
+	std::uint32_t sectionLookAheadOff_ms = 0; ///< The look-ahead for turning sections off
+	bool coverageSectionControl = false; ///< Whether the TC turns off sections over covered area
+	std::uint32_t coverageMemoryPerClient_MB = 32; ///< The memory limit of the coverage map of each implement
+	std::uint8_t numberOfVirtualSections = 0; ///< The number of sections AOG controls, mapped onto the physical sections
+	std::string prescriptionMapPath; ///< The prescription map for variable rate application
+	std::uint16_t metricsPort = 9464; ///< The local port of the Prometheus metrics endpoint, 0 to disable it
+	std::uint16_t dashboardPort = 9465; ///< The local port of the dashboard, 0 to disable it
+	std::uint8_t dashboardFrameRate = 10; ///< The maximum number of dashboard updates per second
 };
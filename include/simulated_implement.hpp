@@ -0,0 +1,130 @@
+/**
+ * @author Daan Steenbergen
+ * @brief A synthetic implement ECU that connects to the task controller as a TC client
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright 2026 Daan Steenbergen
+ */
+
+#pragma once
+
+#include "isobus/isobus/isobus_device_descriptor_object_pool.hpp"
+#include "isobus/isobus/isobus_task_controller_client.hpp"
+
+#include "app_clock.hpp"
+#include "section_mask.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/// @brief An implement with a generated DDOP, for testing the task controller without hardware
+/// @details The DDOP has a device element with the section control and work states, a function element per
+/// boom with the condensed work states, optional nested function elements and a section element per section.
+/// Setpoints are applied as actual states after the configured latency, which is also announced in the DDOP.
+class SimulatedImplement
+{
+public:
+	using Clock = AppClock;
+
+	/// @brief The shape and behaviour of a simulated implement
+	struct Configuration
+	{
+		std::uint8_t numberOfBooms = 1;
+		std::uint8_t numberOfSectionsPerBoom = 8;
+		std::uint8_t elementDepth = 1; ///< Function elements from the device element down to the sections, the TC understands the geometry of 1 and 2
+		std::uint16_t sectionWidth_mm = 3000;
+		std::chrono::milliseconds latency{ 100 }; ///< From a setpoint to the matching actual state
+	};
+
+	/**
+	 * @brief Constructor
+	 * @param identityNumber Makes the NAME of every simulated implement unique
+	 * @param configuration The shape and behaviour of the implement
+	 */
+	SimulatedImplement(std::uint32_t identityNumber, const Configuration &configuration);
+	~SimulatedImplement();
+	SimulatedImplement(const SimulatedImplement &) = delete;
+	SimulatedImplement &operator=(const SimulatedImplement &) = delete;
+
+	/**
+	 * @brief Claim an address and start connecting to the task controller
+	 * @param canPort The CAN channel the implement is on, not the one of the task controller
+	 * @return True if the DDOP was generated and the client started, false otherwise
+	 */
+	bool initialize(std::uint8_t canPort);
+
+	/**
+	 * @brief Generate the DDOP without connecting, e.g. to benchmark how the task controller handles it
+	 * @param clientName The NAME to put in the device object
+	 * @param binaryPool Set to the binary DDOP
+	 * @return True if the DDOP was generated, false otherwise
+	 */
+	bool generate_binary_pool(std::uint64_t clientName, std::vector<std::uint8_t> &binaryPool);
+
+	/// @brief Apply the setpoints that are due and run the TC client, call this every loop
+	void update();
+
+	/// @brief Disconnect from the task controller
+	void terminate();
+
+	bool is_connected() const;
+	std::uint16_t get_number_of_sections() const;
+	std::size_t get_pool_size() const; ///< The size of the binary DDOP in bytes
+	std::uint32_t get_number_of_set_values() const; ///< Set values received from the task controller
+
+	/**
+	 * @brief Get the actual section states, in the order AOG numbers them
+	 * @return The sections that are on
+	 */
+	SectionMask get_actual_states() const;
+
+	/**
+	 * @brief Get the time at which the next setpoint becomes an actual state, for advancing virtual time
+	 * @return The due time, or Clock::time_point::max() if nothing is pending
+	 */
+	Clock::time_point get_next_due_time() const;
+
+private:
+	/// @brief A setpoint that becomes the actual state after the latency
+	struct PendingState
+	{
+		Clock::time_point dueTime;
+		std::uint16_t section;
+		bool isOn;
+	};
+
+	/// @brief The elements of one boom
+	struct Boom
+	{
+		std::uint16_t elementNumber;
+		std::uint16_t firstSection;
+	};
+
+	bool generate_pool(std::uint64_t clientName);
+	const Boom *get_boom(std::uint16_t elementNumber) const;
+	static bool on_request_value(std::uint16_t elementNumber, std::uint16_t ddi, std::int32_t &value, void *parent);
+	static bool on_value_command(std::uint16_t elementNumber, std::uint16_t ddi, std::int32_t value, void *parent);
+
+	const std::uint32_t identityNumber;
+	const Configuration configuration;
+	std::shared_ptr<isobus::DeviceDescriptorObjectPool> pool;
+	std::size_t poolSize = 0;
+	std::unique_ptr<isobus::TaskControllerClient> client;
+	std::vector<Boom> booms;
+	static constexpr std::uint16_t DEVICE_ELEMENT_NUMBER = 0;
+
+	mutable std::mutex mutex; ///< The client may call back from the CAN stack's thread
+	std::deque<PendingState> pendingStates; ///< In order of due time, the latency is the same for all sections
+	SectionMask actualStates;
+	bool isSectionControlEnabled = false;
+	bool isWorking = false;
+	bool isWorkStatePending = false;
+	bool pendingWorkState = false;
+	Clock::time_point workStateDueTime;
+	std::uint32_t numberOfSetValues = 0;
+};
@@ -14,11 +14,29 @@
 #include "isobus/isobus/isobus_standard_data_description_indices.hpp"
 #include "isobus/isobus/isobus_task_controller_server.hpp"
 
+#include "as_applied_log.hpp"
+#include "coverage_map.hpp"
+#include "event_journal.hpp"
+#include "prescription_map.hpp"
+#include "process_data_history.hpp"
+#include "section_latency_profiler.hpp"
+#include "section_mapping.hpp"
+#include "section_mask.hpp"
+#include "section_scheduler.hpp"
+#include "task_data_writer.hpp"
+#include "task_totals.hpp"
+#include "work_statistics.hpp"
+
+#include <chrono>
 #include <cstdint>
+#include <functional>
 #include <map>
 #include <queue>
 
 constexpr std::uint8_t NUMBER_SECTIONS_PER_CONDENSED_MESSAGE = 16;
+constexpr std::uint8_t MAX_NUMBER_OF_BOOMS = 16; ///< Advertised to clients, each boom has its own condensed work states
+constexpr std::uint8_t MAX_NUMBER_OF_SECTIONS_TOTAL = 255; ///< Advertised to clients, the total over all booms
+constexpr std::uint8_t MAX_NUMBER_OF_AOG_SECTIONS = 16; ///< The steer data PGN (0xFE) carries the states of 16 sections
 
 enum SectionState : std::uint8_t
 {
@@ -28,6 +46,35 @@ enum SectionState : std::uint8_t
 	NOT_INSTALLED = 3 ///< Section is not installed
 };
 
+/// @brief The section control state of a single boom of an implement
+struct BoomState
+{
+	std::uint16_t elementNumber = 0; ///< The device element of the boom
+	std::uint8_t firstSection = 0; ///< The client-wide index of the boom's first section
+	std::uint8_t numberOfSections = 0; ///< The number of sections on this boom, including its sub-booms
+	std::uint16_t aogSectionOffset = 0; ///< The AOG section that drives the boom's first section
+	std::map<std::uint16_t, std::uint16_t> condensedElementNumbers; ///< Condensed work state DDI to the element that carries it on this boom
+	std::uint16_t pendingGroups = 0; ///< Condensed groups with setpoint changes that still have to be sent
+};
+
+/// @brief An element that accepts the setpoint rate of the prescription map, and the sections it applies to
+struct RateControlTarget
+{
+	std::uint16_t elementNumber = 0; ///< The element that has the setpoint rate DDI
+	std::uint8_t firstSection = 0; ///< The first section the element applies to
+	std::uint8_t numberOfSections = 0; ///< The number of sections the element applies to
+	std::int32_t lastSentRate = PrescriptionMap::NO_RATE; ///< The rate last sent to the element
+};
+
+/// @brief The measurement triggers the TC requested for a DDI of an element
+struct MeasurementSubscription
+{
+	std::uint16_t ddi = 0;
+	std::uint16_t elementNumber = 0;
+	std::uint32_t timeInterval_ms = 0; ///< 0 if not triggered by time
+	bool isOnChange = false;
+};
+
 class ClientState
 {
 public:
@@ -37,6 +84,8 @@ public:
 	std::uint8_t get_number_of_sections() const;
 	std::uint8_t get_section_setpoint_state(std::uint8_t section) const;
 	std::uint8_t get_section_actual_state(std::uint8_t section) const;
+	const SectionMask &get_section_actual_states() const; ///< Sections that are actually on, including the element hierarchy, as of the last update_actual_states
+	void update_actual_states(); ///< Resolves the element hierarchy of the reported actual states, call after every work state report
 	std::uint16_t get_element_number_for_section(std::uint8_t section) const;
 	void set_element_number_for_section(std::uint8_t section, std::uint16_t elementNumber);
 	bool is_any_section_setpoint_on() const;
@@ -56,8 +105,39 @@ public:
 	// Element work state management these act like master / override for actual sections
 	void set_element_work_state(std::uint16_t elementNumber, bool isWorking);
 	bool try_get_element_work_state(std::uint16_t elementNumber, bool &isWorking) const;
+	SectionScheduler &get_section_scheduler();
+	const SectionScheduler &get_section_scheduler() const;
+	CoverageMap &get_coverage_map();
+	const CoverageMap &get_coverage_map() const;
+	VirtualSectionMapping &get_section_mapping();
+	const VirtualSectionMapping &get_section_mapping() const;
+	WorkStatistics &get_work_statistics();
+	SectionLatencyProfiler &get_latency_profiler();
+	const SectionLatencyProfiler &get_latency_profiler() const;
+	const WorkStatistics &get_work_statistics() const;
+	void add_boom(const BoomState &boom, const std::vector<std::uint16_t> &elementNumbers); ///< The element numbers are those of the boom and everything below it
+	std::vector<BoomState> &get_booms();
+	std::uint8_t get_boom_index_for_element(std::uint16_t elementNumber) const;
+	std::uint8_t get_boom_index_for_section(std::uint8_t section) const;
+	void set_element_number_for_boom_ddi(std::uint16_t ddi, std::uint16_t elementNumber); ///< Assigns a condensed work state DDI to the boom that owns the element
+	void mark_section_setpoint_changed(std::uint8_t section);
+	SectionMask map_aog_section_states(const SectionMask &aogStates) const; ///< Converts AOG's section states to this client's sections
+	SectionMask get_aog_section_actual_states() const; ///< The actual states in terms of AOG's sections
+	std::uint8_t get_number_of_aog_sections() const;
+	bool get_condensed_group_sections(std::uint16_t elementNumber, std::uint8_t group, std::uint8_t &firstSection, std::uint8_t &numberOfSections) const; ///< Resolves a condensed DDI group of an element to the sections it addresses
+	bool set_section_override_state(std::uint8_t section, bool overridden); ///< Returns true if the override state changed
+	bool is_section_overridden(std::uint8_t section) const;
+	SectionMask get_aog_section_override_states() const; ///< The overridden sections in terms of AOG's sections
+	SectionMask take_section_request_changes(const SectionMask &requestedStates); ///< Stores the request and returns the sections that differ from the previous one
+	void invalidate_section_request(); ///< Makes the next request re-evaluate all sections
+	void add_rate_control_target(const RateControlTarget &target);
+	std::vector<RateControlTarget> &get_rate_control_targets();
+	void add_measurement_subscription(std::uint16_t ddi, std::uint16_t elementNumber, std::uint32_t timeInterval_ms, bool isOnChange); ///< Merges with an existing subscription of the same DDI and element
+	const std::vector<MeasurementSubscription> &get_measurement_subscriptions() const;
 
 private:
+	SectionMask to_aog_sections(const SectionMask &sections) const;
+
 	isobus::DeviceDescriptorObjectPool pool; ///< The device descriptor object pool (DDOP) for the TC
 	bool areMeasurementCommandsSent = false; ///< Whether or not the measurement commands have been sent
 	std::map<isobus::DataDescriptionIndex, std::uint16_t> ddiToElementNumber; ///< Mapping of DDI to element number // TODO: better way to do this?
@@ -66,16 +146,34 @@ private:
 	std::vector<std::uint8_t> sectionSetpointStates; // 2 bits per section (0 = off, 1 = on, 2 = error, 3 = not installed)
 	std::vector<std::uint8_t> sectionActualStates; // 2 bits per section (0 = off, 1 = on, 2 = error, 3 = not installed)
 	std::vector<std::uint16_t> sectionToElementNumber; // Maps section index to element number for hierarchy checking
+	SectionMask effectiveActualStates; ///< Sections that are on and whose elements are all working, see update_actual_states
+	SectionMask sectionsOffByElement; ///< Sections whose element or one of its parents is not working
 	bool setpointWorkState = false; ///< The overall work state desired (DDI 289)
 	bool actualWorkState = false; ///< The overall work state actual
 	std::map<std::uint16_t, bool> elementWorkStates; ///< Work state per element (element number -> is working)
 	bool isSectionControlEnabled = false; ///< Stores auto vs manual mode setting
+	SectionScheduler sectionScheduler; ///< Delays setpoint changes to compensate the section latencies
+	CoverageMap coverageMap; ///< The area worked by this implement, for position based section control
+	VirtualSectionMapping sectionMapping; ///< Maps AOG's sections onto the physical sections
+	WorkStatistics workStatistics; ///< Working width and area based on the actual section states
+	SectionLatencyProfiler latencyProfiler; ///< Measures how fast the sections follow their setpoints
+	std::vector<BoomState> booms; ///< The booms in the order of the section indices
+	std::vector<std::uint8_t> sectionToBoomIndex; ///< Maps section index to the boom it is on
+	std::map<std::uint16_t, std::uint8_t> elementToBoomIndex; ///< Maps every element on a boom to that boom
+	std::uint16_t numberOfAogSections = 0; ///< The number of AOG sections that drive this client, without a virtual mapping
+	SectionMask sectionOverrideStates; ///< Sections the operator has taken over on the implement
+	SectionMask lastSectionRequest; ///< The requested states of this client's sections, as last evaluated
+	bool isSectionRequestValid = false; ///< Whether the setpoints still follow the last evaluated request
+	std::vector<RateControlTarget> rateControlTargets; ///< Elements that receive the prescribed rate
+	std::vector<MeasurementSubscription> measurementSubscriptions; ///< The measurement commands sent to the client
 };
 
 // Create the task controller server object, this will handle all the ISOBUS communication for us
 class MyTCServer : public isobus::TaskControllerServer
 {
 public:
+	using SectionStatusCallback = std::function<void(ClientState &)>;
+
 	MyTCServer(std::shared_ptr<isobus::InternalControlFunction> internalControlFunction);
 	bool activate_object_pool(std::shared_ptr<isobus::ControlFunction> partnerCF, ObjectPoolActivationError &, ObjectPoolErrorCodes &, std::uint16_t &, std::uint16_t &) override;
 	bool change_designator(std::shared_ptr<isobus::ControlFunction>, std::uint16_t, const std::vector<std::uint8_t> &) override;
@@ -95,14 +193,53 @@ public:
 	bool store_device_descriptor_object_pool(std::shared_ptr<isobus::ControlFunction> partnerCF, const std::vector<std::uint8_t> &binaryPool, bool appendToPool) override;
 	std::map<std::shared_ptr<isobus::ControlFunction>, ClientState> &get_clients();
 	void request_measurement_commands();
-	void update_section_states(std::vector<bool> &sectionStates);
+	void update_section_states(const SectionMask &sectionStates);
 	void update_section_control_enabled(bool enabled);
+	void update_speed(std::int32_t speed_mm_per_s);
+	void set_section_look_ahead(std::uint32_t onLookAhead_ms, std::uint32_t offLookAhead_ms);
+	void update_scheduled_section_states(); ///< Sends the scheduled changes that are due
+	SectionScheduler::Clock::time_point get_next_scheduled_section_time() const; ///< The earliest due change of all clients, max if there is none
+	void update_position(double latitude, double longitude, double heading_deg);
+	void set_coverage_section_control(bool enabled);
+	void set_coverage_memory_per_client(std::uint32_t megabytes); ///< Applies to the clients that connect afterwards
+	void set_number_of_virtual_sections(std::uint8_t number); ///< 0 maps AOG's sections one-to-one
+	void set_section_status_callback(SectionStatusCallback callback); ///< Called when a client's section status has to be reported right away
+	bool load_prescription_map(const std::string &path); ///< Should be loaded before clients connect
+	TaskTotals &get_task_totals();
+	TaskDataWriter &get_task_data_writer();
+	AsAppliedLog &get_as_applied_log();
+	const ProcessDataHistory &get_process_data_history() const;
+	EventJournal &get_event_journal();
 
 private:
-	void send_section_setpoint_states(std::shared_ptr<isobus::ControlFunction> client, std::uint8_t ddiOffset);
+	void apply_due_section_changes(ClientState &state, SectionScheduler::Clock::time_point now);
+	void send_pending_section_setpoint_states(std::shared_ptr<isobus::ControlFunction> client); ///< Sends the changed condensed groups of all booms
+	void send_section_setpoint_states(std::shared_ptr<isobus::ControlFunction> client, std::uint8_t boomIndex, std::uint8_t ddiOffset);
 	void send_section_control_state(std::shared_ptr<isobus::ControlFunction> client, bool enabled);
 	bool is_ddi_settable(std::shared_ptr<isobus::ControlFunction> client, std::uint16_t ddi);
+	bool send_set_value(std::shared_ptr<isobus::ControlFunction> client, std::uint16_t dataDescriptionIndex, std::uint16_t elementNumber, std::int32_t processDataValue) const; ///< Counts the set values in the metrics
+	void request_total_measurement_commands(std::shared_ptr<isobus::ControlFunction> client, ClientState &state);
+	void update_rates(double latitude, double longitude, double heading_deg, double lookAhead_m);
+	void add_rate_control_targets(ClientState &state, const std::map<std::uint16_t, std::pair<std::uint8_t, std::uint8_t>> &elementSections);
+	static std::uint32_t get_section_latency(isobus::DeviceDescriptorObjectPool &pool, std::uint16_t elementNumber); ///< Searches the element and its parents for a setpoint latency
 
 	std::map<std::shared_ptr<isobus::ControlFunction>, ClientState> clients;
 	std::map<std::shared_ptr<isobus::ControlFunction>, std::queue<std::vector<std::uint8_t>>> uploadedPools;
+	std::uint32_t sectionLookAheadOn_ms = 0; ///< The look-ahead AOG applies when turning sections on
+	std::uint32_t sectionLookAheadOff_ms = 0; ///< The look-ahead AOG applies when turning sections off
+	std::vector<SectionScheduler::SectionChange> dueSectionChanges; ///< Reused buffer for changes popped from the schedulers
+	SectionMask requestedSectionStates; ///< The section states last requested by AOG
+	bool hasRequestedSectionStates = false; ///< Whether AOG requested any section states yet
+	std::uint8_t numberOfVirtualSections = 0; ///< The number of sections AOG divides the implement in
+	std::int32_t speed_mm_per_s = 0; ///< The absolute speed last received from AOG
+	bool isCoverageSectionControlEnabled = false; ///< Whether or not sections over covered area are turned off by the TC
+	std::size_t coverageMaxTilesPerClient = CoverageMap::DEFAULT_MAX_TILES; ///< The tile cap of each client's coverage map
+	SectionStatusCallback sectionStatusCallback; ///< Reports section status changes without waiting for the next heartbeat
+	PrescriptionMap prescriptionMap; ///< The rates for variable rate application
+	std::vector<std::int32_t> sectionRates; ///< Reused buffer for the prescribed rate of each section
+	TaskTotals taskTotals; ///< The totals reported by all clients, per task
+	TaskDataWriter taskDataWriter; ///< Records the position and process data of the current task
+	AsAppliedLog asAppliedLog; ///< Records the section states and rates of every client, for the whole season
+	ProcessDataHistory processDataHistory; ///< The recent history of every value the clients report
+	EventJournal eventJournal; ///< Records connections, section changes and errors of the clients
 };
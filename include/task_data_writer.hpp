@@ -0,0 +1,153 @@
+/**
+ * @author Daan Steenbergen
+ * @brief Records an ISO 11783-10 TASKDATA set with binary time logs
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright 2026 Daan Steenbergen
+ */
+
+#pragma once
+
+#include "isobus/isobus/isobus_device_descriptor_object_pool.hpp"
+
+#include <array>
+#include <atomic>
+#include <bitset>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/// @brief Writes the position and process data of a task as an ISO 11783-10 time log
+/// @details Every position update appends one fixed-layout binary record, holding the position and the
+/// process data values that changed since the previous record, to a pre-allocated buffer. A background
+/// thread writes full buffers to the TLG binary file, so the main loop never waits for the disk. The XML
+/// files that describe the devices and the record layout are only written when the task is finished.
+class TaskDataWriter
+{
+public:
+	static constexpr std::size_t BUFFER_SIZE = 64 * 1024; ///< Size of each of the two record buffers
+	static constexpr std::size_t MAX_NUMBER_OF_VALUES = 255; ///< The DLV index in a record is a single byte
+	static constexpr std::size_t MAX_RECORD_SIZE = 6 + 9 + 1 + MAX_NUMBER_OF_VALUES * 5; ///< Time, position, and all values
+
+	TaskDataWriter() = default;
+	~TaskDataWriter();
+	TaskDataWriter(const TaskDataWriter &) = delete;
+	TaskDataWriter &operator=(const TaskDataWriter &) = delete;
+
+	/**
+	 * @brief Start recording a task, the values of the clients that are still connected carry over
+	 * @param directory The directory to write TASKDATA.XML and the time log to, must exist
+	 * @param taskDesignator The name of the task as shown in the farm management software
+	 * @return True if recording started, false otherwise
+	 */
+	bool start(const std::string &directory, const std::string &taskDesignator);
+
+	/// @brief Finish the task, write the remaining records and the XML files
+	void stop();
+
+	/**
+	 * @brief Check whether a task is being recorded
+	 * @return True if recording, false otherwise
+	 */
+	bool is_recording() const;
+
+	/**
+	 * @brief Describe a client device, its elements are referenced by the recorded values
+	 * @param clientName The full ISO NAME of the client
+	 * @param pool The device descriptor object pool of the client
+	 */
+	void add_device(std::uint64_t clientName, isobus::DeviceDescriptorObjectPool &pool);
+
+	/**
+	 * @brief Forget a client device once the next task starts, the current task may still reference it
+	 * @param clientName The full ISO NAME of the client
+	 */
+	void remove_device(std::uint64_t clientName);
+
+	/**
+	 * @brief Update a process data value, it is written with the next position
+	 * @details Values of elements that aren't in a described device are ignored, the time log can't reference them.
+	 * @param clientName The full ISO NAME of the client
+	 * @param elementNumber The element the value belongs to
+	 * @param ddi The DDI of the value
+	 * @param value The value
+	 */
+	void set_value(std::uint64_t clientName, std::uint16_t elementNumber, std::uint16_t ddi, std::int32_t value);
+
+	/**
+	 * @brief Append a record with the position and the changed values
+	 * @param latitude The latitude, in degrees
+	 * @param longitude The longitude, in degrees
+	 */
+	void add_position(double latitude, double longitude);
+
+	/**
+	 * @brief Get the number of records that were dropped because the disk could not keep up
+	 * @return The number of dropped records
+	 */
+	std::uint32_t get_number_of_dropped_records() const;
+
+private:
+	/// @brief A logged value, a DLV in the time log header
+	struct LoggedValue
+	{
+		std::uint64_t clientName;
+		std::uint16_t elementNumber;
+		std::uint16_t ddi;
+	};
+
+	/// @brief An element of a described device
+	struct ElementDescription
+	{
+		std::uint16_t objectId;
+		std::uint16_t elementNumber;
+		std::uint16_t parentObjectId;
+		std::uint8_t type;
+		std::string designator;
+	};
+
+	/// @brief A described client device
+	struct DeviceDescription
+	{
+		std::uint64_t clientName;
+		std::string designator;
+		std::string softwareVersion;
+		std::string serialNumber;
+		std::string structureLabel; ///< Hexadecimal
+		std::string localizationLabel; ///< Hexadecimal
+		std::vector<ElementDescription> elements;
+		bool isConnected = true; ///< Removed devices are only dropped when the next task starts
+	};
+
+	void flush_thread();
+	void write_xml_files();
+	std::string get_element_id(std::uint64_t clientName, std::uint16_t elementNumber) const;
+	bool is_element_described(std::uint64_t clientName, std::uint16_t elementNumber) const;
+	std::uint8_t add_logged_value(const LoggedValue &value); ///< Returns the DLV index, the caller checks the limit
+
+	std::string outputDirectory;
+	std::string taskName;
+	std::ofstream binaryFile;
+	std::thread flushThread;
+	std::mutex bufferMutex;
+	std::condition_variable flushCondition;
+	std::array<std::vector<std::uint8_t>, 2> buffers; ///< Filled alternately, capacity is reserved once
+	std::size_t activeBuffer = 0; ///< The buffer records are appended to
+	bool isFlushRequested = false; ///< Whether the other buffer is full and waiting to be written
+	bool isStopRequested = false;
+	std::atomic<bool> isRecording = false;
+	std::atomic<std::uint32_t> numberOfDroppedRecords = 0;
+
+	std::vector<LoggedValue> loggedValues; ///< The DLVs, in index order
+	std::unordered_map<std::uint64_t, std::unordered_map<std::uint32_t, std::uint8_t>> valueIndices; ///< Client NAME, then element and DDI, to DLV index
+	std::array<std::int32_t, MAX_NUMBER_OF_VALUES> currentValues = {};
+	std::bitset<MAX_NUMBER_OF_VALUES> changedValues; ///< The values that changed since the last record
+	std::vector<DeviceDescription> devices;
+	std::array<std::uint8_t, MAX_RECORD_SIZE> record = {}; ///< Scratch space to assemble a record
+};
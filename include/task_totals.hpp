@@ -0,0 +1,127 @@
+/**
+ * @author Daan Steenbergen
+ * @brief Accumulates the totals reported by the implements per task
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright 2026 Daan Steenbergen
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/// @brief Keeps the totals (area, volume, mass, time, ...) of every client element per task
+/// @details Implements report their totals as a running value that they may reset at any time, so only the
+/// increase since the previous report is added to the current task. Values are kept as 64-bit integers in
+/// the resolution of the DDI, so nothing is lost to rounding no matter how long a task runs. Every total is
+/// found through a hash of the client, element and DDI, so a report costs a single lookup.
+class TaskTotals
+{
+public:
+	/// @brief A single total of an element
+	struct Total
+	{
+		std::uint64_t clientName = 0; ///< The full ISO NAME of the client
+		std::uint16_t elementNumber = 0; ///< The element the total belongs to
+		std::uint16_t ddi = 0; ///< The DDI of the total
+		std::int64_t value = 0; ///< The accumulated value, in the resolution of the DDI
+	};
+
+	static constexpr std::uint32_t CHECKPOINT_MAGIC = 0x54544F54; ///< "TOTT", marks a checkpoint file
+	static constexpr std::uint16_t CHECKPOINT_VERSION = 1;
+
+	/**
+	 * @brief Check whether a DDI is an accumulated total according to the data dictionary
+	 * @param ddi The DDI to check
+	 * @return True if the DDI is a total, false otherwise
+	 */
+	static bool is_total_ddi(std::uint16_t ddi);
+
+	/**
+	 * @brief Register a total that the client will report
+	 * @param clientName The full ISO NAME of the client
+	 * @param elementNumber The element that reports the total
+	 * @param ddi The DDI of the total
+	 */
+	void add_total(std::uint64_t clientName, std::uint16_t elementNumber, std::uint16_t ddi);
+
+	/**
+	 * @brief Process a reported total
+	 * @param clientName The full ISO NAME of the client
+	 * @param elementNumber The element that reported the total
+	 * @param ddi The DDI of the total
+	 * @param reportedValue The value as reported by the client
+	 * @return True if the value was for a registered total, false otherwise
+	 */
+	bool update(std::uint64_t clientName, std::uint16_t elementNumber, std::uint16_t ddi, std::int32_t reportedValue);
+
+	/**
+	 * @brief Start accumulating into another task, the totals of the previous task are kept
+	 * @param taskId The identifier of the task, chosen by AOG
+	 */
+	void start_task(std::uint32_t taskId);
+
+	/**
+	 * @brief Get the task that is being accumulated into
+	 * @return The identifier of the current task
+	 */
+	std::uint32_t get_current_task() const;
+
+	/**
+	 * @brief Get the totals of a task
+	 * @param taskId The identifier of the task
+	 * @return The totals, empty if the task is unknown
+	 */
+	const std::vector<Total> &get_totals(std::uint32_t taskId) const;
+
+	/**
+	 * @brief Write all tasks to a file, if anything changed since the last checkpoint
+	 * @param path The file to write
+	 * @return True if the file is up to date, false if writing failed
+	 */
+	bool save_checkpoint(const std::string &path);
+
+	/**
+	 * @brief Restore the tasks from a file
+	 * @param path The file to read
+	 * @return True if the checkpoint was restored, false otherwise
+	 */
+	bool load_checkpoint(const std::string &path);
+
+private:
+	/// @brief Identifies a total across tasks
+	struct Key
+	{
+		std::uint64_t clientName;
+		std::uint32_t elementAndDdi; ///< Element number in the upper half, DDI in the lower half
+
+		bool operator==(const Key &other) const = default;
+	};
+
+	/// @brief Hashes a key for the lookup tables
+	struct KeyHash
+	{
+		std::size_t operator()(const Key &key) const;
+	};
+
+	/// @brief The last reported value of a total, to calculate the increase
+	struct ReportState
+	{
+		std::int32_t lastValue = 0;
+		bool hasLastValue = false;
+		std::uint32_t indexInTask = 0; ///< Index of the total in the current task's vector
+	};
+
+	void build_task_index();
+
+	std::map<std::uint32_t, std::vector<Total>> tasks; ///< The totals of every task
+	std::vector<Total> *currentTotals = nullptr; ///< The totals of the current task, map nodes never move
+	std::unordered_map<Key, ReportState, KeyHash> reportStates; ///< Every registered total
+	std::uint32_t currentTask = 0;
+	bool isDirty = false; ///< Whether anything changed since the last checkpoint
+};
@@ -0,0 +1,115 @@
+/**
+ * @author Daan Steenbergen
+ * @brief Records the traffic with AgIO and on the CAN bus, to replay it later
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright 2026 Daan Steenbergen
+ */
+
+#pragma once
+
+#include "app_clock.hpp"
+
+#include "isobus/isobus/can_message_frame.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <span>
+#include <string>
+#include <vector>
+
+/// @brief Writes every datagram of AgIO and every CAN frame of the task controller's channel to a file
+/// @details The file starts with the magic "TCTR", a 16 bit version, two reserved bytes and the calendar time of
+/// the start in microseconds since 1970, which a replay continues from. Every record is a
+/// type byte, the time since the previous record in microseconds as a varint and the payload. A datagram is its
+/// length as a varint and its bytes, a CAN frame is the 32 bit identifier with bit 31 set for extended
+/// identifiers, the data length byte and the data. Multi-byte values are little endian, and a varint holds 7 bits
+/// per byte with the highest bit set on all but the last byte. Time is taken from the AppClock, so a recording made
+/// during a time-warped replay has the same timeline as the original.
+class TrafficRecorder
+{
+public:
+	static constexpr std::array<char, 4> MAGIC = { 'T', 'C', 'T', 'R' };
+
+	/// @brief The types of records, the values are part of the file format
+	enum class RecordType : std::uint8_t
+	{
+		DatagramReceived = 1, ///< From AgIO
+		DatagramSent = 2, ///< To AgIO
+		CanFrameReceived = 3,
+		CanFrameSent = 4
+	};
+
+	/// @brief A record read back from a file
+	struct Record
+	{
+		RecordType type;
+		std::uint64_t time_us; ///< Since the start of the recording
+		std::uint32_t identifier = 0; ///< CAN frames only
+		bool isExtendedFrame = false; ///< CAN frames only
+		std::vector<std::uint8_t> data;
+	};
+
+	TrafficRecorder() = default;
+	~TrafficRecorder();
+	TrafficRecorder(const TrafficRecorder &) = delete;
+	TrafficRecorder &operator=(const TrafficRecorder &) = delete;
+
+	/**
+	 * @brief Start a recording, an existing file is replaced
+	 * @param path The file to write
+	 * @return True if the file was opened, false otherwise
+	 */
+	bool open(const std::string &path);
+
+	/// @brief Finish the recording
+	void close();
+
+	bool is_open() const;
+
+	/// @brief Write the buffered records to the file, e.g. once per second
+	void flush();
+
+	/**
+	 * @brief Record a datagram, does nothing if the recorder isn't open
+	 * @param isReceived True if it came from AgIO, false if it was sent to AgIO
+	 * @param datagram The complete datagram
+	 */
+	void record_datagram(bool isReceived, std::span<const std::uint8_t> datagram);
+
+	/**
+	 * @brief Record a CAN frame, does nothing if the recorder isn't open, safe to call from the CAN stack's threads
+	 * @param isReceived True if it came from the bus, false if the task controller sent it
+	 * @param frame The frame
+	 */
+	void record_can_frame(bool isReceived, const isobus::CANMessageFrame &frame);
+
+	/**
+	 * @brief Read a recording
+	 * @param path The file to read
+	 * @param records Set to the records in the file, in the order they were recorded
+	 * @return True if the file was read, false if it isn't a recording or ends in a partial record
+	 */
+	static bool read(const std::string &path, std::vector<Record> &records);
+
+	/**
+	 * @brief Read a recording and the calendar time it started at
+	 * @param path The file to read
+	 * @param records Set to the records in the file, in the order they were recorded
+	 * @param startTime Set to the calendar time of the first record's time base
+	 * @return True if the file was read, false if it isn't a recording or ends in a partial record
+	 */
+	static bool read(const std::string &path, std::vector<Record> &records, std::chrono::system_clock::time_point &startTime);
+
+private:
+	void write_record(RecordType type, const std::uint8_t *payload, std::size_t payloadSize);
+
+	mutable std::mutex mutex; ///< CAN frames are recorded from the CAN stack's threads
+	std::ofstream file;
+	AppClock::time_point startTime;
+	std::uint64_t lastRecordTime_us = 0; ///< Since the start, the deltas are taken from this so they don't drift
+};
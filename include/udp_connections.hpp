@@ -9,17 +9,22 @@
 
 #pragma once
 
+#include <array>
 #include <boost/asio.hpp>
 #include <span>
+#include "aog_packet_parser.hpp"
 #include "settings.hpp"
 
 using boost::asio::ip::udp;
 
-/// @brief A callback interface for handling incoming packets
-/// @param src The source of the packet
-/// @param pgn The PGN of the packet
-/// @param data The data of the packet
-using PacketCallback = std::function<void(std::uint8_t src, std::uint8_t pgn, std::span<std::uint8_t> data)>;
+/// @brief A callback for when AgIO changes the subnet
+/// @param subnet The new subnet
+using SubnetCallback = std::function<void(const std::array<std::uint8_t, 3> &subnet)>;
+
+/// @brief A callback for every datagram that is received from or sent to AgIO, e.g. to record the traffic
+/// @param isReceived True for a received datagram, false for a sent one
+/// @param datagram The complete datagram
+using DatagramCallback = std::function<void(bool isReceived, std::span<const std::uint8_t> datagram)>;
 
 /// @brief UDP connections to communicate with AgOpenGPS
 class UdpConnections
@@ -38,6 +43,18 @@ public:
       */
 	void set_packet_handler(PacketCallback packetCallback);
 
+	/**
+      * @brief Set subnet handler
+      * @param subnetCallback The callback to use when AgIO changes the subnet
+      */
+	void set_subnet_handler(SubnetCallback subnetCallback);
+
+	/**
+      * @brief Set datagram handler
+      * @param datagramCallback The callback to use for every received and sent datagram, including those of the address detection
+      */
+	void set_datagram_handler(DatagramCallback datagramCallback);
+
 	/**
      * @brief Open the UDP connections
      * @param endpoint The endpoint to open the connection on
@@ -55,6 +72,12 @@ public:
      */
 	void handle_incoming_packets();
 
+	/**
+     * @brief Handle a datagram as if it was received from AgIO, e.g. to replay recorded traffic
+     * @param datagram The datagram
+     */
+	void handle_datagram(std::span<const std::uint8_t> datagram);
+
 	/**
      * @brief Handle address detection
      */
@@ -70,8 +93,8 @@ public:
 	bool send(std::uint8_t src, std::uint8_t pgn, std::span<std::uint8_t> data);
 
 private:
-	static const std::size_t MAX_PACKET_SIZE = 512; // Mostly arbitrary, but should be large enough to hold any packet
-	static const std::uint16_t PACKET_START = 0x8081; // Start of packet
+	static const std::size_t MAX_PACKET_SIZE = AogPacketParser::MAX_PACKET_SIZE;
+	static const std::uint16_t PACKET_START = AogPacketParser::PACKET_START;
 
 	/**
      * @brief Get the local endpoint
@@ -79,14 +102,9 @@ private:
      */
 	udp::endpoint get_local_endpoint() const;
 
-	/**
-      * @brief Calculate CRC for data
-      * @param data The data to calculate the CRC for
-      * @return The calculated CRC
-      */
-	std::uint8_t calculate_crc(std::span<std::uint8_t> data);
-
-	PacketCallback packetCallback = nullptr;
+	AogPacketParser packetParser;
+	SubnetCallback subnetCallback = nullptr;
+	DatagramCallback datagramCallback = nullptr;
 	std::shared_ptr<Settings> settings;
 	udp::socket udpConnection;
 	udp::socket udpConnectionAddressDetection;
@@ -0,0 +1,83 @@
+/**
+ * @author Daan Steenbergen
+ * @brief Live work rate statistics based on the actual section states
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright 2026 Daan Steenbergen
+ */
+
+#pragma once
+
+#include "app_clock.hpp"
+#include "section_mask.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+/// @brief Tracks the working width, area rate and worked area of an implement
+/// @details The working width is adjusted by the width of the sections that changed, and the area is
+/// integrated over the time between two changes of the width or the speed. Nothing is recalculated when
+/// the statistics are read, so they can be updated on every report from the implement.
+class WorkStatistics
+{
+public:
+	using Clock = AppClock;
+
+	/**
+	 * @brief Set the width of every section, this resets the working width
+	 * @param sectionWidths_mm The width of each section
+	 */
+	void set_section_widths(std::vector<std::uint32_t> sectionWidths_mm);
+
+	/**
+	 * @brief Update the sections that are actually working
+	 * @param actualStates The sections that are on
+	 * @param now The current time
+	 */
+	void update_section_states(const SectionMask &actualStates, Clock::time_point now);
+
+	/**
+	 * @brief Update the speed of the implement
+	 * @param speed_mm_per_s The speed, the direction is ignored
+	 * @param now The current time
+	 */
+	void update_speed(std::int32_t speed_mm_per_s, Clock::time_point now);
+
+	/**
+	 * @brief Get the width of the sections that are working
+	 * @return The working width in millimeters
+	 */
+	std::uint32_t get_working_width() const;
+
+	/**
+	 * @brief Get the area that is being worked per hour at the current width and speed
+	 * @return The area rate in square meters per hour
+	 */
+	std::uint32_t get_area_rate() const;
+
+	/**
+	 * @brief Get the worked area, including overlap
+	 * @param now The current time, the area up to now is included
+	 * @return The worked area in square meters
+	 */
+	double get_worked_area(Clock::time_point now) const;
+
+	/**
+	 * @brief Reset the worked area, e.g. when a task starts
+	 * @param now The current time, the area from now on is counted
+	 */
+	void reset(Clock::time_point now);
+
+private:
+	void integrate(Clock::time_point now);
+
+	std::vector<std::uint32_t> sectionWidths_mm; ///< The width of each section
+	SectionMask lastSectionStates; ///< The section states the working width is based on
+	std::uint32_t workingWidth_mm = 0;
+	std::uint32_t speed_mm_per_s = 0;
+	double workedArea_mm2 = 0.0; ///< The area up to lastUpdate
+	Clock::time_point lastUpdate = {};
+	bool hasLastUpdate = false;
+};
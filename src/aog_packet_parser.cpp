@@ -0,0 +1,69 @@
+/**
+ * @author Daan Steenbergen
+ * @brief Splits the datagrams from AgOpenGPS into packets
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright 2026 Daan Steenbergen
+ */
+#include "aog_packet_parser.hpp"
+#include "log_macros.hpp"
+#include "metrics.hpp"
+
+#include <algorithm>
+
+void AogPacketParser::set_packet_handler(PacketCallback packetCallback)
+{
+	this->packetCallback = packetCallback;
+}
+
+void AogPacketParser::parse(std::span<const std::uint8_t> datagram)
+{
+	// Like a socket, what doesn't fit in the buffer is dropped
+	std::size_t bufferSize = std::min(datagram.size(), buffer.size());
+	std::copy_n(datagram.begin(), bufferSize, buffer.begin());
+
+	std::size_t index = 0;
+	while (bufferSize - index > HEADER_SIZE)
+	{
+		std::uint16_t start = static_cast<std::uint16_t>((buffer[index] << 8) | buffer[index + 1]);
+		if (start != PACKET_START)
+		{
+			// Unknown start of message, the rest of the datagram is ignored
+			TC_LOG_WARNING_EVERY(10000, "Unknown start of message {} (in decimal), ignoring the rest of the datagram", start);
+			break;
+		}
+
+		std::uint8_t src = buffer[index + 2];
+		std::uint8_t pgn = buffer[index + 3];
+		std::uint8_t len = buffer[index + 4];
+		if (bufferSize - index < HEADER_SIZE + len + 1)
+		{
+			break; // Cut off, a packet doesn't continue in the next datagram
+		}
+
+		// Check CRC (skip start of packet, but include source, PGN, length and data)
+		std::uint8_t crc = buffer[index + HEADER_SIZE + len];
+		if (crc != calculate_crc({ buffer.data() + index + 2, static_cast<std::size_t>(len) + 3 }))
+		{
+			Metrics::count_udp_crc_error(); // Counted only, the packet is still handled as before
+		}
+		Metrics::count_udp_packet_received(pgn);
+
+		if (packetCallback)
+		{
+			packetCallback(src, pgn, { buffer.data() + index + HEADER_SIZE, len });
+		}
+		index += HEADER_SIZE + len + 1;
+	}
+}
+
+std::uint8_t AogPacketParser::calculate_crc(std::span<const std::uint8_t> data)
+{
+	std::uint8_t result = 0;
+	for (std::uint8_t value : data)
+	{
+		result = static_cast<std::uint8_t>(result + value); // Wraps around, only the lowest byte of the sum is used
+	}
+	return result;
+}
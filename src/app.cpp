@@ -15,6 +15,9 @@
 #include "isobus/isobus/isobus_standard_data_description_indices.hpp"
 #include "isobus/utility/system_timing.hpp"
 
+#include "app_clock.hpp"
+#include "log_macros.hpp"
+#include "metrics.hpp"
 #include "task_controller.hpp"
 
 using boost::asio::ip::udp;
@@ -24,6 +27,21 @@ Application::Application(std::shared_ptr<isobus::CANHardwarePlugin> canDriver) :
 {
 }
 
+void Application::add_can_driver(std::shared_ptr<isobus::CANHardwarePlugin> driver)
+{
+	additionalCanDrivers.push_back(driver);
+}
+
+bool Application::record_traffic(const std::string &path)
+{
+	return trafficRecorder.open(path);
+}
+
+void Application::inject_datagram(std::span<const std::uint8_t> datagram)
+{
+	udpConnections->handle_datagram(datagram);
+}
+
 bool Application::initialize()
 {
 	settings->load();
@@ -32,8 +50,27 @@ bool Application::initialize()
 		std::cout << "Unable to find a CAN driver. Please make sure the selected driver is installed." << std::endl;
 		return false;
 	}
-	isobus::CANHardwareInterface::set_number_of_can_channels(1);
+	isobus::CANHardwareInterface::set_number_of_can_channels(static_cast<std::uint8_t>(1 + additionalCanDrivers.size()));
 	isobus::CANHardwareInterface::assign_can_channel_frame_handler(0, canDriver);
+	for (std::size_t i = 0; i < additionalCanDrivers.size(); i++)
+	{
+		isobus::CANHardwareInterface::assign_can_channel_frame_handler(static_cast<std::uint8_t>(i + 1), additionalCanDrivers[i]);
+	}
+	// Only the task controller's channel, frames of the other channels are not on its bus
+	isobus::CANHardwareInterface::get_can_frame_received_event_dispatcher().add_listener([this](const isobus::CANMessageFrame &frame) {
+		if (0 == frame.channel)
+		{
+			Metrics::count_can_frame_received();
+			trafficRecorder.record_can_frame(true, frame);
+		}
+	});
+	isobus::CANHardwareInterface::get_can_frame_transmitted_event_dispatcher().add_listener([this](const isobus::CANMessageFrame &frame) {
+		if (0 == frame.channel)
+		{
+			Metrics::count_can_frame_sent();
+			trafficRecorder.record_can_frame(false, frame);
+		}
+	});
 
 	if ((!isobus::CANHardwareInterface::start()) || (!canDriver->get_is_valid()))
 	{
@@ -70,11 +107,23 @@ bool Application::initialize()
 	}
 
 	tcServer = std::make_shared<MyTCServer>(serverCF);
+	tcServer->set_section_look_ahead(settings->get_section_look_ahead_on(), settings->get_section_look_ahead_off());
+	tcServer->set_coverage_section_control(settings->is_coverage_section_control_enabled());
+	tcServer->set_coverage_memory_per_client(settings->get_coverage_memory_per_client());
+	tcServer->set_number_of_virtual_sections(settings->get_number_of_virtual_sections());
+	tcServer->set_section_status_callback([this](ClientState &state) { send_section_status(state); });
+	if (!settings->get_prescription_map_path().empty())
+	{
+		tcServer->load_prescription_map(settings->get_prescription_map_path());
+	}
 	auto &languageInterface = tcServer->get_language_command_interface();
 	languageInterface.set_language_code("en"); // This is the default, but you can change it if you want
 	languageInterface.set_country_code("US"); // This is the default, but you can change it if you want
 	tcServer->initialize();
-	tcServer->set_task_totals_active(true); // TODO: make this dynamic based on status in AOG
+	tcServer->set_task_totals_active(true); // Until AOG ends a task, versions without the task totals PGN never do
+	tcServer->get_task_totals().load_checkpoint(Settings::get_filename_path("task_totals.bin"));
+	tcServer->get_as_applied_log().open(Settings::get_filename_path("as_applied.log"));
+	tcServer->get_event_journal().open(Settings::get_directory_path("journal"));
 
 	// Initialize speed and distance messages
 	speedMessagesInterface = std::make_unique<isobus::SpeedMessagesInterface>(serverCF, true, true, true, false); //TODO: make configurable whether to send these messages
@@ -97,17 +146,49 @@ bool Application::initialize()
 		if (src == 0x7F && pgn == 0xFE) // 254 - Steer Data
 		{
 			// TODO: hack to get desired section states. probably want to make a new pgn later when we need more than 16 sections
-			std::vector<bool> sectionStates;
-			for (std::uint8_t i = 0; i < 8; i++)
+			SectionMask sectionStates;
+			sectionStates.words[0] = data[6] | (data[7] << 8);
+
+			tcServer->update_section_states(sectionStates);
+		}
+		else if (src == 0x7F && pgn == 0xD0 && data.size() >= 10) // 208 - Corrected Position
+		{
+			std::uint32_t encodedLatitude = data[0] | (data[1] << 8) | (data[2] << 16) | (data[3] << 24);
+			std::uint32_t encodedLongitude = data[4] | (data[5] << 8) | (data[6] << 16) | (data[7] << 24);
+			std::uint16_t encodedHeading = data[8] | (data[9] << 8);
+
+			double latitude = encodedLatitude * 0.0000001 - 210.0;
+			double longitude = encodedLongitude * 0.0000001 - 210.0;
+			double heading = encodedHeading / 128.0;
+			tcServer->update_position(latitude, longitude, heading);
+		}
+		else if (src == 0x7F && pgn == 0xF3 && data.size() >= 5) // 243 - Task Totals
+		{
+			std::uint8_t command = data[0];
+			std::uint32_t taskId = data[1] | (data[2] << 8) | (data[3] << 16) | (data[4] << 24);
+			if (command == 1)
 			{
-				sectionStates.push_back(data[6] & (1 << i));
+				TC_LOG_INFO("Received request from AOG to start task {}", taskId);
+				tcServer->get_task_totals().start_task(taskId);
+				tcServer->set_task_totals_active(true);
+				for (auto &client : tcServer->get_clients())
+				{
+					client.second.get_work_statistics().reset(WorkStatistics::Clock::now()); // The worked area on 0xF4 is per task
+				}
+
+				// Every task gets its own TASKDATA set, so it can be imported on its own
+				tcServer->get_task_data_writer().start(Settings::get_directory_path("TaskData/Task" + std::to_string(taskId)), "Task " + std::to_string(taskId));
 			}
-			for (std::uint8_t i = 0; i < 8; i++)
+			else if (command == 2)
 			{
-				sectionStates.push_back(data[7] & (1 << i));
+				TC_LOG_INFO("Received request from AOG to end task {}", taskId);
+				tcServer->set_task_totals_active(false);
+				tcServer->get_task_data_writer().stop();
+			}
+			else
+			{
+				send_task_totals(taskId);
 			}
-
-			tcServer->update_section_states(sectionStates);
 		}
 		else if (src == 0x7F && pgn == 0xF1) // 241 - Section Control
 		{
@@ -123,6 +204,7 @@ bool Application::initialize()
 			if (identifier == isobus::DataDescriptionIndex::ActualSpeed)
 			{
 				std::uint16_t speed = std::abs(value);
+				tcServer->update_speed(value);
 				auto direction = value < 0 ? isobus::SpeedMessagesInterface::MachineDirection::Reverse : isobus::SpeedMessagesInterface::MachineDirection::Forward;
 				speedMessagesInterface->groundBasedSpeedTransmitData.set_machine_direction_of_travel(direction);
 				speedMessagesInterface->wheelBasedSpeedTransmitData.set_machine_direction_of_travel(direction);
@@ -160,11 +242,11 @@ bool Application::initialize()
 					0xFF, // Reserved byte 1 (all bits set to 1)
 					0xFF // Reserved byte 2 (all bits set to 1)
 				};
-				if (isobus::SystemTiming::time_expired_ms(lastXteTransmit, 1000)) // Transmit every second
+				if (AppClock::time_expired_ms(lastXteTransmit, 1000)) // Transmit every second
 				{
 					if (isobus::CANNetworkManager::CANNetwork.send_can_message(0x1F903, xteData.data(), xteData.size(), serverCF))
 					{
-						lastXteTransmit = isobus::SystemTiming::get_timestamp_ms();
+						lastXteTransmit = AppClock::get_timestamp_ms();
 					}
 				}
 			}
@@ -178,56 +260,311 @@ bool Application::initialize()
 		}
 	};
 	udpConnections->set_packet_handler(packetHandler);
+	udpConnections->set_subnet_handler([this](const std::array<std::uint8_t, 3> &subnet) { tcServer->get_event_journal().log_subnet_change(subnet); });
+	if (trafficRecorder.is_open())
+	{
+		udpConnections->set_datagram_handler([this](bool isReceived, std::span<const std::uint8_t> datagram) { trafficRecorder.record_datagram(isReceived, datagram); });
+	}
 	udpConnections->open();
 
 	std::cout << "UDP connections opened." << std::endl;
 
+	if (0 != settings->get_metrics_port())
+	{
+		metricsServer.open(settings->get_metrics_port());
+	}
+	if (0 != settings->get_dashboard_port())
+	{
+		dashboard.start(settings->get_dashboard_port(), settings->get_dashboard_frame_rate());
+	}
+	loopWatchdog.start(loopProfiler);
+
 	return true;
 }
 
 bool Application::update()
 {
 	static std::uint32_t lastHeartbeatTransmit = 0;
+	static std::uint32_t lastTaskTotalsCheckpoint = 0;
+	static std::uint32_t lastWorkStatisticsTransmit = 0;
+	static std::uint32_t lastSectionLatencyTransmit = 0;
+	static std::uint32_t lastSectionLatencyExport = 0;
+	static std::uint32_t lastDashboardUpdate = 0;
+	static std::uint32_t lastLoopProfileReport = 0;
+	loopProfiler.start_loop();
 
 	udpConnections->handle_address_detection();
+	loopProfiler.end_phase(LoopProfiler::Phase::AddressDetection);
 	udpConnections->handle_incoming_packets();
+	loopProfiler.end_phase(LoopProfiler::Phase::UdpReceive);
 
 	tcServer->request_measurement_commands();
+	loopProfiler.end_phase(LoopProfiler::Phase::MeasurementCommands);
 	tcServer->update();
+	loopProfiler.end_phase(LoopProfiler::Phase::TaskController);
 	speedMessagesInterface->update();
+	loopProfiler.end_phase(LoopProfiler::Phase::SpeedMessages);
 	nmea2000MessageInterface->update();
+	loopProfiler.end_phase(LoopProfiler::Phase::Nmea2000);
+	tcServer->update_scheduled_section_states();
+	loopProfiler.end_phase(LoopProfiler::Phase::SectionScheduling);
+
+	if (AppClock::time_expired_ms(lastHeartbeatTransmit, 100))
+	{
+		for (auto &client : tcServer->get_clients())
+		{
+			send_section_status(client.second);
+		}
+		lastHeartbeatTransmit = AppClock::get_timestamp_ms();
+	}
+	loopProfiler.end_phase(LoopProfiler::Phase::Heartbeat);
 
-	if (isobus::SystemTiming::time_expired_ms(lastHeartbeatTransmit, 100))
+	if (AppClock::time_expired_ms(lastWorkStatisticsTransmit, 1000))
 	{
 		for (auto &client : tcServer->get_clients())
 		{
-			auto &state = client.second;
-			std::vector<uint8_t> data = { state.is_section_control_enabled(), state.get_number_of_sections() };
+			send_work_statistics(client.second);
+		}
+		tcServer->get_event_journal().flush();
+		trafficRecorder.flush();
+		lastWorkStatisticsTransmit = AppClock::get_timestamp_ms();
+	}
+
+	if (AppClock::time_expired_ms(lastSectionLatencyTransmit, 5000))
+	{
+		for (auto &client : tcServer->get_clients())
+		{
+			send_section_latencies(client.second);
+		}
+		lastSectionLatencyTransmit = AppClock::get_timestamp_ms();
+	}
+
+	if (AppClock::time_expired_ms(lastSectionLatencyExport, 60000))
+	{
+		for (auto &client : tcServer->get_clients())
+		{
+			auto fileName = "section_latency_" + std::to_string(client.first->get_NAME().get_full_name()) + ".csv";
+			client.second.get_latency_profiler().export_csv(Settings::get_filename_path(fileName));
+		}
+		lastSectionLatencyExport = AppClock::get_timestamp_ms();
+	}
+
+	if (AppClock::time_expired_ms(lastTaskTotalsCheckpoint, 10000))
+	{
+		// Only written when a total changed, at most 10 seconds of work is lost on a power failure
+		tcServer->get_task_totals().save_checkpoint(Settings::get_filename_path("task_totals.bin"));
+		lastTaskTotalsCheckpoint = AppClock::get_timestamp_ms();
+	}
+
+	// The loop profile and the dashboard are about the host, so they stay on real time in simulations
+	if (isobus::SystemTiming::time_expired_ms(lastLoopProfileReport, 60000))
+	{
+		loopProfiler.rotate();
+		loopProfiler.log_reports();
+		lastLoopProfileReport = isobus::SystemTiming::get_timestamp_ms();
+	}
+	loopProfiler.end_phase(LoopProfiler::Phase::PeriodicTasks);
+
+	// The dashboard compares the snapshots itself, so it only pushes what changed
+	if (dashboard.is_running() && isobus::SystemTiming::time_expired_ms(lastDashboardUpdate, 1000u / std::max<std::uint8_t>(settings->get_dashboard_frame_rate(), 1)))
+	{
+		update_dashboard();
+		lastDashboardUpdate = isobus::SystemTiming::get_timestamp_ms();
+	}
+	loopProfiler.end_phase(LoopProfiler::Phase::Dashboard);
+
+	ioContext.poll(); // Serves the metrics requests
+	loopProfiler.end_phase(LoopProfiler::Phase::WebServer);
+	Metrics::set_number_of_active_clients(static_cast<std::uint32_t>(tcServer->get_clients().size()));
+	Metrics::observe_loop_duration(static_cast<std::uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(loopProfiler.end_loop()).count()));
+	return true;
+}
+
+void Application::send_section_status(const ClientState &state)
+{
+	auto data = build_section_status(state);
+	udpConnections->send(0x80, 0xF0, data);
+}
+
+std::vector<std::uint8_t> Application::build_section_status(const ClientState &state)
+{
+	// Report in terms of AOG's sections, which may be mapped onto more physical sections or booms
+	SectionMask actualStates = state.get_aog_section_actual_states();
+	SectionMask overrideStates = state.get_aog_section_override_states();
+	std::uint8_t numberOfSections = state.get_number_of_aog_sections();
+
+	// The override bits follow the actual state bits, so AOG can show which sections the operator has taken over
+	std::vector<uint8_t> data = { state.is_section_control_enabled(), numberOfSections };
+	for (const SectionMask *states : { &actualStates, &overrideStates })
+	{
+		for (std::uint16_t sectionIndex = 0; sectionIndex < numberOfSections; sectionIndex += 8)
+		{
+			data.push_back(static_cast<std::uint8_t>(states->words[sectionIndex / 64] >> (sectionIndex % 64)));
+		}
+	}
+	return data;
+}
 
-			std::uint8_t sectionIndex = 0;
-			while (sectionIndex < state.get_number_of_sections())
+void Application::send_task_totals(std::uint32_t taskId)
+{
+	constexpr std::size_t TOTALS_PER_PACKET = 12; // 20 bytes each, keeps the packet within the one byte length field
+
+	const auto &totals = tcServer->get_task_totals().get_totals(taskId);
+	std::size_t index = 0;
+	do
+	{
+		// Every packet repeats the task and tells how many totals follow, an unknown task is answered with an empty packet
+		auto numberOfTotals = static_cast<std::uint8_t>(std::min(TOTALS_PER_PACKET, totals.size() - index));
+		std::vector<std::uint8_t> data = { static_cast<std::uint8_t>(taskId), static_cast<std::uint8_t>(taskId >> 8), static_cast<std::uint8_t>(taskId >> 16), static_cast<std::uint8_t>(taskId >> 24), numberOfTotals };
+		for (std::size_t end = index + numberOfTotals; index < end; index++)
+		{
+			const auto &total = totals[index];
+			for (std::uint8_t i = 0; i < 8; i++)
 			{
-				std::uint8_t byte = 0;
-				for (std::uint8_t i = 0; i < 8; i++)
-				{
-					if (sectionIndex < state.get_number_of_sections())
-					{
-						byte |= (state.get_section_actual_state(sectionIndex) == SectionState::ON) << i;
-						sectionIndex++;
-					}
-				}
-				data.push_back(byte);
+				data.push_back(static_cast<std::uint8_t>(total.clientName >> (8 * i)));
+			}
+			data.push_back(static_cast<std::uint8_t>(total.elementNumber));
+			data.push_back(static_cast<std::uint8_t>(total.elementNumber >> 8));
+			data.push_back(static_cast<std::uint8_t>(total.ddi));
+			data.push_back(static_cast<std::uint8_t>(total.ddi >> 8));
+			for (std::uint8_t i = 0; i < 8; i++)
+			{
+				data.push_back(static_cast<std::uint8_t>(static_cast<std::uint64_t>(total.value) >> (8 * i)));
 			}
-			udpConnections->send(0x80, 0xF0, data);
 		}
-		lastHeartbeatTransmit = isobus::SystemTiming::get_timestamp_ms();
+		udpConnections->send(0x80, 0xF3, data);
+	} while (index < totals.size());
+}
+
+void Application::send_work_statistics(const ClientState &state)
+{
+	const auto &statistics = state.get_work_statistics();
+	std::array<std::uint32_t, 4> values = {
+		statistics.get_working_width(), // mm
+		statistics.get_area_rate(), // m2/h
+		static_cast<std::uint32_t>(statistics.get_worked_area(WorkStatistics::Clock::now()) * 10.0), // 0.1 m2, since the task started
+		static_cast<std::uint32_t>(state.get_coverage_map().get_covered_area() * 10.0) // 0.1 m2, worked area without overlap
+	};
+
+	std::vector<std::uint8_t> data;
+	for (std::uint32_t value : values)
+	{
+		data.push_back(static_cast<std::uint8_t>(value));
+		data.push_back(static_cast<std::uint8_t>(value >> 8));
+		data.push_back(static_cast<std::uint8_t>(value >> 16));
+		data.push_back(static_cast<std::uint8_t>(value >> 24));
 	}
+	udpConnections->send(0x80, 0xF4, data);
+}
 
-	return true;
+void Application::send_section_latencies(const ClientState &state)
+{
+	const auto &profiler = state.get_latency_profiler();
+	std::array<std::uint16_t, 4> values = {
+		static_cast<std::uint16_t>(std::min<std::uint32_t>(profiler.get_recommended_delay(true), UINT16_MAX)), // ms
+		static_cast<std::uint16_t>(std::min<std::uint32_t>(profiler.get_recommended_delay(false), UINT16_MAX)), // ms
+		static_cast<std::uint16_t>(std::min<std::uint32_t>(profiler.get_number_of_samples(true), UINT16_MAX)),
+		static_cast<std::uint16_t>(std::min<std::uint32_t>(profiler.get_number_of_samples(false), UINT16_MAX))
+	};
+
+	std::vector<std::uint8_t> data;
+	for (std::uint16_t value : values)
+	{
+		data.push_back(static_cast<std::uint8_t>(value));
+		data.push_back(static_cast<std::uint8_t>(value >> 8));
+	}
+	udpConnections->send(0x80, 0xF5, data);
+}
+
+void Application::update_dashboard()
+{
+	auto &snapshot = dashboard.get_back_buffer();
+	auto &clients = tcServer->get_clients();
+	if (snapshot.clients.size() < clients.size())
+	{
+		snapshot.clients.resize(clients.size());
+	}
+	snapshot.numberOfClients = static_cast<std::uint8_t>(clients.size());
+
+	std::size_t clientIndex = 0;
+	for (auto &client : clients)
+	{
+		auto &state = client.second;
+		auto &clientSnapshot = snapshot.clients[clientIndex++];
+		clientSnapshot.name = client.first->get_NAME().get_full_name();
+		clientSnapshot.address = client.first->get_address();
+		clientSnapshot.isSectionControlEnabled = state.is_section_control_enabled();
+		clientSnapshot.numberOfBooms = static_cast<std::uint8_t>(state.get_booms().size());
+		clientSnapshot.designator.clear();
+		for (std::uint32_t i = 0; i < state.get_pool().size(); i++)
+		{
+			auto object = state.get_pool().get_object_by_index(i);
+			if (object->get_object_type() == isobus::task_controller_object::ObjectTypes::Device)
+			{
+				clientSnapshot.designator = std::static_pointer_cast<isobus::task_controller_object::DeviceObject>(object)->get_designator();
+				break;
+			}
+		}
+
+		const auto &geometry = state.get_coverage_map().get_sections();
+		clientSnapshot.sections.resize(state.get_number_of_sections());
+		for (std::uint8_t i = 0; i < state.get_number_of_sections(); i++)
+		{
+			auto &section = clientSnapshot.sections[i];
+			section.setpointState = state.get_section_setpoint_state(i);
+			section.actualState = state.get_section_actual_state(i);
+			section.isOverridden = state.is_section_overridden(i);
+			if (i < geometry.size())
+			{
+				section.xOffset_m = geometry[i].xOffset_m;
+				section.yOffset_m = geometry[i].yOffset_m;
+				section.width_m = geometry[i].width_m;
+			}
+		}
+
+		clientSnapshot.subscriptions.clear();
+		for (const auto &subscription : state.get_measurement_subscriptions())
+		{
+			clientSnapshot.subscriptions.push_back({ subscription.ddi, subscription.elementNumber, subscription.timeInterval_ms, subscription.isOnChange });
+		}
+	}
+	dashboard.publish();
+}
+
+const LoopProfiler &Application::get_loop_profiler() const
+{
+	return loopProfiler;
+}
+
+const LoopWatchdog &Application::get_loop_watchdog() const
+{
+	return loopWatchdog;
+}
+
+std::shared_ptr<MyTCServer> Application::get_task_controller() const
+{
+	return tcServer;
+}
+
+AppClock::time_point Application::get_next_update_time() const
+{
+	auto nextUpdateTime = AppClock::now() + UPDATE_INTERVAL;
+	if (nullptr != tcServer)
+	{
+		nextUpdateTime = std::min(nextUpdateTime, tcServer->get_next_scheduled_section_time());
+	}
+	return nextUpdateTime;
 }
 
 void Application::stop()
 {
+	loopWatchdog.stop();
+	tcServer->get_task_data_writer().stop();
+	tcServer->get_as_applied_log().close();
+	tcServer->get_event_journal().close();
+	metricsServer.close();
+	dashboard.stop();
 	tcServer->terminate();
 	isobus::CANHardwareInterface::stop();
+	trafficRecorder.close(); // After the CAN stack, so the last frames are in it
 }
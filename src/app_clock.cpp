@@ -0,0 +1,92 @@
+/**
+ * @author Daan Steenbergen
+ * @brief The time source of the task controller, real or virtual for simulations
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright 2026 Daan Steenbergen
+ */
+#include "app_clock.hpp"
+
+#include <atomic>
+#include <thread>
+
+static std::atomic_bool isVirtualTime = { false };
+static std::atomic<AppClock::rep> virtualTime = { 0 }; ///< Ticks since the epoch of the steady clock
+
+/// @brief The calendar time minus the steady time, in nanoseconds, the time of this clock maps onto the calendar with it
+static std::int64_t get_wall_time_offset(std::chrono::system_clock::time_point wallTime, AppClock::time_point time)
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(wallTime.time_since_epoch()).count() -
+	  std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+}
+static std::atomic<std::int64_t> wallTimeOffset_ns = { get_wall_time_offset(std::chrono::system_clock::now(), AppClock::time_point(std::chrono::steady_clock::now().time_since_epoch())) };
+
+AppClock::time_point AppClock::now()
+{
+	if (isVirtualTime.load(std::memory_order_acquire))
+	{
+		return time_point(duration(virtualTime.load(std::memory_order_acquire)));
+	}
+	return time_point(std::chrono::steady_clock::now().time_since_epoch());
+}
+
+std::uint32_t AppClock::get_timestamp_ms()
+{
+	return static_cast<std::uint32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(now().time_since_epoch()).count());
+}
+
+bool AppClock::time_expired_ms(std::uint32_t timestamp_ms, std::uint32_t timeout_ms)
+{
+	return (get_timestamp_ms() - timestamp_ms) >= timeout_ms; // Unsigned, so correct across the wrap around
+}
+
+void AppClock::set_virtual(bool enable)
+{
+	if (enable)
+	{
+		virtualTime.store(std::chrono::steady_clock::now().time_since_epoch().count(), std::memory_order_release);
+	}
+	isVirtualTime.store(enable, std::memory_order_release);
+}
+
+bool AppClock::is_virtual()
+{
+	return isVirtualTime.load(std::memory_order_acquire);
+}
+
+void AppClock::advance_to(time_point time)
+{
+	if (!is_virtual())
+	{
+		return;
+	}
+
+	// Another thread may advance as well, time never goes back
+	auto ticks = time.time_since_epoch().count();
+	auto current = virtualTime.load(std::memory_order_acquire);
+	while ((current < ticks) && !virtualTime.compare_exchange_weak(current, ticks, std::memory_order_acq_rel))
+	{
+	}
+}
+
+std::chrono::system_clock::time_point AppClock::get_wall_time()
+{
+	std::chrono::nanoseconds wallTime(std::chrono::duration_cast<std::chrono::nanoseconds>(now().time_since_epoch()).count() + wallTimeOffset_ns.load(std::memory_order_acquire));
+	return std::chrono::system_clock::time_point(std::chrono::duration_cast<std::chrono::system_clock::duration>(wallTime));
+}
+
+void AppClock::set_wall_time(std::chrono::system_clock::time_point wallTime)
+{
+	wallTimeOffset_ns.store(get_wall_time_offset(wallTime, now()), std::memory_order_release);
+}
+
+void AppClock::sleep_until(time_point time)
+{
+	if (is_virtual())
+	{
+		advance_to(time);
+		return;
+	}
+	std::this_thread::sleep_until(std::chrono::steady_clock::time_point(time.time_since_epoch()));
+}
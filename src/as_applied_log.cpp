@@ -0,0 +1,358 @@
+/**
+ * @author Daan Steenbergen
+ * @brief A compact, memory-mapped log of what was applied where
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright 2026 Daan Steenbergen
+ */
+#include "as_applied_log.hpp"
+#include "app_clock.hpp"
+#include "log_macros.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/// @brief Prepare the header of a chunk that was just added to the file
+static void initialize_chunk_header(AsAppliedLog::ChunkHeader &header)
+{
+	header = {};
+	header.magic = AsAppliedLog::CHUNK_MAGIC;
+	header.minimumLatitude = INT32_MAX;
+	header.maximumLatitude = INT32_MIN;
+	header.minimumLongitude = INT32_MAX;
+	header.maximumLongitude = INT32_MIN;
+}
+
+/// @brief Check whether a chunk can contain records that match a query
+static bool is_chunk_in_query(const AsAppliedLog::ChunkHeader &header, const AsAppliedLog::Query &query)
+{
+	return (header.numberOfRecords > 0) &&
+	  (header.firstTimestamp_ms <= query.endTimestamp_ms) && (header.lastTimestamp_ms >= query.startTimestamp_ms) &&
+	  (header.minimumLatitude <= query.maximumLatitude) && (header.maximumLatitude >= query.minimumLatitude) &&
+	  (header.minimumLongitude <= query.maximumLongitude) && (header.maximumLongitude >= query.minimumLongitude);
+}
+
+/// @brief Check whether a record matches a query
+static bool is_record_in_query(const AsAppliedLog::Record &record, const AsAppliedLog::Query &query)
+{
+	return (record.timestamp_ms >= query.startTimestamp_ms) && (record.timestamp_ms <= query.endTimestamp_ms) &&
+	  (record.latitude >= query.minimumLatitude) && (record.latitude <= query.maximumLatitude) &&
+	  (record.longitude >= query.minimumLongitude) && (record.longitude <= query.maximumLongitude);
+}
+
+AsAppliedLog::~AsAppliedLog()
+{
+	close();
+}
+
+bool AsAppliedLog::open(const std::string &path)
+{
+	close();
+
+	std::uint64_t fileSize = 0;
+#ifdef _WIN32
+	// Shared, so the log can be queried while it is recorded
+	HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	LARGE_INTEGER size;
+	if ((INVALID_HANDLE_VALUE == handle) || !GetFileSizeEx(handle, &size))
+	{
+		if (INVALID_HANDLE_VALUE != handle)
+		{
+			CloseHandle(handle);
+		}
+		TC_LOG_ERROR("Unable to open as-applied log {}", path);
+		return false;
+	}
+	fileHandle = handle;
+	fileSize = static_cast<std::uint64_t>(size.QuadPart);
+#else
+	fileDescriptor = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+	struct stat status;
+	if ((fileDescriptor < 0) || (0 != fstat(fileDescriptor, &status)))
+	{
+		close();
+		TC_LOG_ERROR("Unable to open as-applied log {}", path);
+		return false;
+	}
+	fileSize = static_cast<std::uint64_t>(status.st_size);
+#endif
+
+	if (0 != (fileSize % CHUNK_SIZE))
+	{
+		close();
+		TC_LOG_ERROR("Unable to open as-applied log {}. (Not a multiple of the chunk size)", path);
+		return false;
+	}
+
+	// Continue in the last chunk, the records of earlier sessions are kept
+	std::size_t lastChunk = (fileSize > 0) ? static_cast<std::size_t>(fileSize / CHUNK_SIZE) - 1 : 0;
+	if (!map_chunk(lastChunk))
+	{
+		close();
+		TC_LOG_ERROR("Unable to open as-applied log {}. (Failed to map the last chunk)", path);
+		return false;
+	}
+	TC_LOG_INFO("Recording as-applied data to {}", path);
+	return true;
+}
+
+void AsAppliedLog::close()
+{
+	unmap_chunk();
+#ifdef _WIN32
+	if (nullptr != fileHandle)
+	{
+		CloseHandle(fileHandle);
+		fileHandle = nullptr;
+	}
+#else
+	if (fileDescriptor >= 0)
+	{
+		::close(fileDescriptor);
+		fileDescriptor = -1;
+	}
+#endif
+	workingClients.clear();
+}
+
+bool AsAppliedLog::is_open() const
+{
+	return nullptr != chunk;
+}
+
+void AsAppliedLog::append(std::uint64_t clientName,
+                          double latitude,
+                          double longitude,
+                          double heading_deg,
+                          const SectionMask &sectionStates,
+                          std::uint8_t numberOfSections,
+                          const std::int32_t *rates,
+                          std::size_t numberOfRates)
+{
+	if (nullptr == chunk)
+	{
+		return;
+	}
+
+	bool isWorking = sectionStates.any();
+	auto &wasWorking = workingClients[clientName];
+	if (!isWorking && !wasWorking)
+	{
+		return;
+	}
+	wasWorking = isWorking;
+
+	auto *header = reinterpret_cast<ChunkHeader *>(chunk);
+	if (header->numberOfRecords >= RECORDS_PER_CHUNK)
+	{
+		unmap_chunk();
+		if (!map_chunk(chunkIndex + 1))
+		{
+			TC_LOG_ERROR("Stopped recording as-applied data. (Failed to add a chunk)");
+			close();
+			return;
+		}
+		header = reinterpret_cast<ChunkHeader *>(chunk);
+	}
+
+	Record record = {};
+	record.timestamp_ms = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(AppClock::get_wall_time().time_since_epoch()).count());
+	record.clientName = clientName;
+	record.sectionStates = sectionStates.words;
+	record.latitude = static_cast<std::int32_t>(std::lround(latitude * 10000000.0));
+	record.longitude = static_cast<std::int32_t>(std::lround(longitude * 10000000.0));
+	record.numberOfRates = static_cast<std::uint8_t>(std::min(numberOfRates, MAX_NUMBER_OF_RATES));
+	std::copy(rates, rates + record.numberOfRates, record.rates.begin());
+	double heading = std::fmod(heading_deg, 360.0);
+	record.heading = static_cast<std::uint16_t>(std::lround((heading < 0.0 ? heading + 360.0 : heading) * 100.0) % 36000);
+	record.numberOfSections = numberOfSections;
+
+	std::memcpy(chunk + sizeof(ChunkHeader) + header->numberOfRecords * sizeof(Record), &record, sizeof(Record));
+
+	if (0 == header->numberOfRecords)
+	{
+		header->firstTimestamp_ms = record.timestamp_ms;
+	}
+	header->lastTimestamp_ms = record.timestamp_ms;
+	header->minimumLatitude = std::min(header->minimumLatitude, record.latitude);
+	header->maximumLatitude = std::max(header->maximumLatitude, record.latitude);
+	header->minimumLongitude = std::min(header->minimumLongitude, record.longitude);
+	header->maximumLongitude = std::max(header->maximumLongitude, record.longitude);
+
+	// The record count goes last, the fence keeps the record and bounds above from being written after it.
+	// A concurrent query reads the count before an acquire fence, so it never sees a partial record.
+	std::atomic_thread_fence(std::memory_order_release);
+	header->numberOfRecords++;
+}
+
+bool AsAppliedLog::query(const std::string &path, const Query &query, const std::function<void(const Record &)> &callback)
+{
+	std::uint64_t fileSize = 0;
+#ifdef _WIN32
+	HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	LARGE_INTEGER size;
+	if ((INVALID_HANDLE_VALUE == handle) || !GetFileSizeEx(handle, &size))
+	{
+		if (INVALID_HANDLE_VALUE != handle)
+		{
+			CloseHandle(handle);
+		}
+		TC_LOG_ERROR("Unable to query as-applied log {}", path);
+		return false;
+	}
+	fileSize = static_cast<std::uint64_t>(size.QuadPart);
+#else
+	int descriptor = ::open(path.c_str(), O_RDONLY);
+	struct stat status;
+	if ((descriptor < 0) || (0 != fstat(descriptor, &status)))
+	{
+		if (descriptor >= 0)
+		{
+			::close(descriptor);
+		}
+		TC_LOG_ERROR("Unable to query as-applied log {}", path);
+		return false;
+	}
+	fileSize = static_cast<std::uint64_t>(status.st_size);
+#endif
+
+	// Only the pages of the chunks that overlap the query are read, the others just have their header touched
+	bool success = true;
+	for (std::uint64_t offset = 0; (offset + CHUNK_SIZE) <= fileSize; offset += CHUNK_SIZE)
+	{
+#ifdef _WIN32
+		HANDLE mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		auto *data = (nullptr != mapping) ? static_cast<const std::uint8_t *>(MapViewOfFile(mapping, FILE_MAP_READ, static_cast<DWORD>(offset >> 32), static_cast<DWORD>(offset), CHUNK_SIZE)) : nullptr;
+#else
+		void *view = mmap(nullptr, CHUNK_SIZE, PROT_READ, MAP_SHARED, descriptor, static_cast<off_t>(offset));
+		auto *data = (MAP_FAILED != view) ? static_cast<const std::uint8_t *>(view) : nullptr;
+#endif
+		if (nullptr == data)
+		{
+			TC_LOG_ERROR("Unable to query as-applied log {}. (Failed to map a chunk)", path);
+			success = false;
+#ifdef _WIN32
+			if (nullptr != mapping)
+			{
+				CloseHandle(mapping);
+			}
+#endif
+			break;
+		}
+
+		// The count is read first, the records and bounds up to it are complete after the fence (see append)
+		std::uint32_t numberOfRecords = 0;
+		std::memcpy(&numberOfRecords, data + offsetof(ChunkHeader, numberOfRecords), sizeof(numberOfRecords));
+		std::atomic_thread_fence(std::memory_order_acquire);
+		ChunkHeader header;
+		std::memcpy(&header, data, sizeof(ChunkHeader));
+		if ((CHUNK_MAGIC == header.magic) && is_chunk_in_query(header, query))
+		{
+			numberOfRecords = std::min<std::uint32_t>(numberOfRecords, RECORDS_PER_CHUNK);
+			Record record;
+			for (std::uint32_t i = 0; i < numberOfRecords; i++)
+			{
+				std::memcpy(&record, data + sizeof(ChunkHeader) + i * sizeof(Record), sizeof(Record));
+				if (is_record_in_query(record, query))
+				{
+					callback(record);
+				}
+			}
+		}
+
+#ifdef _WIN32
+		UnmapViewOfFile(data);
+		CloseHandle(mapping);
+#else
+		munmap(const_cast<std::uint8_t *>(data), CHUNK_SIZE);
+#endif
+	}
+
+#ifdef _WIN32
+	CloseHandle(handle);
+#else
+	::close(descriptor);
+#endif
+	return success;
+}
+
+bool AsAppliedLog::map_chunk(std::size_t index)
+{
+	std::uint64_t offset = static_cast<std::uint64_t>(index) * CHUNK_SIZE;
+	std::uint64_t end = offset + CHUNK_SIZE;
+#ifdef _WIN32
+	// A mapping larger than the file grows the file
+	mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READWRITE, static_cast<DWORD>(end >> 32), static_cast<DWORD>(end), nullptr);
+	if (nullptr == mappingHandle)
+	{
+		return false;
+	}
+	chunk = static_cast<std::uint8_t *>(MapViewOfFile(mappingHandle, FILE_MAP_WRITE, static_cast<DWORD>(offset >> 32), static_cast<DWORD>(offset), CHUNK_SIZE));
+	if (nullptr == chunk)
+	{
+		CloseHandle(mappingHandle);
+		mappingHandle = nullptr;
+		return false;
+	}
+#else
+	struct stat status;
+	if ((0 != fstat(fileDescriptor, &status)) ||
+	    ((static_cast<std::uint64_t>(status.st_size) < end) && (0 != ftruncate(fileDescriptor, static_cast<off_t>(end)))))
+	{
+		return false;
+	}
+	void *view = mmap(nullptr, CHUNK_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fileDescriptor, static_cast<off_t>(offset));
+	if (MAP_FAILED == view)
+	{
+		return false;
+	}
+	chunk = static_cast<std::uint8_t *>(view);
+#endif
+	chunkIndex = index;
+
+	// A new chunk reads as zeros, also when the application stopped right after growing the file
+	auto *header = reinterpret_cast<ChunkHeader *>(chunk);
+	if (0 == header->magic)
+	{
+		initialize_chunk_header(*header);
+	}
+	else if (CHUNK_MAGIC != header->magic)
+	{
+		unmap_chunk();
+		return false;
+	}
+	return true;
+}
+
+void AsAppliedLog::unmap_chunk()
+{
+	if (nullptr == chunk)
+	{
+		return;
+	}
+#ifdef _WIN32
+	FlushViewOfFile(chunk, 0);
+	UnmapViewOfFile(chunk);
+	CloseHandle(mappingHandle);
+	mappingHandle = nullptr;
+#else
+	munmap(chunk, CHUNK_SIZE);
+#endif
+	chunk = nullptr;
+}
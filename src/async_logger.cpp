@@ -0,0 +1,387 @@
+/**
+ * @author Daan Steenbergen
+ * @brief Asynchronous logging to the console and rotating log files
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright 2026 Daan Steenbergen
+ */
+#include "async_logger.hpp"
+#include "platform.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <condition_variable>
+#include <cstdio>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+static_assert(0 == (AsyncLogger::RING_CAPACITY & (AsyncLogger::RING_CAPACITY - 1)), "The ring capacity must be a power of two");
+
+/// @brief The records of one thread, written by that thread and read by the background thread
+struct LogRing
+{
+	std::array<AsyncLogger::Record, AsyncLogger::RING_CAPACITY> records;
+	alignas(64) std::atomic<std::size_t> head = 0; ///< Where the owning thread writes the next record
+	alignas(64) std::atomic<std::size_t> tail = 0; ///< Where the background thread reads the next record
+};
+
+/// @brief A formatted record, waiting to be written
+struct LogMessage
+{
+	std::int64_t timestamp_us;
+	std::uint8_t level;
+	bool hasPrefix; ///< Text logged as is has no level prefix
+	std::string text;
+};
+
+/// @brief The state shared by the threads that log and the background thread
+struct LogBackend
+{
+	~LogBackend()
+	{
+		AsyncLogger::stop();
+	}
+
+	std::mutex ringsMutex; ///< Protects the list of rings, only taken when a thread logs for the first time
+	std::vector<std::shared_ptr<LogRing>> rings;
+	std::mutex drainMutex; ///< Only one thread drains the rings at a time
+	std::mutex threadMutex;
+	std::condition_variable stopCondition;
+	std::thread thread;
+	bool isStopRequested = false;
+	std::atomic<bool> isRunning = false;
+	std::atomic<bool> isStopped = false; ///< After stopping, every record is written right away
+	std::atomic<std::uint64_t> numberOfDroppedRecords = 0;
+	std::uint64_t numberOfReportedDrops = 0;
+	std::streambuf *console = nullptr;
+	std::ofstream file;
+	std::string filePath;
+	std::uint64_t fileSize = 0;
+	std::vector<LogMessage> messages; ///< Reused while draining
+	std::string payload; ///< Reused for the string arguments of a record
+	std::string consoleOutput; ///< Reused to write a batch to the console at once
+	std::string fileOutput; ///< Reused to write a batch to the file at once
+};
+
+static LogBackend backend;
+thread_local std::shared_ptr<LogRing> threadRing;
+
+static const char *get_level_prefix(std::uint8_t level)
+{
+	switch (static_cast<AsyncLogger::Level>(level))
+	{
+		case AsyncLogger::Level::Debug:
+			return "[Debug]";
+		case AsyncLogger::Level::Info:
+			return "[Info]";
+		case AsyncLogger::Level::Warning:
+			return "[Warn]";
+		case AsyncLogger::Level::Error:
+			return "[Error]";
+		case AsyncLogger::Level::Critical:
+			return "[Critical]";
+	}
+	return "";
+}
+
+template<typename T>
+static void append_number(std::string &text, T value)
+{
+	std::array<char, 32> buffer;
+	auto result = std::to_chars(buffer.data(), buffer.data() + buffer.size(), value);
+	text.append(buffer.data(), result.ptr);
+}
+
+/// @brief Substitute the arguments of a record in its format string
+static void format_record(const AsyncLogger::Record &record, std::string_view payload, std::string &text)
+{
+	std::string_view format = (nullptr != record.format) ? std::string_view(record.format) : std::string_view("{}");
+	std::size_t argument = 0;
+	std::size_t payloadOffset = 0;
+	for (std::size_t i = 0; i < format.size(); i++)
+	{
+		if ((format[i] != '{') || (i + 1 >= format.size()) || (format[i + 1] != '}') || (argument >= record.numberOfArguments))
+		{
+			text.push_back(format[i]);
+			continue;
+		}
+
+		std::uint64_t value = record.arguments[argument];
+		switch (record.types[argument])
+		{
+			case AsyncLogger::ArgumentType::Signed:
+				append_number(text, static_cast<std::int64_t>(value));
+				break;
+
+			case AsyncLogger::ArgumentType::Unsigned:
+				append_number(text, value);
+				break;
+
+			case AsyncLogger::ArgumentType::Floating:
+			{
+				double floating;
+				std::memcpy(&floating, &value, sizeof(floating));
+				append_number(text, floating);
+			}
+			break;
+
+			case AsyncLogger::ArgumentType::Boolean:
+				text.append(value ? "true" : "false");
+				break;
+
+			case AsyncLogger::ArgumentType::String:
+				text.append(payload.substr(std::min<std::size_t>(payloadOffset, payload.size()), value));
+				payloadOffset += value;
+				break;
+		}
+		argument++;
+		i++;
+	}
+}
+
+/// @brief Move the log file aside, keeping a limited number of older files
+static void rotate_file()
+{
+	std::error_code error;
+	backend.file.close();
+	std::filesystem::remove(backend.filePath + "." + std::to_string(AsyncLogger::NUMBER_OF_ROTATED_FILES), error);
+	for (std::size_t i = AsyncLogger::NUMBER_OF_ROTATED_FILES - 1; i > 0; i--)
+	{
+		std::filesystem::rename(backend.filePath + "." + std::to_string(i), backend.filePath + "." + std::to_string(i + 1), error);
+	}
+	std::filesystem::rename(backend.filePath, backend.filePath + ".1", error);
+	backend.file.open(backend.filePath, std::ios::trunc);
+	backend.fileSize = 0;
+}
+
+/// @brief Format the records of all rings and write them, in the order they were logged
+static void drain()
+{
+	std::lock_guard<std::mutex> drainLock(backend.drainMutex);
+	std::size_t numberOfMessages = 0;
+	{
+		std::lock_guard<std::mutex> lock(backend.ringsMutex);
+		for (auto &ring : backend.rings)
+		{
+			std::size_t tail = ring->tail.load(std::memory_order_relaxed);
+			std::size_t head = ring->head.load(std::memory_order_acquire);
+			while (tail != head)
+			{
+				const auto &record = ring->records[tail & (AsyncLogger::RING_CAPACITY - 1)];
+				backend.payload.clear();
+				for (std::size_t i = 1; i <= record.numberOfExtensionRecords; i++)
+				{
+					backend.payload.append(reinterpret_cast<const char *>(&ring->records[(tail + i) & (AsyncLogger::RING_CAPACITY - 1)]), sizeof(AsyncLogger::Record));
+				}
+
+				if (numberOfMessages >= backend.messages.size())
+				{
+					backend.messages.emplace_back();
+				}
+				auto &message = backend.messages[numberOfMessages++];
+				message.timestamp_us = record.timestamp_us;
+				message.level = record.level;
+				message.hasPrefix = (nullptr != record.format);
+				message.text.clear();
+				format_record(record, backend.payload, message.text);
+				tail += 1 + record.numberOfExtensionRecords;
+			}
+			ring->tail.store(tail, std::memory_order_release);
+		}
+
+		// Rings of threads that have exited are removed once they are empty
+		std::erase_if(backend.rings, [](const std::shared_ptr<LogRing> &ring) {
+			return (1 == ring.use_count()) && (ring->head.load(std::memory_order_acquire) == ring->tail.load(std::memory_order_relaxed));
+		});
+	}
+
+	std::uint64_t numberOfDroppedRecords = backend.numberOfDroppedRecords.load(std::memory_order_relaxed);
+	if (numberOfDroppedRecords != backend.numberOfReportedDrops)
+	{
+		if (numberOfMessages >= backend.messages.size())
+		{
+			backend.messages.emplace_back();
+		}
+		auto &message = backend.messages[numberOfMessages++];
+		message.timestamp_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+		message.level = static_cast<std::uint8_t>(AsyncLogger::Level::Warning);
+		message.hasPrefix = true;
+		message.text = "Logging dropped " + std::to_string(numberOfDroppedRecords - backend.numberOfReportedDrops) + " records";
+		backend.numberOfReportedDrops = numberOfDroppedRecords;
+	}
+	if (0 == numberOfMessages)
+	{
+		return;
+	}
+
+	// Each ring is in order already, merging them by time keeps the threads interleaved as they logged
+	std::stable_sort(backend.messages.begin(), backend.messages.begin() + numberOfMessages, [](const LogMessage &a, const LogMessage &b) { return a.timestamp_us < b.timestamp_us; });
+
+	backend.consoleOutput.clear();
+	backend.fileOutput.clear();
+	std::time_t lastSecond = -1;
+	std::array<char, 32> timeText = {};
+	for (std::size_t i = 0; i < numberOfMessages; i++)
+	{
+		const auto &message = backend.messages[i];
+		const char *prefix = message.hasPrefix ? get_level_prefix(message.level) : "";
+		backend.consoleOutput.append(prefix).append(message.text).push_back('\n');
+
+		if (backend.file.is_open())
+		{
+			std::time_t second = static_cast<std::time_t>(message.timestamp_us / 1000000);
+			if (second != lastSecond)
+			{
+				std::tm localTime = Platform::get_local_time(second);
+				std::strftime(timeText.data(), timeText.size(), "%Y-%m-%d %H:%M:%S", &localTime);
+				lastSecond = second;
+			}
+			std::array<char, 8> milliseconds;
+			std::snprintf(milliseconds.data(), milliseconds.size(), ".%03d ", static_cast<int>((message.timestamp_us / 1000) % 1000));
+			backend.fileOutput.append(timeText.data()).append(milliseconds.data()).append(prefix).append(message.text).push_back('\n');
+		}
+	}
+
+	std::streambuf *console = (nullptr != backend.console) ? backend.console : std::cout.rdbuf();
+	console->sputn(backend.consoleOutput.data(), static_cast<std::streamsize>(backend.consoleOutput.size()));
+	console->pubsync();
+	if (backend.file.is_open())
+	{
+		backend.file.write(backend.fileOutput.data(), static_cast<std::streamsize>(backend.fileOutput.size()));
+		backend.file.flush();
+		backend.fileSize += backend.fileOutput.size();
+		if (backend.fileSize >= AsyncLogger::MAX_FILE_SIZE)
+		{
+			rotate_file();
+		}
+	}
+}
+
+static void background_thread()
+{
+	std::unique_lock<std::mutex> lock(backend.threadMutex);
+	while (!backend.isStopRequested)
+	{
+		// Polling keeps the threads that log from having to wake this one up
+		backend.stopCondition.wait_for(lock, std::chrono::milliseconds(10), []() { return backend.isStopRequested; });
+		lock.unlock();
+		drain();
+		lock.lock();
+	}
+}
+
+bool AsyncLogger::start(std::streambuf *console, const std::string &filePath)
+{
+	stop();
+
+	backend.console = console;
+	backend.filePath = filePath;
+	backend.file.close();
+	if (!filePath.empty())
+	{
+		backend.file.open(filePath, std::ios::app);
+		if (!backend.file.is_open())
+		{
+			return false;
+		}
+		std::error_code error;
+		auto size = std::filesystem::file_size(filePath, error);
+		backend.fileSize = error ? 0 : size;
+	}
+
+	backend.isStopRequested = false;
+	backend.isStopped = false;
+	backend.isRunning = true;
+	backend.thread = std::thread(background_thread);
+	return true;
+}
+
+void AsyncLogger::stop()
+{
+	if (backend.isRunning)
+	{
+		{
+			std::lock_guard<std::mutex> lock(backend.threadMutex);
+			backend.isStopRequested = true;
+		}
+		backend.stopCondition.notify_one();
+		backend.thread.join();
+		backend.isRunning = false;
+	}
+	backend.isStopped = true;
+	drain();
+}
+
+void AsyncLogger::log_text(std::string_view text)
+{
+	log(Level::Info, nullptr, text);
+}
+
+std::uint64_t AsyncLogger::get_number_of_dropped_records()
+{
+	return backend.numberOfDroppedRecords.load(std::memory_order_relaxed);
+}
+
+void AsyncLogger::push(Record &record, const std::array<std::string_view, MAX_NUMBER_OF_ARGUMENTS> &strings)
+{
+	if (nullptr == threadRing)
+	{
+		threadRing = std::make_shared<LogRing>();
+		std::lock_guard<std::mutex> lock(backend.ringsMutex);
+		backend.rings.push_back(threadRing);
+	}
+	auto &ring = *threadRing;
+
+	std::size_t payloadSize = 0;
+	for (std::size_t i = 0; i < record.numberOfArguments; i++)
+	{
+		if (ArgumentType::String == record.types[i])
+		{
+			payloadSize += strings[i].size();
+		}
+	}
+	std::size_t numberOfExtensionRecords = (payloadSize + sizeof(Record) - 1) / sizeof(Record);
+	record.numberOfExtensionRecords = static_cast<std::uint8_t>(numberOfExtensionRecords);
+
+	std::size_t head = ring.head.load(std::memory_order_relaxed);
+	if ((RING_CAPACITY - (head - ring.tail.load(std::memory_order_acquire))) < (1 + numberOfExtensionRecords))
+	{
+		backend.numberOfDroppedRecords.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	ring.records[head & (RING_CAPACITY - 1)] = record;
+	if (numberOfExtensionRecords > 0)
+	{
+		// The strings are concatenated over the records that follow, which may wrap around the end of the ring
+		std::size_t offset = 0;
+		for (std::size_t i = 0; i < record.numberOfArguments; i++)
+		{
+			if (ArgumentType::String != record.types[i])
+			{
+				continue;
+			}
+			for (std::size_t copied = 0; copied < strings[i].size();)
+			{
+				auto *destination = reinterpret_cast<char *>(&ring.records[(head + 1 + offset / sizeof(Record)) & (RING_CAPACITY - 1)]) + (offset % sizeof(Record));
+				std::size_t length = std::min(strings[i].size() - copied, sizeof(Record) - (offset % sizeof(Record)));
+				std::memcpy(destination, strings[i].data() + copied, length);
+				copied += length;
+				offset += length;
+			}
+		}
+	}
+	ring.head.store(head + 1 + numberOfExtensionRecords, std::memory_order_release);
+
+	if (backend.isStopped.load(std::memory_order_relaxed))
+	{
+		drain();
+	}
+}
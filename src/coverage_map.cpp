@@ -0,0 +1,385 @@
+/**
+ * @author Daan Steenbergen
+ * @brief A tile based coverage map for position based section control
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright 2026 Daan Steenbergen
+ */
+#include "coverage_map.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <limits>
+
+static constexpr double METERS_PER_DEGREE_LATITUDE = 111194.93; // Mean earth radius * pi / 180
+static constexpr double DEGREES_TO_RADIANS = 3.14159265358979323846 / 180.0;
+
+CoverageMap::CoverageMap(double cellSize_m, std::size_t maxTiles) :
+  cellSize_m(cellSize_m)
+{
+	set_max_tiles(maxTiles);
+}
+
+void CoverageMap::set_max_tiles(std::size_t newMaxTiles)
+{
+	clear();
+	maxTiles = std::max<std::size_t>(newMaxTiles, 1);
+
+	// Keep the load factor at or below 50%, so the table never has to grow
+	std::size_t numberOfSlots = 1;
+	while (numberOfSlots < 2 * maxTiles)
+	{
+		numberOfSlots <<= 1;
+	}
+	slots.assign(numberOfSlots, NO_TILE);
+}
+
+void CoverageMap::set_sections(std::vector<SectionGeometry> newSections)
+{
+	sections = std::move(newSections);
+	previousEdges.assign(sections.size(), {});
+	previousSectionsOn.clear();
+	sectionCoverage.assign(sections.size(), 0.0);
+	hasPreviousFix = false;
+}
+
+const std::vector<CoverageMap::SectionGeometry> &CoverageMap::get_sections() const
+{
+	return sections;
+}
+
+void CoverageMap::set_overlap_threshold(double threshold)
+{
+	overlapThreshold = std::clamp(threshold, 0.0, 1.0);
+}
+
+void CoverageMap::update(double latitude, double longitude, double heading_deg, const SectionMask &sectionsOn, double lookAhead_m)
+{
+	Point position = to_local(latitude, longitude);
+	double heading_rad = heading_deg * DEGREES_TO_RADIANS;
+	Point forward = { std::sin(heading_rad), std::cos(heading_rad) };
+	Point right = { forward.y, -forward.x };
+
+	bool isJump = hasPreviousFix && (std::hypot(position.x - previousPosition.x, position.y - previousPosition.y) > MAXIMUM_POSITION_JUMP_M);
+
+	for (std::size_t i = 0; i < sections.size(); i++)
+	{
+		const auto &section = sections[i];
+		Point center = { position.x + forward.x * section.xOffset_m + right.x * section.yOffset_m,
+			               position.y + forward.y * section.xOffset_m + right.y * section.yOffset_m };
+		double halfWidth = section.width_m / 2.0;
+		std::array<Point, 2> edges = { { { center.x - right.x * halfWidth, center.y - right.y * halfWidth },
+			                               { center.x + right.x * halfWidth, center.y + right.y * halfWidth } } };
+
+		// Evaluate just beyond the swath we're about to paint, otherwise every section would cover itself
+		double ahead = std::max(lookAhead_m, 0.0) + cellSize_m;
+		Point aheadOffset = { forward.x * ahead, forward.y * ahead };
+		sectionCoverage[i] = get_coverage({ edges[0].x + aheadOffset.x, edges[0].y + aheadOffset.y },
+		                                  { edges[1].x + aheadOffset.x, edges[1].y + aheadOffset.y });
+
+		bool isOn = sectionsOn.test(static_cast<std::uint16_t>(i));
+		if (hasPreviousFix && !isJump && isOn && previousSectionsOn.test(static_cast<std::uint16_t>(i)))
+		{
+			paint_quad({ previousEdges[i][0], previousEdges[i][1], edges[1], edges[0] });
+		}
+		previousEdges[i] = edges;
+		previousSectionsOn.set(static_cast<std::uint16_t>(i), isOn);
+	}
+	previousPosition = position;
+	hasPreviousFix = true;
+}
+
+bool CoverageMap::is_section_covered(std::uint8_t section) const
+{
+	return get_section_coverage(section) > overlapThreshold;
+}
+
+double CoverageMap::get_section_coverage(std::uint8_t section) const
+{
+	if (section < sectionCoverage.size())
+	{
+		return sectionCoverage[section];
+	}
+	return 0.0;
+}
+
+void CoverageMap::paint_quad(const std::array<Point, 4> &quad)
+{
+	double minY = std::numeric_limits<double>::max();
+	double maxY = std::numeric_limits<double>::lowest();
+	for (const auto &corner : quad)
+	{
+		minY = std::min(minY, corner.y);
+		maxY = std::max(maxY, corner.y);
+	}
+
+	// Scanline fill, a cell is covered when its center is inside the quad
+	auto firstRow = static_cast<std::int32_t>(std::ceil(minY / cellSize_m - 0.5));
+	auto lastRow = static_cast<std::int32_t>(std::floor(maxY / cellSize_m - 0.5));
+	for (std::int32_t row = firstRow; row <= lastRow; row++)
+	{
+		double y = (row + 0.5) * cellSize_m;
+		double minX = std::numeric_limits<double>::max();
+		double maxX = std::numeric_limits<double>::lowest();
+		for (std::size_t i = 0; i < quad.size(); i++)
+		{
+			const auto &a = quad[i];
+			const auto &b = quad[(i + 1) % quad.size()];
+			if (((a.y <= y) && (y < b.y)) || ((b.y <= y) && (y < a.y)))
+			{
+				double x = a.x + (y - a.y) * (b.x - a.x) / (b.y - a.y);
+				minX = std::min(minX, x);
+				maxX = std::max(maxX, x);
+			}
+		}
+		if (minX <= maxX)
+		{
+			auto firstColumn = static_cast<std::int32_t>(std::ceil(minX / cellSize_m - 0.5));
+			auto lastColumn = static_cast<std::int32_t>(std::floor(maxX / cellSize_m - 0.5));
+			if (firstColumn <= lastColumn)
+			{
+				fill_span(row, firstColumn, lastColumn);
+			}
+		}
+	}
+}
+
+double CoverageMap::get_coverage(Point from, Point to) const
+{
+	double length = std::hypot(to.x - from.x, to.y - from.y);
+	auto numberOfSamples = std::max<std::int32_t>(1, static_cast<std::int32_t>(std::ceil(length / cellSize_m)));
+
+	std::int32_t covered = 0;
+	for (std::int32_t i = 0; i < numberOfSamples; i++)
+	{
+		double t = (i + 0.5) / numberOfSamples;
+		if (is_covered({ from.x + (to.x - from.x) * t, from.y + (to.y - from.y) * t }))
+		{
+			covered++;
+		}
+	}
+	return static_cast<double>(covered) / numberOfSamples;
+}
+
+bool CoverageMap::is_covered(Point point) const
+{
+	auto cellX = static_cast<std::int32_t>(std::floor(point.x / cellSize_m));
+	auto cellY = static_cast<std::int32_t>(std::floor(point.y / cellSize_m));
+	const Tile *tile = find_tile(cellX >> TILE_SHIFT, cellY >> TILE_SHIFT);
+	if (nullptr == tile)
+	{
+		return false;
+	}
+	std::int32_t column = cellX & (TILE_SIZE - 1);
+	std::uint64_t word = tile->rows[(cellY & (TILE_SIZE - 1)) * WORDS_PER_ROW + column / 64];
+	return (word >> (column % 64)) & 1;
+}
+
+void CoverageMap::clear()
+{
+	tiles.clear();
+	std::fill(slots.begin(), slots.end(), NO_TILE);
+	oldestTile = NO_TILE;
+	newestTile = NO_TILE;
+	hasOrigin = false;
+	hasPreviousFix = false;
+	numberOfCoveredCells = 0;
+}
+
+double CoverageMap::get_covered_area() const
+{
+	return static_cast<double>(numberOfCoveredCells) * cellSize_m * cellSize_m;
+}
+
+std::size_t CoverageMap::get_number_of_tiles() const
+{
+	return tiles.size();
+}
+
+std::size_t CoverageMap::get_memory_usage() const
+{
+	return tiles.size() * sizeof(Tile) + slots.size() * sizeof(std::int32_t);
+}
+
+std::uint64_t CoverageMap::make_key(std::int32_t tileX, std::int32_t tileY)
+{
+	return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(tileX)) << 32) | static_cast<std::uint32_t>(tileY);
+}
+
+std::size_t CoverageMap::get_home_slot(std::uint64_t key) const
+{
+	// splitmix64 finalizer, neighbouring tiles end up far apart in the table
+	key ^= key >> 30;
+	key *= 0xbf58476d1ce4e5b9ULL;
+	key ^= key >> 27;
+	key *= 0x94d049bb133111ebULL;
+	key ^= key >> 31;
+	return static_cast<std::size_t>(key) & (slots.size() - 1);
+}
+
+const CoverageMap::Tile *CoverageMap::find_tile(std::int32_t tileX, std::int32_t tileY) const
+{
+	std::uint64_t key = make_key(tileX, tileY);
+	for (std::size_t slot = get_home_slot(key);; slot = (slot + 1) & (slots.size() - 1))
+	{
+		if (NO_TILE == slots[slot])
+		{
+			return nullptr;
+		}
+		const Tile *tile = tiles[slots[slot]].get();
+		if (tile->key == key)
+		{
+			return tile;
+		}
+	}
+}
+
+CoverageMap::Tile *CoverageMap::get_or_create_tile(std::int32_t tileX, std::int32_t tileY)
+{
+	std::uint64_t key = make_key(tileX, tileY);
+	std::size_t slot = get_home_slot(key);
+	for (; NO_TILE != slots[slot]; slot = (slot + 1) & (slots.size() - 1))
+	{
+		std::int32_t tileIndex = slots[slot];
+		Tile *tile = tiles[tileIndex].get();
+		if (tile->key == key)
+		{
+			if (tileIndex != newestTile)
+			{
+				unlink_tile(tileIndex);
+				link_newest_tile(tileIndex);
+			}
+			return tile;
+		}
+	}
+
+	std::int32_t tileIndex;
+	if (tiles.size() < maxTiles)
+	{
+		tileIndex = static_cast<std::int32_t>(tiles.size());
+		tiles.push_back(std::make_unique<Tile>());
+	}
+	else
+	{
+		// Recycle the tile that hasn't been touched for the longest time
+		tileIndex = oldestTile;
+		unlink_tile(tileIndex);
+		std::uint64_t oldestKey = tiles[tileIndex]->key;
+		for (std::size_t oldSlot = get_home_slot(oldestKey);; oldSlot = (oldSlot + 1) & (slots.size() - 1))
+		{
+			if (slots[oldSlot] == tileIndex)
+			{
+				remove_slot(oldSlot);
+				break;
+			}
+		}
+		tiles[tileIndex]->rows.fill(0);
+
+		// Removing may have shifted entries, find the insertion slot again
+		slot = get_home_slot(key);
+		while (NO_TILE != slots[slot])
+		{
+			slot = (slot + 1) & (slots.size() - 1);
+		}
+	}
+
+	Tile *tile = tiles[tileIndex].get();
+	tile->key = key;
+	link_newest_tile(tileIndex);
+	slots[slot] = tileIndex;
+	return tile;
+}
+
+void CoverageMap::unlink_tile(std::int32_t tileIndex)
+{
+	Tile &tile = *tiles[tileIndex];
+	if (NO_TILE != tile.older)
+	{
+		tiles[tile.older]->newer = tile.newer;
+	}
+	else
+	{
+		oldestTile = tile.newer;
+	}
+	if (NO_TILE != tile.newer)
+	{
+		tiles[tile.newer]->older = tile.older;
+	}
+	else
+	{
+		newestTile = tile.older;
+	}
+	tile.older = NO_TILE;
+	tile.newer = NO_TILE;
+}
+
+void CoverageMap::link_newest_tile(std::int32_t tileIndex)
+{
+	Tile &tile = *tiles[tileIndex];
+	tile.older = newestTile;
+	tile.newer = NO_TILE;
+	if (NO_TILE != newestTile)
+	{
+		tiles[newestTile]->newer = tileIndex;
+	}
+	else
+	{
+		oldestTile = tileIndex;
+	}
+	newestTile = tileIndex;
+}
+
+void CoverageMap::remove_slot(std::size_t slot)
+{
+	// Backward shift deletion keeps the linear probing chains intact without tombstones
+	std::size_t mask = slots.size() - 1;
+	slots[slot] = NO_TILE;
+	for (std::size_t next = (slot + 1) & mask; NO_TILE != slots[next]; next = (next + 1) & mask)
+	{
+		std::size_t home = get_home_slot(tiles[slots[next]]->key);
+		bool canMove = (next > slot) ? ((home <= slot) || (home > next)) : ((home <= slot) && (home > next));
+		if (canMove)
+		{
+			slots[slot] = slots[next];
+			slots[next] = NO_TILE;
+			slot = next;
+		}
+	}
+}
+
+void CoverageMap::fill_span(std::int32_t cellY, std::int32_t cellX0, std::int32_t cellX1)
+{
+	std::int32_t row = cellY & (TILE_SIZE - 1);
+	for (std::int32_t tileX = cellX0 >> TILE_SHIFT; tileX <= (cellX1 >> TILE_SHIFT); tileX++)
+	{
+		Tile *tile = get_or_create_tile(tileX, cellY >> TILE_SHIFT);
+		std::int32_t first = std::max(cellX0, tileX * TILE_SIZE) - tileX * TILE_SIZE;
+		std::int32_t last = std::min(cellX1, tileX * TILE_SIZE + TILE_SIZE - 1) - tileX * TILE_SIZE;
+
+		// Set whole 64-cell words at once instead of cell by cell
+		std::uint64_t *words = &tile->rows[row * WORDS_PER_ROW];
+		for (std::int32_t word = first / 64; word <= last / 64; word++)
+		{
+			std::int32_t low = std::max(first, word * 64) - word * 64;
+			std::int32_t high = std::min(last, word * 64 + 63) - word * 64;
+			std::uint64_t mask = (~0ULL >> (63 - high)) & (~0ULL << low);
+			numberOfCoveredCells += std::popcount(mask & ~words[word]);
+			words[word] |= mask;
+		}
+	}
+}
+
+CoverageMap::Point CoverageMap::to_local(double latitude, double longitude)
+{
+	if (!hasOrigin)
+	{
+		// An equirectangular projection around the first fix is accurate enough for the size of a field
+		originLatitude = latitude;
+		originLongitude = longitude;
+		metersPerDegreeLongitude = METERS_PER_DEGREE_LATITUDE * std::cos(latitude * DEGREES_TO_RADIANS);
+		hasOrigin = true;
+	}
+	return { (longitude - originLongitude) * metersPerDegreeLongitude, (latitude - originLatitude) * METERS_PER_DEGREE_LATITUDE };
+}
@@ -0,0 +1,363 @@
+/**
+ * @author Daan Steenbergen
+ * @brief A live dashboard on localhost, updated with server-sent events
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright 2026 Daan Steenbergen
+ */
+#include "dashboard.hpp"
+#include "log_macros.hpp"
+#include "metrics.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <nlohmann/json.hpp>
+
+using boost::asio::ip::tcp;
+using json = nlohmann::json;
+
+constexpr std::size_t MAX_REQUEST_SIZE = 4096;
+constexpr std::chrono::seconds KEEP_ALIVE_INTERVAL(15); ///< Keeps proxies and browsers from closing an idle stream
+constexpr std::uint32_t CAN_BIT_RATE = 250000;
+constexpr std::uint32_t BITS_PER_FRAME = 128; ///< An extended frame with 8 data bytes, including typical bit stuffing
+
+static const char *const DASHBOARD_PAGE = R"HTML(<!DOCTYPE html>
+<html>
+<head>
+<meta charset="utf-8">
+<title>AOG-TaskController</title>
+<style>
+body { font-family: sans-serif; margin: 1em; background: #f4f4f4; }
+.client { background: #fff; border-radius: 6px; padding: 1em; margin-bottom: 1em; }
+.sections { display: flex; gap: 2px; margin: 0.5em 0; }
+.section { flex: 1; height: 2.5em; border-radius: 3px; font-size: 0.7em; text-align: center; line-height: 1.25em; color: #fff; }
+.s0 { background: #9e9e9e; } .s1 { background: #2e7d32; } .s2 { background: #c62828; } .s3 { background: #e0e0e0; color: #666; }
+.overridden { outline: 2px solid #f9a825; }
+table { border-collapse: collapse; font-size: 0.85em; }
+td, th { padding: 2px 8px; text-align: left; }
+#status { color: #666; }
+</style>
+</head>
+<body>
+<h2>AOG-TaskController</h2>
+<div id="status">Connecting...</div>
+<div id="clients"></div>
+<script>
+const stateNames = ["off", "on", "error", "not installed"];
+function render(state) {
+  document.getElementById("status").textContent = state.clients.length + " client(s), bus load " + state.busLoad.toFixed(1) + "%";
+  let html = "";
+  for (const client of state.clients) {
+    html += "<div class='client'><b>" + (client.designator || "Client") + "</b> NAME " + client.name + ", address " + client.address +
+      ", " + client.booms + " boom(s), section control " + (client.sectionControl ? "auto" : "manual");
+    for (const row of ["setpoint", "actual"]) {
+      html += "<div>" + row + "</div><div class='sections'>";
+      client.sections.forEach((section, index) => {
+        const state = row == "setpoint" ? section.setpoint : section.actual;
+        html += "<div class='section s" + state + (section.overridden ? " overridden" : "") + "' style='flex-grow:" + Math.max(section.width, 0.01) +
+          "' title='Section " + (index + 1) + ": " + stateNames[state] + ", x " + section.x + " m, y " + section.y + " m'>" + (index + 1) + "<br>" + section.width.toFixed(2) + " m</div>";
+      });
+      html += "</div>";
+    }
+    html += "<table><tr><th>DDI</th><th>Element</th><th>Trigger</th></tr>";
+    for (const subscription of client.subscriptions) {
+      const triggers = [];
+      if (subscription.onChange) triggers.push("on change");
+      if (subscription.interval > 0) triggers.push("every " + subscription.interval + " ms");
+      html += "<tr><td>" + subscription.ddi + "</td><td>" + subscription.element + "</td><td>" + triggers.join(", ") + "</td></tr>";
+    }
+    html += "</table></div>";
+  }
+  document.getElementById("clients").innerHTML = html;
+}
+const events = new EventSource("/events");
+events.onmessage = (event) => render(JSON.parse(event.data));
+events.onerror = () => document.getElementById("status").textContent = "Disconnected, retrying...";
+</script>
+</body>
+</html>
+)HTML";
+
+/// @brief A browser connection, either a single page request or a stream of events
+struct Dashboard::Connection : std::enable_shared_from_this<Connection>
+{
+	explicit Connection(tcp::socket socket) :
+	  socket(std::move(socket)),
+	  request(MAX_REQUEST_SIZE)
+	{
+	}
+
+	/// @brief Write data, while a write is in progress only the newest data is kept
+	void send(const std::string &data, bool isReplaceable)
+	{
+		if (isWriting)
+		{
+			if (isReplaceable)
+			{
+				pending = data; // A slow browser skips frames instead of queueing them
+			}
+			else
+			{
+				pending += data;
+			}
+			return;
+		}
+		writing = data;
+		write();
+	}
+
+	void write()
+	{
+		isWriting = true;
+		auto self = shared_from_this();
+		boost::asio::async_write(socket, boost::asio::buffer(writing), [self](const boost::system::error_code &error, std::size_t) {
+			self->isWriting = false;
+			if (error)
+			{
+				self->isClosed = true;
+				return;
+			}
+			if (!self->pending.empty())
+			{
+				self->writing.swap(self->pending);
+				self->pending.clear();
+				self->write();
+			}
+			else if (self->isClosedAfterWrite)
+			{
+				boost::system::error_code ignored;
+				self->socket.shutdown(tcp::socket::shutdown_both, ignored);
+			}
+		});
+	}
+
+	tcp::socket socket;
+	boost::asio::streambuf request;
+	std::string writing;
+	std::string pending;
+	std::array<char, 64> discard; ///< Anything the browser sends on an event stream
+	bool isWriting = false;
+	bool isClosed = false;
+	bool isClosedAfterWrite = false;
+};
+
+Dashboard::Dashboard() :
+  acceptor(ioContext),
+  frameTimer(ioContext)
+{
+}
+
+Dashboard::~Dashboard()
+{
+	stop();
+}
+
+bool Dashboard::start(std::uint16_t port, std::uint8_t frameRate)
+{
+	boost::system::error_code error;
+	tcp::endpoint endpoint(boost::asio::ip::address_v4::loopback(), port);
+	acceptor.open(endpoint.protocol(), error);
+	if (!error)
+	{
+		acceptor.set_option(tcp::acceptor::reuse_address(true), error);
+		acceptor.bind(endpoint, error);
+	}
+	if (!error)
+	{
+		acceptor.listen(boost::asio::socket_base::max_listen_connections, error);
+	}
+	if (error)
+	{
+		TC_LOG_ERROR("Unable to serve the dashboard on port {}: {}", port, error.message());
+		acceptor.close(error);
+		return false;
+	}
+
+	frameInterval = std::chrono::milliseconds(1000 / std::max<std::uint8_t>(frameRate, 1));
+	busLoadStart = std::chrono::steady_clock::now();
+	busLoadStartFrames = Metrics::get_number_of_can_frames();
+	accept();
+	schedule_frame();
+	thread = std::thread([this]() { ioContext.run(); });
+	TC_LOG_INFO("Serving the dashboard on http://127.0.0.1:{}/", port);
+	return true;
+}
+
+void Dashboard::stop()
+{
+	if (!thread.joinable())
+	{
+		return;
+	}
+	ioContext.stop();
+	thread.join();
+	boost::system::error_code ignored;
+	acceptor.close(ignored);
+	subscribers.clear();
+}
+
+DashboardSnapshot &Dashboard::get_back_buffer()
+{
+	return snapshots[backIndex];
+}
+
+void Dashboard::publish()
+{
+	backIndex = middleIndex.exchange(backIndex | NEW_SNAPSHOT, std::memory_order_acq_rel) & INDEX_MASK;
+}
+
+bool Dashboard::is_running() const
+{
+	return thread.joinable();
+}
+
+void Dashboard::accept()
+{
+	acceptor.async_accept([this](const boost::system::error_code &error, tcp::socket socket) {
+		if (boost::asio::error::operation_aborted == error)
+		{
+			return;
+		}
+		if (!error)
+		{
+			auto connection = std::make_shared<Connection>(std::move(socket));
+			boost::asio::async_read_until(connection->socket, connection->request, "\r\n\r\n", [this, connection](const boost::system::error_code &readError, std::size_t) {
+				if (readError)
+				{
+					return;
+				}
+				std::istream stream(&connection->request);
+				std::string method;
+				std::string target;
+				stream >> method >> target;
+
+				if (("GET" == method) && ("/events" == target))
+				{
+					connection->send("HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\nCache-Control: no-cache\r\nConnection: keep-alive\r\n\r\n", false);
+					if (!lastEvent.empty())
+					{
+						connection->send(lastEvent, false);
+					}
+					subscribers.push_back(connection);
+
+					// The browser doesn't send anything on the stream, a completed read means it went away
+					connection->socket.async_read_some(boost::asio::buffer(connection->discard), [connection](const boost::system::error_code &, std::size_t) {
+						connection->isClosed = true;
+					});
+					return;
+				}
+
+				std::string status = "200 OK";
+				std::string contentType = "text/html; charset=utf-8";
+				std::string body = DASHBOARD_PAGE;
+				if (("GET" != method) || ("/" != target))
+				{
+					status = "404 Not Found";
+					contentType = "text/plain";
+					body = "Not found\n";
+				}
+				connection->isClosedAfterWrite = true;
+				connection->send("HTTP/1.1 " + status + "\r\nContent-Type: " + contentType + "\r\nContent-Length: " + std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body, false);
+			});
+		}
+		accept();
+	});
+}
+
+void Dashboard::schedule_frame()
+{
+	frameTimer.expires_after(frameInterval);
+	frameTimer.async_wait([this](const boost::system::error_code &error) {
+		if (!error)
+		{
+			on_frame();
+			schedule_frame();
+		}
+	});
+}
+
+void Dashboard::on_frame()
+{
+	subscribers.erase(std::remove_if(subscribers.begin(), subscribers.end(), [](const std::shared_ptr<Connection> &connection) { return connection->isClosed; }), subscribers.end());
+
+	auto now = std::chrono::steady_clock::now();
+	if (now - busLoadStart >= std::chrono::seconds(1))
+	{
+		std::uint64_t frames = Metrics::get_number_of_can_frames();
+		double elapsed_s = std::chrono::duration<double>(now - busLoadStart).count();
+		busLoad_percent = static_cast<float>((frames - busLoadStartFrames) * BITS_PER_FRAME * 100.0 / (CAN_BIT_RATE * elapsed_s));
+		busLoadStart = now;
+		busLoadStartFrames = frames;
+	}
+
+	if (middleIndex.load(std::memory_order_acquire) & NEW_SNAPSHOT)
+	{
+		frontIndex = middleIndex.exchange(frontIndex, std::memory_order_acq_rel) & INDEX_MASK;
+	}
+
+	if (subscribers.empty())
+	{
+		lastEvent.clear(); // Formatted again for the next browser
+		return;
+	}
+
+	std::string event = "data: " + format_snapshot(snapshots[frontIndex]) + "\n\n";
+	if (event != lastEvent)
+	{
+		lastEvent = std::move(event);
+		lastPush = now;
+		for (auto &subscriber : subscribers)
+		{
+			subscriber->send(lastEvent, true);
+		}
+	}
+	else if (now - lastPush >= KEEP_ALIVE_INTERVAL)
+	{
+		lastPush = now;
+		for (auto &subscriber : subscribers)
+		{
+			subscriber->send(": keep-alive\n\n", false);
+		}
+	}
+}
+
+std::string Dashboard::format_snapshot(const DashboardSnapshot &snapshot)
+{
+	json state;
+	state["busLoad"] = static_cast<int>(busLoad_percent * 10) / 10.0; // Small fluctuations would push every frame
+	state["clients"] = json::array();
+	for (std::size_t i = 0; i < std::min<std::size_t>(snapshot.numberOfClients, snapshot.clients.size()); i++)
+	{
+		const auto &client = snapshot.clients[i];
+		std::array<char, 17> name;
+		std::snprintf(name.data(), name.size(), "%016llX", static_cast<unsigned long long>(client.name));
+
+		json clientState;
+		clientState["name"] = name.data();
+		clientState["address"] = client.address;
+		clientState["designator"] = client.designator;
+		clientState["sectionControl"] = client.isSectionControlEnabled;
+		clientState["booms"] = client.numberOfBooms;
+		clientState["sections"] = json::array();
+		for (const auto &section : client.sections)
+		{
+			clientState["sections"].push_back({ { "setpoint", section.setpointState },
+			                                    { "actual", section.actualState },
+			                                    { "overridden", section.isOverridden },
+			                                    { "x", section.xOffset_m },
+			                                    { "y", section.yOffset_m },
+			                                    { "width", section.width_m } });
+		}
+		clientState["subscriptions"] = json::array();
+		for (const auto &subscription : client.subscriptions)
+		{
+			clientState["subscriptions"].push_back({ { "ddi", subscription.ddi },
+			                                         { "element", subscription.elementNumber },
+			                                         { "interval", subscription.timeInterval_ms },
+			                                         { "onChange", subscription.isOnChange } });
+		}
+		state["clients"].push_back(std::move(clientState));
+	}
+	return state.dump();
+}
@@ -0,0 +1,490 @@
+/**
+ * @author Daan Steenbergen
+ * @brief A journal of typed binary events, rotated and compressed in the background
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright 2026 Daan Steenbergen
+ */
+#include "event_journal.hpp"
+#include "app_clock.hpp"
+#include "journal_codec.hpp"
+#include "log_macros.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <iterator>
+
+constexpr std::uint16_t SEGMENT_VERSION = 1;
+constexpr std::size_t SEGMENT_HEADER_SIZE = 8; ///< Magic, version and two reserved bytes
+constexpr std::size_t EVENT_HEADER_SIZE = 10; ///< Type, payload size and timestamp
+
+/// @brief Write a value in little endian byte order
+template<typename T>
+static std::size_t put_value(std::uint8_t *destination, T value)
+{
+	for (std::size_t i = 0; i < sizeof(T); i++)
+	{
+		destination[i] = static_cast<std::uint8_t>(static_cast<std::uint64_t>(value) >> (8 * i));
+	}
+	return sizeof(T);
+}
+
+/// @brief Read a value in little endian byte order
+template<typename T>
+static T get_value(const std::uint8_t *source)
+{
+	std::uint64_t value = 0;
+	for (std::size_t i = 0; i < sizeof(T); i++)
+	{
+		value |= static_cast<std::uint64_t>(source[i]) << (8 * i);
+	}
+	return static_cast<T>(value);
+}
+
+/// @brief Format a timestamp as ISO 8601 in UTC, with microseconds
+static std::string format_time(std::int64_t timestamp_us)
+{
+	std::chrono::sys_time<std::chrono::microseconds> time{ std::chrono::microseconds(timestamp_us) };
+	auto day = std::chrono::floor<std::chrono::days>(time);
+	std::chrono::year_month_day date(day);
+	std::chrono::hh_mm_ss<std::chrono::microseconds> timeOfDay(time - day);
+	std::array<char, 40> text;
+	std::snprintf(text.data(),
+	              text.size(),
+	              "%04d-%02u-%02uT%02d:%02d:%02d.%06dZ",
+	              static_cast<int>(date.year()),
+	              static_cast<unsigned>(date.month()),
+	              static_cast<unsigned>(date.day()),
+	              static_cast<int>(timeOfDay.hours().count()),
+	              static_cast<int>(timeOfDay.minutes().count()),
+	              static_cast<int>(timeOfDay.seconds().count()),
+	              static_cast<int>(timeOfDay.subseconds().count()));
+	return text.data();
+}
+
+static std::string format_name(std::uint64_t name)
+{
+	std::array<char, 17> text;
+	std::snprintf(text.data(), text.size(), "%016llX", static_cast<unsigned long long>(name));
+	return text.data();
+}
+
+EventJournal::~EventJournal()
+{
+	close();
+}
+
+bool EventJournal::open(const std::string &directory)
+{
+	close();
+	segmentDirectory = directory;
+
+	// Segments of earlier runs were not compressed when the application didn't stop normally
+	std::error_code error;
+	for (const auto &entry : std::filesystem::directory_iterator(directory, error))
+	{
+		if (entry.path().extension() == SEGMENT_EXTENSION)
+		{
+			segmentsToCompress.push_back(entry.path().string());
+		}
+	}
+
+	if (!open_segment())
+	{
+		TC_LOG_ERROR("Unable to open event journal in {}", directory);
+		segmentsToCompress.clear();
+		return false;
+	}
+	isStopRequested = false;
+	compressionThread = std::thread(&EventJournal::compression_thread, this);
+	return true;
+}
+
+void EventJournal::close()
+{
+	if (!segmentFile.is_open())
+	{
+		return;
+	}
+
+	segmentFile.close();
+	{
+		std::lock_guard<std::mutex> lock(compressionMutex);
+		segmentsToCompress.push_back(segmentPath);
+		isStopRequested = true;
+	}
+	compressionCondition.notify_one();
+	compressionThread.join();
+	lastSectionStates.clear();
+}
+
+void EventJournal::flush()
+{
+	if (segmentFile.is_open())
+	{
+		segmentFile.flush();
+	}
+}
+
+void EventJournal::log_client_connected(std::uint64_t clientName, std::uint8_t address)
+{
+	std::array<std::uint8_t, 9> payload;
+	std::size_t size = put_value(payload.data(), clientName);
+	size += put_value(payload.data() + size, address);
+	write_event(EventType::ClientConnected, payload.data(), static_cast<std::uint8_t>(size));
+}
+
+void EventJournal::log_client_disconnected(std::uint64_t clientName)
+{
+	std::array<std::uint8_t, 8> payload;
+	std::size_t size = put_value(payload.data(), clientName);
+	write_event(EventType::ClientDisconnected, payload.data(), static_cast<std::uint8_t>(size));
+	lastSectionStates.erase(clientName);
+}
+
+void EventJournal::log_pool_activated(std::uint64_t clientName, std::uint8_t numberOfSections, std::uint8_t numberOfBooms)
+{
+	std::array<std::uint8_t, 10> payload;
+	std::size_t size = put_value(payload.data(), clientName);
+	size += put_value(payload.data() + size, numberOfSections);
+	size += put_value(payload.data() + size, numberOfBooms);
+	write_event(EventType::PoolActivated, payload.data(), static_cast<std::uint8_t>(size));
+}
+
+void EventJournal::log_section_change(std::uint64_t clientName, std::uint8_t numberOfSections, const SectionMask &actualStates)
+{
+	auto it = lastSectionStates.find(clientName);
+	if ((it != lastSectionStates.end()) && (it->second == actualStates))
+	{
+		return;
+	}
+	lastSectionStates[clientName] = actualStates;
+
+	// Only the bytes that hold sections are written
+	std::array<std::uint8_t, 9 + 32> payload;
+	std::size_t size = put_value(payload.data(), clientName);
+	size += put_value(payload.data() + size, numberOfSections);
+	for (std::size_t i = 0; i < (numberOfSections + 7u) / 8u; i++)
+	{
+		payload[size++] = static_cast<std::uint8_t>(actualStates.words[i / 8] >> (8 * (i % 8)));
+	}
+	write_event(EventType::SectionChange, payload.data(), static_cast<std::uint8_t>(size));
+}
+
+void EventJournal::log_process_data_acknowledge_error(std::uint64_t clientName, std::uint16_t ddi, std::uint16_t elementNumber, std::uint8_t errorCodes, std::uint8_t command)
+{
+	std::array<std::uint8_t, 14> payload;
+	std::size_t size = put_value(payload.data(), clientName);
+	size += put_value(payload.data() + size, ddi);
+	size += put_value(payload.data() + size, elementNumber);
+	size += put_value(payload.data() + size, errorCodes);
+	size += put_value(payload.data() + size, command);
+	write_event(EventType::ProcessDataAcknowledgeError, payload.data(), static_cast<std::uint8_t>(size));
+}
+
+void EventJournal::log_subnet_change(const std::array<std::uint8_t, 3> &subnet)
+{
+	write_event(EventType::SubnetChange, subnet.data(), static_cast<std::uint8_t>(subnet.size()));
+}
+
+bool EventJournal::read_segment(const std::string &path, std::vector<std::uint8_t> &events)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open())
+	{
+		return false;
+	}
+	std::vector<std::uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+	if ((data.size() >= 12) && std::equal(COMPRESSED_MAGIC.begin(), COMPRESSED_MAGIC.end(), data.begin()))
+	{
+		std::uint64_t originalSize = get_value<std::uint64_t>(data.data() + 4);
+		std::vector<std::uint8_t> compressed(data.begin() + 12, data.end());
+		if (!JournalCodec::decompress(compressed, static_cast<std::size_t>(originalSize), data))
+		{
+			return false;
+		}
+	}
+
+	if ((data.size() < SEGMENT_HEADER_SIZE) || !std::equal(SEGMENT_MAGIC.begin(), SEGMENT_MAGIC.end(), data.begin()) ||
+	    (get_value<std::uint16_t>(data.data() + 4) != SEGMENT_VERSION))
+	{
+		return false;
+	}
+	events.assign(data.begin() + SEGMENT_HEADER_SIZE, data.end());
+	return true;
+}
+
+bool EventJournal::decode(const std::vector<std::uint8_t> &events, Format format, std::ostream &output)
+{
+	bool isJson = (Format::Json == format);
+	std::string line;
+	std::size_t position = 0;
+	while (position + EVENT_HEADER_SIZE <= events.size())
+	{
+		auto type = static_cast<EventType>(events[position]);
+		std::uint8_t payloadSize = events[position + 1];
+		auto timestamp_us = get_value<std::int64_t>(events.data() + position + 2);
+		if (position + EVENT_HEADER_SIZE + payloadSize > events.size())
+		{
+			return false;
+		}
+		const std::uint8_t *payload = events.data() + position + EVENT_HEADER_SIZE;
+		position += EVENT_HEADER_SIZE + payloadSize;
+
+		// Fields are added as key/value pairs, so both formats share the decoding
+		line.clear();
+		auto add_field = [&line, isJson](const char *key, const std::string &value, bool isString) {
+			if (isJson)
+			{
+				line.append(",\"").append(key).append("\":");
+				line.append(isString ? "\"" : "").append(value).append(isString ? "\"" : "");
+			}
+			else
+			{
+				line.append(" ").append(key).append("=").append(value);
+			}
+		};
+		auto add_type = [&line, isJson, timestamp_us](const char *name) {
+			if (isJson)
+			{
+				line.append("{\"time\":\"").append(format_time(timestamp_us)).append("\",\"type\":\"").append(name).append("\"");
+			}
+			else
+			{
+				line.append(format_time(timestamp_us)).append(" ").append(name);
+			}
+		};
+
+		switch (type)
+		{
+			case EventType::ClientConnected:
+			{
+				add_type("ClientConnected");
+				add_field("name", format_name(get_value<std::uint64_t>(payload)), true);
+				add_field("address", std::to_string(payload[8]), false);
+			}
+			break;
+
+			case EventType::ClientDisconnected:
+			{
+				add_type("ClientDisconnected");
+				add_field("name", format_name(get_value<std::uint64_t>(payload)), true);
+			}
+			break;
+
+			case EventType::PoolActivated:
+			{
+				add_type("PoolActivated");
+				add_field("name", format_name(get_value<std::uint64_t>(payload)), true);
+				add_field("sections", std::to_string(payload[8]), false);
+				add_field("booms", std::to_string(payload[9]), false);
+			}
+			break;
+
+			case EventType::SectionChange:
+			{
+				add_type("SectionChange");
+				add_field("name", format_name(get_value<std::uint64_t>(payload)), true);
+				std::string states;
+				for (std::size_t i = 0; (i < payload[8]) && (9 + i / 8 < payloadSize); i++)
+				{
+					states.push_back(((payload[9 + i / 8] >> (i % 8)) & 0x01) ? '1' : '0');
+				}
+				add_field("states", states, true);
+			}
+			break;
+
+			case EventType::ProcessDataAcknowledgeError:
+			{
+				add_type("ProcessDataAcknowledgeError");
+				add_field("name", format_name(get_value<std::uint64_t>(payload)), true);
+				add_field("ddi", std::to_string(get_value<std::uint16_t>(payload + 8)), false);
+				add_field("element", std::to_string(get_value<std::uint16_t>(payload + 10)), false);
+				add_field("errorCodes", std::to_string(payload[12]), false);
+				add_field("command", std::to_string(payload[13]), false);
+			}
+			break;
+
+			case EventType::SubnetChange:
+			{
+				add_type("SubnetChange");
+				add_field("subnet", std::to_string(payload[0]) + "." + std::to_string(payload[1]) + "." + std::to_string(payload[2]), true);
+			}
+			break;
+
+			default:
+			{
+				// Events of a newer version are skipped, their size is known
+				add_type("Unknown");
+				add_field("eventType", std::to_string(static_cast<int>(type)), false);
+			}
+			break;
+		}
+		line.append(isJson ? "}\n" : "\n");
+		output.write(line.data(), static_cast<std::streamsize>(line.size()));
+	}
+	return position == events.size();
+}
+
+void EventJournal::write_event(EventType type, const std::uint8_t *payload, std::uint8_t payloadSize)
+{
+	if (!segmentFile.is_open())
+	{
+		return;
+	}
+
+	std::array<std::uint8_t, EVENT_HEADER_SIZE> header;
+	header[0] = static_cast<std::uint8_t>(type);
+	header[1] = payloadSize;
+	put_value(header.data() + 2, std::chrono::duration_cast<std::chrono::microseconds>(AppClock::get_wall_time().time_since_epoch()).count());
+	segmentFile.write(reinterpret_cast<const char *>(header.data()), header.size());
+	segmentFile.write(reinterpret_cast<const char *>(payload), payloadSize);
+	segmentSize += header.size() + payloadSize;
+
+	if (segmentSize >= MAX_SEGMENT_SIZE)
+	{
+		segmentFile.close();
+		{
+			std::lock_guard<std::mutex> lock(compressionMutex);
+			segmentsToCompress.push_back(segmentPath);
+		}
+		compressionCondition.notify_one();
+		if (!open_segment())
+		{
+			TC_LOG_ERROR("Stopped the event journal. (Failed to open a new segment)");
+		}
+	}
+}
+
+bool EventJournal::open_segment()
+{
+	// The start time in the name keeps the segments of all runs in order
+	auto now = std::chrono::floor<std::chrono::seconds>(AppClock::get_wall_time());
+	auto day = std::chrono::floor<std::chrono::days>(now);
+	std::chrono::year_month_day date(day);
+	std::chrono::hh_mm_ss<std::chrono::seconds> timeOfDay(now - day);
+	std::array<char, 64> name;
+	std::filesystem::path compressedPath;
+	do
+	{
+		// A replay runs at the time of the recorded session, so the names of that session may be taken already
+		std::snprintf(name.data(),
+		              name.size(),
+		              "journal_%04d%02u%02u-%02d%02d%02d_%04u",
+		              static_cast<int>(date.year()),
+		              static_cast<unsigned>(date.month()),
+		              static_cast<unsigned>(date.day()),
+		              static_cast<int>(timeOfDay.hours().count()),
+		              static_cast<int>(timeOfDay.minutes().count()),
+		              static_cast<int>(timeOfDay.seconds().count()),
+		              static_cast<unsigned>(segmentNumber++));
+		segmentPath = segmentDirectory + "/" + name.data() + SEGMENT_EXTENSION;
+		compressedPath = segmentPath;
+		compressedPath.replace_extension(COMPRESSED_EXTENSION);
+	} while (std::filesystem::exists(segmentPath) || std::filesystem::exists(compressedPath));
+
+	segmentFile.open(segmentPath, std::ios::binary | std::ios::trunc);
+	if (!segmentFile.is_open())
+	{
+		return false;
+	}
+	std::array<std::uint8_t, SEGMENT_HEADER_SIZE> header = {};
+	std::copy(SEGMENT_MAGIC.begin(), SEGMENT_MAGIC.end(), header.begin());
+	put_value(header.data() + 4, SEGMENT_VERSION);
+	segmentFile.write(reinterpret_cast<const char *>(header.data()), header.size());
+	segmentSize = header.size();
+	return true;
+}
+
+void EventJournal::compression_thread()
+{
+	std::unique_lock<std::mutex> lock(compressionMutex);
+	while (true)
+	{
+		compressionCondition.wait(lock, [this]() { return isStopRequested || !segmentsToCompress.empty(); });
+		if (segmentsToCompress.empty())
+		{
+			break; // Only stops once everything is compressed
+		}
+
+		std::string path = segmentsToCompress.front();
+		segmentsToCompress.pop_front();
+		lock.unlock();
+		if (compress_segment(path))
+		{
+			remove_old_segments();
+		}
+		lock.lock();
+	}
+}
+
+bool EventJournal::compress_segment(const std::string &path)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open())
+	{
+		return false;
+	}
+	std::vector<std::uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	file.close();
+	auto compressed = JournalCodec::compress(data);
+
+	// Written under a temporary name first, so a crash never leaves a partial segment behind
+	std::filesystem::path compressedPath(path);
+	compressedPath.replace_extension(COMPRESSED_EXTENSION);
+	std::string temporaryPath = compressedPath.string() + ".tmp";
+	std::ofstream output(temporaryPath, std::ios::binary | std::ios::trunc);
+	if (!output.is_open())
+	{
+		TC_LOG_ERROR("Unable to compress journal segment {}", path);
+		return false;
+	}
+	std::array<std::uint8_t, 12> header;
+	std::copy(COMPRESSED_MAGIC.begin(), COMPRESSED_MAGIC.end(), header.begin());
+	put_value(header.data() + 4, static_cast<std::uint64_t>(data.size()));
+	output.write(reinterpret_cast<const char *>(header.data()), header.size());
+	output.write(reinterpret_cast<const char *>(compressed.data()), static_cast<std::streamsize>(compressed.size()));
+	output.close();
+	if (!output)
+	{
+		TC_LOG_ERROR("Unable to compress journal segment {}", path);
+		return false;
+	}
+
+	std::error_code error;
+	std::filesystem::rename(temporaryPath, compressedPath, error);
+	if (error)
+	{
+		return false;
+	}
+	std::filesystem::remove(path, error);
+	return true;
+}
+
+void EventJournal::remove_old_segments()
+{
+	std::vector<std::filesystem::path> segments;
+	std::error_code error;
+	for (const auto &entry : std::filesystem::directory_iterator(segmentDirectory, error))
+	{
+		if (entry.path().extension() == COMPRESSED_EXTENSION)
+		{
+			segments.push_back(entry.path());
+		}
+	}
+	if (segments.size() <= MAX_NUMBER_OF_SEGMENTS)
+	{
+		return;
+	}
+
+	// The names start with the time, so the oldest sort first
+	std::sort(segments.begin(), segments.end());
+	for (std::size_t i = 0; i < segments.size() - MAX_NUMBER_OF_SEGMENTS; i++)
+	{
+		std::filesystem::remove(segments[i], error);
+	}
+}
@@ -0,0 +1,160 @@
+/**
+ * @author Daan Steenbergen
+ * @brief A small LZ77 codec for the closed segments of the event journal
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright 2026 Daan Steenbergen
+ */
+#include "journal_codec.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+constexpr std::size_t MINIMUM_MATCH_LENGTH = 4;
+constexpr std::size_t MAXIMUM_OFFSET = 0xFFFF;
+constexpr std::uint32_t HASH_BITS = 14;
+constexpr std::uint32_t NO_POSITION = UINT32_MAX;
+
+static std::uint32_t read_32(const std::uint8_t *data)
+{
+	std::uint32_t value;
+	std::memcpy(&value, data, sizeof(value));
+	return value;
+}
+
+static std::uint32_t get_hash(std::uint32_t sequence)
+{
+	return (sequence * 2654435761U) >> (32 - HASH_BITS);
+}
+
+/// @brief Write the part of a length that does not fit in its nibble
+static void write_length_extension(std::vector<std::uint8_t> &output, std::size_t length)
+{
+	for (length -= 15; length >= 255; length -= 255)
+	{
+		output.push_back(255);
+	}
+	output.push_back(static_cast<std::uint8_t>(length));
+}
+
+/// @brief Read the part of a length that did not fit in its nibble
+static bool read_length_extension(const std::vector<std::uint8_t> &input, std::size_t &position, std::size_t &length)
+{
+	std::uint8_t byte;
+	do
+	{
+		if (position >= input.size())
+		{
+			return false;
+		}
+		byte = input[position++];
+		length += byte;
+	} while (255 == byte);
+	return true;
+}
+
+static void write_sequence(std::vector<std::uint8_t> &output, const std::uint8_t *literals, std::size_t numberOfLiterals, std::size_t offset, std::size_t matchLength)
+{
+	std::size_t matchCode = (matchLength > 0) ? matchLength - MINIMUM_MATCH_LENGTH : 0;
+	output.push_back(static_cast<std::uint8_t>((std::min<std::size_t>(numberOfLiterals, 15) << 4) | std::min<std::size_t>(matchCode, 15)));
+	if (numberOfLiterals >= 15)
+	{
+		write_length_extension(output, numberOfLiterals);
+	}
+	output.insert(output.end(), literals, literals + numberOfLiterals);
+	if (matchLength > 0)
+	{
+		output.push_back(static_cast<std::uint8_t>(offset));
+		output.push_back(static_cast<std::uint8_t>(offset >> 8));
+		if (matchCode >= 15)
+		{
+			write_length_extension(output, matchCode);
+		}
+	}
+}
+
+std::vector<std::uint8_t> JournalCodec::compress(const std::vector<std::uint8_t> &input)
+{
+	std::vector<std::uint8_t> output;
+	output.reserve(input.size() / 2 + 16);
+	std::vector<std::uint32_t> positions(1 << HASH_BITS, NO_POSITION); ///< The last position of each hashed sequence
+
+	const std::uint8_t *data = input.data();
+	std::size_t position = 0;
+	std::size_t anchor = 0; ///< The first byte that is not written yet
+	while (position + MINIMUM_MATCH_LENGTH <= input.size())
+	{
+		std::uint32_t sequence = read_32(data + position);
+		std::uint32_t hash = get_hash(sequence);
+		std::uint32_t candidate = positions[hash];
+		positions[hash] = static_cast<std::uint32_t>(position);
+		if ((NO_POSITION == candidate) || (position - candidate > MAXIMUM_OFFSET) || (read_32(data + candidate) != sequence))
+		{
+			position++;
+			continue;
+		}
+
+		std::size_t matchLength = MINIMUM_MATCH_LENGTH;
+		while ((position + matchLength < input.size()) && (data[candidate + matchLength] == data[position + matchLength]))
+		{
+			matchLength++;
+		}
+		write_sequence(output, data + anchor, position - anchor, position - candidate, matchLength);
+		position += matchLength;
+		anchor = position;
+	}
+	write_sequence(output, data + anchor, input.size() - anchor, 0, 0);
+	return output;
+}
+
+bool JournalCodec::decompress(const std::vector<std::uint8_t> &input, std::size_t originalSize, std::vector<std::uint8_t> &output)
+{
+	output.clear();
+	output.reserve(originalSize);
+	std::size_t position = 0;
+	while (position < input.size())
+	{
+		std::uint8_t token = input[position++];
+		std::size_t numberOfLiterals = token >> 4;
+		if ((15 == numberOfLiterals) && !read_length_extension(input, position, numberOfLiterals))
+		{
+			return false;
+		}
+		if ((numberOfLiterals > input.size() - position) || (output.size() + numberOfLiterals > originalSize))
+		{
+			return false;
+		}
+		output.insert(output.end(), input.begin() + position, input.begin() + position + numberOfLiterals);
+		position += numberOfLiterals;
+		if (position == input.size())
+		{
+			break; // The last sequence has no match
+		}
+
+		if (position + 2 > input.size())
+		{
+			return false;
+		}
+		std::size_t offset = input[position] | (input[position + 1] << 8);
+		position += 2;
+		std::size_t matchLength = token & 0x0F;
+		if ((15 == matchLength) && !read_length_extension(input, position, matchLength))
+		{
+			return false;
+		}
+		matchLength += MINIMUM_MATCH_LENGTH;
+		if ((0 == offset) || (offset > output.size()) || (output.size() + matchLength > originalSize))
+		{
+			return false;
+		}
+
+		// Byte by byte, a match may overlap the bytes it produces
+		std::size_t source = output.size() - offset;
+		for (std::size_t i = 0; i < matchLength; i++)
+		{
+			output.push_back(output[source + i]);
+		}
+	}
+	return output.size() == originalSize;
+}
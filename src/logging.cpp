@@ -1,6 +1,6 @@
+#include "async_logger.hpp"
 #include "isobus/isobus/can_stack_logger.hpp"
-
-#include <iostream>
+#include "platform.hpp"
 
 #include <ctime>
 #include <fstream>
@@ -8,61 +8,101 @@
 #include <settings.hpp>
 #include <string>
 
-class TeeStreambuf : public std::streambuf
+// Hands every line written to std::cout to the asynchronous logger
+class LogStreambuf : public std::streambuf
 {
 private:
 	std::streambuf *consoleBuffer;
-	std::ofstream fileStream;
+
+	static std::string &get_line()
+	{
+		thread_local std::string line; // Every thread builds its own lines, so they don't get mixed
+		return line;
+	}
 
 public:
-	TeeStreambuf(std::ostream &stream, const std::string &filename) :
-	  consoleBuffer(stream.rdbuf()), fileStream(filename, std::ios::app)
+	LogStreambuf(std::ostream &stream) :
+	  consoleBuffer(stream.rdbuf())
 	{
-		std::cout << "Logging to file: " << filename << std::endl;
 		stream.rdbuf(this);
 	}
 
-	~TeeStreambuf()
+	~LogStreambuf()
 	{
+		AsyncLogger::stop();
 		std::cout.rdbuf(consoleBuffer); // Restore original buffer
 	}
 
+	std::streambuf *get_console_buffer() const
+	{
+		return consoleBuffer;
+	}
+
 protected:
 	int overflow(int c) override
 	{
 		if (c != EOF)
 		{
-			consoleBuffer->sputc(c); // Write to console
-			fileStream.put(c); // Write to file
+			char character = static_cast<char>(c);
+			xsputn(&character, 1);
 		}
 		return c;
 	}
 
+	std::streamsize xsputn(const char *text, std::streamsize count) override
+	{
+		auto &line = get_line();
+		for (std::streamsize i = 0; i < count; i++)
+		{
+			if ('\n' == text[i])
+			{
+				AsyncLogger::log_text(line);
+				line.clear();
+			}
+			else
+			{
+				line.push_back(text[i]);
+			}
+		}
+		return count;
+	}
+
 	int sync() override
 	{
-		consoleBuffer->pubsync();
-		fileStream.flush();
+		// Lines are passed on when they end, std::endl doesn't have to flush anything
 		return 0;
 	}
 };
 
-static std::unique_ptr<TeeStreambuf> teeStream;
+static std::unique_ptr<LogStreambuf> logStream;
 
-static void setup_file_logging()
+static void setup_logging(bool fileLogging)
 {
-	// Generate timestamped filename
-	std::time_t now = std::time(nullptr);
-	std::tm localTime;
-	localtime_s(&localTime, &now); // Thread-safe localtime
-
-	std::string logFilename = "logs\\AOG-TaskController_" +
-	  std::to_string(localTime.tm_year + 1900) + "-" +
-	  std::to_string(localTime.tm_mon + 1) + "-" +
-	  std::to_string(localTime.tm_mday) + "_" +
-	  std::to_string(localTime.tm_hour) + "-" +
-	  std::to_string(localTime.tm_min) + ".log";
-
-	teeStream = std::make_unique<TeeStreambuf>(std::cout, Settings::get_filename_path(logFilename));
+	std::string logFilename;
+	if (fileLogging)
+	{
+		// Generate timestamped filename
+		std::time_t now = std::time(nullptr);
+		std::tm localTime = Platform::get_local_time(now);
+
+		logFilename = Settings::get_filename_path("logs/AOG-TaskController_" +
+		                                          std::to_string(localTime.tm_year + 1900) + "-" +
+		                                          std::to_string(localTime.tm_mon + 1) + "-" +
+		                                          std::to_string(localTime.tm_mday) + "_" +
+		                                          std::to_string(localTime.tm_hour) + "-" +
+		                                          std::to_string(localTime.tm_min) + ".log");
+	}
+
+	logStream = std::make_unique<LogStreambuf>(std::cout);
+	if (!AsyncLogger::start(logStream->get_console_buffer(), logFilename))
+	{
+		AsyncLogger::start(logStream->get_console_buffer(), "");
+		std::cout << "Unable to log to file: " << logFilename << std::endl;
+	}
+	else if (fileLogging)
+	{
+		std::cout << "Logging to file: " << logFilename << std::endl;
+	}
 }
 
 // A log sink for the CAN stack
@@ -74,39 +114,7 @@ public:
 
 	void sink_CAN_stack_log(CANStackLogger::LoggingLevel level, const std::string &text) override
 	{
-		switch (level)
-		{
-			case LoggingLevel::Debug:
-			{
-				std::cout << "[Debug]";
-			}
-			break;
-
-			case LoggingLevel::Info:
-			{
-				std::cout << "[Info]";
-			}
-			break;
-
-			case LoggingLevel::Warning:
-			{
-				std::cout << "[Warn]";
-			}
-			break;
-
-			case LoggingLevel::Error:
-			{
-				std::cout << "[Error]";
-			}
-			break;
-
-			case LoggingLevel::Critical:
-			{
-				std::cout << "[Critical]";
-			}
-			break;
-		}
-		std::cout << text << std::endl; // Write the text to stdout
+		AsyncLogger::log(level, "{}", text);
 	}
 };
 
@@ -0,0 +1,191 @@
+/**
+ * @author Daan Steenbergen
+ * @brief Times the phases of the main loop in log-linear histograms
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright 2026 Daan Steenbergen
+ */
+#include "loop_profiler.hpp"
+#include "log_macros.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+constexpr std::uint64_t SUB_BUCKET_COUNT = 1ULL << LoopProfiler::SUB_BUCKET_BITS;
+
+void LoopProfiler::Histogram::add(std::uint64_t duration_ns)
+{
+	counts[get_bucket(duration_ns)]++;
+	numberOfSamples++;
+	sum_ns += duration_ns;
+	max_ns = std::max(max_ns, duration_ns);
+}
+
+std::uint64_t LoopProfiler::Histogram::get_percentile(double percentile) const
+{
+	if (0 == numberOfSamples)
+	{
+		return 0;
+	}
+
+	auto rank = static_cast<std::uint64_t>(std::ceil(percentile / 100.0 * static_cast<double>(numberOfSamples)));
+	rank = std::clamp<std::uint64_t>(rank, 1, numberOfSamples);
+	std::uint64_t count = 0;
+	for (std::size_t bucket = 0; bucket < counts.size(); bucket++)
+	{
+		count += counts[bucket];
+		if (count >= rank)
+		{
+			// The bucket's bound can be above the exact maximum, which is known
+			return std::min(get_highest_value(bucket), max_ns);
+		}
+	}
+	return max_ns;
+}
+
+std::uint64_t LoopProfiler::Histogram::get_number_of_samples() const
+{
+	return numberOfSamples;
+}
+
+std::uint64_t LoopProfiler::Histogram::get_maximum() const
+{
+	return max_ns;
+}
+
+std::uint64_t LoopProfiler::Histogram::get_mean() const
+{
+	return (numberOfSamples > 0) ? (sum_ns / numberOfSamples) : 0;
+}
+
+void LoopProfiler::Histogram::clear()
+{
+	counts.fill(0);
+	numberOfSamples = 0;
+	sum_ns = 0;
+	max_ns = 0;
+}
+
+std::size_t LoopProfiler::Histogram::get_bucket(std::uint64_t duration_ns)
+{
+	if (duration_ns < SUB_BUCKET_COUNT)
+	{
+		return static_cast<std::size_t>(duration_ns);
+	}
+
+	auto magnitude = static_cast<std::uint8_t>(std::bit_width(duration_ns) - 1);
+	if (magnitude > MAX_MAGNITUDE)
+	{
+		return NUMBER_OF_BUCKETS - 1;
+	}
+	std::uint8_t shift = magnitude - SUB_BUCKET_BITS;
+	return (static_cast<std::size_t>(shift + 1) << SUB_BUCKET_BITS) | static_cast<std::size_t>((duration_ns >> shift) & (SUB_BUCKET_COUNT - 1));
+}
+
+std::uint64_t LoopProfiler::Histogram::get_highest_value(std::size_t bucket)
+{
+	if (bucket < SUB_BUCKET_COUNT)
+	{
+		return bucket;
+	}
+
+	std::uint8_t shift = static_cast<std::uint8_t>((bucket >> SUB_BUCKET_BITS) - 1);
+	std::uint64_t subBucket = bucket & (SUB_BUCKET_COUNT - 1);
+	return ((SUB_BUCKET_COUNT + subBucket + 1) << shift) - 1;
+}
+
+void LoopProfiler::rotate()
+{
+	for (std::size_t i = 0; i < NUMBER_OF_PHASES; i++)
+	{
+		reports[i] = make_report(histograms[i]);
+		histograms[i].clear();
+	}
+	periodReport = make_report(periodHistogram);
+	periodHistogram.clear();
+}
+
+LoopProfiler::Report LoopProfiler::make_report(const Histogram &histogram)
+{
+	Report report;
+	report.numberOfSamples = histogram.get_number_of_samples();
+	report.p50_ns = histogram.get_percentile(50.0);
+	report.p90_ns = histogram.get_percentile(90.0);
+	report.p99_ns = histogram.get_percentile(99.0);
+	report.p999_ns = histogram.get_percentile(99.9);
+	report.max_ns = histogram.get_maximum();
+	report.mean_ns = histogram.get_mean();
+	return report;
+}
+
+const LoopProfiler::Report &LoopProfiler::get_report(Phase phase) const
+{
+	return reports[static_cast<std::size_t>(phase)];
+}
+
+const LoopProfiler::Histogram &LoopProfiler::get_histogram(Phase phase) const
+{
+	return histograms[static_cast<std::size_t>(phase)];
+}
+
+const LoopProfiler::Report &LoopProfiler::get_period_report() const
+{
+	return periodReport;
+}
+
+void LoopProfiler::log_reports() const
+{
+	// Microseconds with one decimal are precise enough for the histograms' resolution
+	auto to_us = [](std::uint64_t duration_ns) { return std::round(static_cast<double>(duration_ns) / 100.0) / 10.0; };
+	TC_LOG_INFO("[Loop profile] {} loops, durations in microseconds", reports[static_cast<std::size_t>(Phase::Loop)].numberOfSamples);
+	for (std::size_t i = 0; i < NUMBER_OF_PHASES; i++)
+	{
+		const auto &report = reports[i];
+		TC_LOG_INFO("[Loop profile] {}: p50 {}, p99 {}, max {}, mean {}",
+		            get_phase_name(static_cast<Phase>(i)),
+		            to_us(report.p50_ns),
+		            to_us(report.p99_ns),
+		            to_us(report.max_ns),
+		            to_us(report.mean_ns));
+	}
+	TC_LOG_INFO("[Loop profile] loop period: p50 {}, p99 {}, max {}, jitter (p99 - p50) {}",
+	            to_us(periodReport.p50_ns),
+	            to_us(periodReport.p99_ns),
+	            to_us(periodReport.max_ns),
+	            to_us(periodReport.p99_ns - periodReport.p50_ns));
+}
+
+const char *LoopProfiler::get_phase_name(Phase phase)
+{
+	switch (phase)
+	{
+		case Phase::AddressDetection:
+			return "address detection";
+		case Phase::UdpReceive:
+			return "UDP receive";
+		case Phase::MeasurementCommands:
+			return "measurement commands";
+		case Phase::TaskController:
+			return "task controller";
+		case Phase::SpeedMessages:
+			return "speed messages";
+		case Phase::Nmea2000:
+			return "NMEA2000";
+		case Phase::SectionScheduling:
+			return "section scheduling";
+		case Phase::Heartbeat:
+			return "heartbeat";
+		case Phase::PeriodicTasks:
+			return "periodic tasks";
+		case Phase::Dashboard:
+			return "dashboard";
+		case Phase::WebServer:
+			return "web server";
+		case Phase::Loop:
+			return "whole loop";
+		default:
+			return "unknown";
+	}
+}
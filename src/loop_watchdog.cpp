@@ -0,0 +1,108 @@
+/**
+ * @author Daan Steenbergen
+ * @brief Detects stalls of the main loop from a separate thread
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright 2026 Daan Steenbergen
+ */
+#include "loop_watchdog.hpp"
+#include "log_macros.hpp"
+#include "metrics.hpp"
+
+#include <algorithm>
+
+LoopWatchdog::~LoopWatchdog()
+{
+	stop();
+}
+
+void LoopWatchdog::start(const LoopProfiler &profiler, std::chrono::milliseconds threshold)
+{
+	stop();
+	isStopRequested = false;
+	thread = std::thread(&LoopWatchdog::watch, this, std::cref(profiler), threshold);
+}
+
+void LoopWatchdog::stop()
+{
+	if (!thread.joinable())
+	{
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		isStopRequested = true;
+	}
+	stopCondition.notify_one();
+	thread.join();
+}
+
+std::vector<LoopWatchdog::Stall> LoopWatchdog::get_stalls() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return std::vector<Stall>(stalls.begin(), stalls.end());
+}
+
+std::uint64_t LoopWatchdog::get_number_of_stalls() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return numberOfStalls;
+}
+
+void LoopWatchdog::watch(const LoopProfiler &profiler, std::chrono::milliseconds threshold)
+{
+	// Checking four times per threshold detects a stall at most a quarter threshold late
+	auto interval = std::max(threshold / 4, std::chrono::milliseconds(1));
+	std::uint64_t lastLoopNumber = profiler.get_number_of_loops();
+	bool isStalled = false;
+	Clock::time_point stalledLoopStart;
+
+	std::unique_lock<std::mutex> lock(mutex);
+	while (!stopCondition.wait_for(lock, interval, [this]() { return isStopRequested; }))
+	{
+		lock.unlock();
+		auto now = Clock::now();
+		std::uint64_t loopNumber = profiler.get_number_of_loops();
+		auto loopStart = profiler.get_loop_start();
+
+		if (loopNumber != lastLoopNumber)
+		{
+			if (isStalled)
+			{
+				// Measured up to the start of the next loop, that includes the wait between the loops
+				auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(loopStart - stalledLoopStart);
+				{
+					std::lock_guard<std::mutex> recordLock(mutex);
+					stalls.back().duration = duration;
+				}
+				TC_LOG_WARNING("[Watchdog] Main loop {} recovered after {} ms", lastLoopNumber, duration.count());
+			}
+			lastLoopNumber = loopNumber;
+			isStalled = false;
+		}
+		else if (!isStalled && (loopNumber > 0) && (now - loopStart > threshold))
+		{
+			isStalled = true;
+			stalledLoopStart = loopStart;
+			auto phase = profiler.get_running_phase();
+			auto timeInPhase = std::chrono::duration_cast<std::chrono::milliseconds>(now - profiler.get_phase_start());
+			{
+				std::lock_guard<std::mutex> recordLock(mutex);
+				if (stalls.size() >= MAX_NUMBER_OF_STALLS)
+				{
+					stalls.pop_front();
+				}
+				stalls.push_back({ std::chrono::system_clock::now(), loopNumber, phase, timeInPhase, std::chrono::milliseconds(0) });
+				numberOfStalls++;
+			}
+			Metrics::count_loop_stall();
+			TC_LOG_WARNING("[Watchdog] Main loop {} is stalled for {} ms, in phase '{}' for {} ms",
+			               loopNumber,
+			               std::chrono::duration_cast<std::chrono::milliseconds>(now - loopStart).count(),
+			               (LoopProfiler::Phase::Loop == phase) ? "outside of update" : LoopProfiler::get_phase_name(phase),
+			               timeInPhase.count());
+		}
+		lock.lock();
+	}
+}
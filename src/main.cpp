@@ -1,4 +1,5 @@
 #include "app.hpp"
+#include "argument_processor.hpp"
 #include "logging.cpp"
 #include "settings.hpp"
 
@@ -9,12 +10,16 @@
 
 #include <shellapi.h>
 #include <windows.h>
+#include <algorithm>
 #include <cstdio>
 #include <fstream>
 #include <iostream>
 #include <string>
 
 #define TRAY_ICON_ID 1
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002 // Windows 10 1803 and later, missing from older SDKs
+#endif
 static std::atomic_bool running = { true };
 
 // Window procedure to handle messages
@@ -64,154 +69,6 @@ std::vector<std::string> ParseCommandLine(LPSTR lpCmdLine)
 	return arguments;
 }
 
-enum class CANAdapter
-{
-	NONE,
-	ADAPTER_PCAN_USB,
-	ADAPTER_INNOMAKER_USB2CAN,
-	ADAPTER_RUSOKU_TOUCAN,
-	ADAPTER_SYS_TEC_USB2CAN,
-};
-
-class ArgumentProcessor
-{
-public:
-	ArgumentProcessor(std::vector<std::string> arguments) :
-	  arguments(arguments)
-	{
-	}
-
-	bool process()
-	{
-		for (std::string arg : arguments)
-		{
-			std::transform(arg.begin(), arg.end(), arg.begin(), [](unsigned char c) { return std::tolower(c); });
-			parse_option(arg);
-			parse_parameter(arg);
-		}
-		return true;
-	}
-
-	CANAdapter get_can_adapter() const
-	{
-		return canAdapter;
-	}
-
-	std::string get_can_channel() const
-	{
-		return canChannel;
-	}
-
-	bool is_file_logging() const
-	{
-		return fileLogging;
-	}
-
-private:
-	bool parse_option(std::string option)
-	{
-		if ("--help" == option)
-		{
-			std::cout << "Usage: AOG-TaskController.exe [options]\n";
-			std::cout << "Options:\n";
-			std::cout << "  --help\t\tShow this help message\n";
-			std::cout << "  --version\t\tShow the version of the application\n";
-			std::cout << "  --can_adapter=<driver>\tSelect the CAN driver\n";
-			std::cout << "  --can_channel=<channel>\tSelect the CAN channel\n";
-			std::cout << "  --log_level=<level>\tSet the log level (debug, info, warning, error, critical)\n";
-			std::cout << "  --log2file\t\tLog to file\n";
-			exit(0);
-		}
-		else if ("--version" == option)
-		{
-			std::cout << std::string(git::Describe()) + (git::AnyUncommittedChanges() ? "-dirty" : "") << std::endl;
-			exit(0);
-		}
-		else if ("--log2file" == option)
-		{
-			fileLogging = true;
-		}
-		else
-		{
-			return false;
-		}
-		return true;
-	}
-
-	bool parse_parameter(std::string parameter)
-	{
-		size_t pos = parameter.find('=');
-		if (pos == std::string::npos)
-		{
-			return false;
-		}
-		std::string key = parameter.substr(0, pos);
-		std::string value = parameter.substr(pos + 1);
-
-		if ("--can_adapter" == key)
-		{
-			static const std::unordered_map<std::string, CANAdapter> adapterMap = {
-				{ "peak-pcan", CANAdapter::ADAPTER_PCAN_USB },
-				{ "innomaker-usb2can", CANAdapter::ADAPTER_INNOMAKER_USB2CAN },
-				{ "rusoku-toucan", CANAdapter::ADAPTER_RUSOKU_TOUCAN },
-				{ "sys-tec-usb2can", CANAdapter::ADAPTER_SYS_TEC_USB2CAN },
-			};
-
-			auto it = adapterMap.find(value);
-			if (it != adapterMap.end())
-			{
-				canAdapter = it->second;
-				return true;
-			}
-
-			std::cout << "Unknown CAN adapter: " << value.c_str() << std::endl;
-			return false;
-		}
-		else if ("--can_channel" == key)
-		{
-			canChannel = value;
-		}
-		else if ("--log_level" == key)
-		{
-			if ("debug" == value)
-			{
-				isobus::CANStackLogger::set_log_level(isobus::CANStackLogger::LoggingLevel::Debug);
-			}
-			else if ("info" == value)
-			{
-				isobus::CANStackLogger::set_log_level(isobus::CANStackLogger::LoggingLevel::Info);
-			}
-			else if ("warning" == value)
-			{
-				isobus::CANStackLogger::set_log_level(isobus::CANStackLogger::LoggingLevel::Warning);
-			}
-			else if ("error" == value)
-			{
-				isobus::CANStackLogger::set_log_level(isobus::CANStackLogger::LoggingLevel::Error);
-			}
-			else if ("critical" == value)
-			{
-				isobus::CANStackLogger::set_log_level(isobus::CANStackLogger::LoggingLevel::Critical);
-			}
-			else
-			{
-				std::cout << "Unknown log level: " << value.c_str() << std::endl;
-				return false;
-			}
-		}
-		else
-		{
-			return false;
-		}
-		return true;
-	}
-
-	std::vector<std::string> arguments;
-	CANAdapter canAdapter = CANAdapter::NONE;
-	std::string canChannel;
-	bool fileLogging = false;
-};
-
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nShowCmd)
 {
 	// Try to attach to the parent process’s console if it exists
@@ -235,10 +92,7 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
 
 	// The sequence is important here, first we process the arguments, then we check if the file logging is enabled, then we log the arguments and version to the console/file.
 	isobus::CANStackLogger::set_can_stack_logger_sink(&logger);
-	if (argumentProcessor.is_file_logging())
-	{
-		setup_file_logging();
-	}
+	setup_logging(argumentProcessor.is_file_logging());
 
 	// Sent the cmd-line arguments and app-version to the console
 	for (std::string arg : arguments)
@@ -276,6 +130,11 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
 			canDriver = std::make_shared<isobus::SysTecWindowsPlugin>(static_cast<std::uint8_t>(std::stoi(argumentProcessor.get_can_channel())));
 			break;
 		}
+		case CANAdapter::ADAPTER_VIRTUAL:
+		{
+			canDriver = std::make_shared<isobus::VirtualCANPlugin>(argumentProcessor.get_can_channel());
+			break;
+		}
 		default:
 		{
 			std::cout << "No CAN adapter selected, exiting..." << std::endl;
@@ -296,22 +155,44 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
 	ShowWindow(hwnd, SW_SHOWMINNOACTIVE); // Little hack: Keep the window hidden, but still allows AOG (or other applications) to gracefully close it
 
 	Application app(canDriver);
+	if (argumentProcessor.is_traffic_recording())
+	{
+		app.record_traffic(Settings::get_filename_path("traffic/traffic_" + std::to_string(std::time(nullptr)) + ".tctr"));
+	}
 	if (!app.initialize())
 	{
 		std::cout << "Failed to initialize application..." << std::endl;
 		return -1;
 	}
 
+	// The timeout of a message wait is rounded to the system timer, usually 15.6 ms. A high resolution waitable timer
+	// wakes up on time, so scheduled section changes go out when they are due. Older Windows versions don't have it.
+	HANDLE updateTimer = CreateWaitableTimerExW(NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+	if (NULL == updateTimer)
+	{
+		updateTimer = CreateWaitableTimer(NULL, TRUE, NULL);
+	}
+	if (NULL == updateTimer)
+	{
+		std::cout << "Failed to create the update timer..." << std::endl;
+		app.stop();
+		return -1;
+	}
+
 	MSG msg;
 	while (running)
 	{
-		// This will become the apps main timer.
-		// Wait for a message with a timeout
+		// This is the apps main timer.
+		// Wait for a message or until the next update is due
 		// If a message arrives, process all pending messages
-		// If timeout occurs, continue to app.update()
-		DWORD result = MsgWaitForMultipleObjects(0, NULL, FALSE, 1, QS_ALLINPUT);
+		// If the timer expires, continue to app.update()
+		auto waitTime = std::chrono::duration_cast<std::chrono::nanoseconds>(app.get_next_update_time() - AppClock::now());
+		LARGE_INTEGER dueTime;
+		dueTime.QuadPart = -std::max<LONGLONG>(waitTime.count() / 100, 1); // Relative, in 100 ns units
+		SetWaitableTimer(updateTimer, &dueTime, 0, NULL, NULL, FALSE);
+		DWORD result = MsgWaitForMultipleObjects(1, &updateTimer, FALSE, INFINITE, QS_ALLINPUT);
 
-		while (result == WAIT_OBJECT_0 && PeekMessage(&msg, NULL, 0, 0, PM_REMOVE))
+		while (result == WAIT_OBJECT_0 + 1 && PeekMessage(&msg, NULL, 0, 0, PM_REMOVE))
 		{
 			TranslateMessage(&msg);
 			DispatchMessage(&msg);
@@ -325,6 +206,7 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
 	}
 
 	// Clean up
+	CloseHandle(updateTimer);
 	app.stop();
 	return 0;
 }
@@ -0,0 +1,106 @@
+/**
+ * @author Daan Steenbergen
+ * @brief The entry point without a window, for Linux tractor PCs, build boxes and simulations
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright 2026 Daan Steenbergen
+ */
+#include "app.hpp"
+#include "argument_processor.hpp"
+#include "logging.cpp"
+#include "settings.hpp"
+
+#include "isobus/hardware_integration/available_can_drivers.hpp"
+#include "isobus/isobus/can_stack_logger.hpp"
+
+#include "git.h"
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <iostream>
+#include <string>
+#include <thread>
+
+static std::atomic_bool running = { true };
+
+static void handle_signal(int)
+{
+	running = false;
+}
+
+int main(int argc, char **argv)
+{
+	std::signal(SIGINT, handle_signal);
+	std::signal(SIGTERM, handle_signal);
+
+	std::shared_ptr<isobus::CANHardwarePlugin> canDriver;
+	std::vector<std::string> arguments(argv, argv + argc);
+
+	ArgumentProcessor argumentProcessor(arguments);
+	bool argumentsProcessed = argumentProcessor.process();
+
+	// Same sequence as the Windows executable: arguments first, they decide whether to log to a file
+	isobus::CANStackLogger::set_can_stack_logger_sink(&logger);
+	setup_logging(argumentProcessor.is_file_logging());
+
+	for (std::string arg : arguments)
+	{
+		std::cout << arg.c_str() << " ";
+	}
+	std::cout << std::endl;
+	std::cout << "AOG-TC version: v" << std::string(git::Describe()) + (git::AnyUncommittedChanges() ? "-dirty" : "") << std::endl;
+
+	if (!argumentsProcessed)
+	{
+		std::cout << "Failed to process arguments, exiting..." << std::endl;
+		return -1;
+	}
+
+	switch (argumentProcessor.get_can_adapter())
+	{
+#ifndef _WIN32
+		case CANAdapter::ADAPTER_SOCKETCAN:
+		{
+			canDriver = std::make_shared<isobus::SocketCANInterface>(argumentProcessor.get_can_channel().empty() ? "can0" : argumentProcessor.get_can_channel());
+			break;
+		}
+#endif
+		case CANAdapter::ADAPTER_VIRTUAL:
+		{
+			canDriver = std::make_shared<isobus::VirtualCANPlugin>(argumentProcessor.get_can_channel());
+			break;
+		}
+		default:
+		{
+			std::cout << "No CAN adapter selected, exiting..." << std::endl;
+			return -1;
+		}
+	}
+
+	Application app(canDriver);
+	if (argumentProcessor.is_traffic_recording())
+	{
+		app.record_traffic(Settings::get_filename_path("traffic/traffic_" + std::to_string(std::time(nullptr)) + ".tctr"));
+	}
+	if (!app.initialize())
+	{
+		std::cout << "Failed to initialize application..." << std::endl;
+		return -1;
+	}
+
+	while (running)
+	{
+		if (!app.update())
+		{
+			std::cout << "Something unexpected happened, stopping application..." << std::endl;
+			break;
+		}
+		// Wakes up early for scheduled section changes, so they aren't delayed by the loop's pace
+		AppClock::sleep_until(app.get_next_update_time());
+	}
+
+	app.stop();
+	return 0;
+}
@@ -0,0 +1,220 @@
+/**
+ * @author Daan Steenbergen
+ * @brief Runtime counters and histograms, exported in the Prometheus text format
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright 2026 Daan Steenbergen
+ */
+#include "metrics.hpp"
+
+#include <cstdio>
+
+constexpr std::array<std::uint32_t, 10> LOOP_DURATION_BOUNDS_US = { 50, 100, 250, 500, 1000, 2500, 5000, 10000, 25000, 100000 };
+constexpr std::array<std::uint32_t, 10> SECTION_LATENCY_BOUNDS_MS = { 50, 100, 200, 300, 500, 750, 1000, 1500, 2000, 5000 };
+
+/// @brief The series of one client, claimed by the first error of that client
+struct ClientCounter
+{
+	std::atomic<std::uint64_t> name = 0; ///< 0 while unclaimed
+	std::atomic<std::uint64_t> count = 0;
+};
+
+static struct
+{
+	std::array<std::atomic<std::uint64_t>, 256> udpPacketsReceived = {};
+	std::array<std::atomic<std::uint64_t>, 256> udpPacketsSent = {};
+	std::atomic<std::uint64_t> udpCrcErrors = 0;
+	std::atomic<std::uint64_t> canFramesReceived = 0;
+	std::atomic<std::uint64_t> canFramesSent = 0;
+	std::atomic<std::uint64_t> setValuesSent = 0;
+	std::array<ClientCounter, Metrics::MAX_NUMBER_OF_CLIENTS> processDataAcknowledgeErrors;
+	std::atomic<std::uint64_t> otherProcessDataAcknowledgeErrors = 0;
+	std::atomic<std::uint64_t> sectionSwitches = 0;
+	std::atomic<std::uint64_t> loopStalls = 0;
+	std::atomic<std::uint32_t> activeClients = 0;
+	MetricsHistogram loopDuration{ LOOP_DURATION_BOUNDS_US };
+	MetricsHistogram sectionLatency{ SECTION_LATENCY_BOUNDS_MS };
+} counters;
+
+static void append_header(std::string &output, const char *name, const char *help, const char *type)
+{
+	output.append("# HELP ").append(name).append(" ").append(help).append("\n");
+	output.append("# TYPE ").append(name).append(" ").append(type).append("\n");
+}
+
+static void append_value(std::string &output, const char *name, const std::string &labels, std::uint64_t value)
+{
+	output.append(name);
+	if (!labels.empty())
+	{
+		output.append("{").append(labels).append("}");
+	}
+	output.append(" ").append(std::to_string(value)).append("\n");
+}
+
+static void append_packets_by_pgn(std::string &output, const char *name, const char *help, const std::array<std::atomic<std::uint64_t>, 256> &packets)
+{
+	append_header(output, name, help, "counter");
+	for (std::size_t pgn = 0; pgn < packets.size(); pgn++)
+	{
+		// Only the PGNs that were seen, AgIO uses a handful of the 256
+		std::uint64_t value = packets[pgn].load(std::memory_order_relaxed);
+		if (value > 0)
+		{
+			std::array<char, 16> label;
+			std::snprintf(label.data(), label.size(), "pgn=\"0x%02X\"", static_cast<unsigned>(pgn));
+			append_value(output, name, label.data(), value);
+		}
+	}
+}
+
+void MetricsHistogram::format(std::string &output, const char *name, const char *help, double scale) const
+{
+	append_header(output, name, help, "histogram");
+	std::string bucketName = std::string(name) + "_bucket";
+	std::uint64_t cumulativeCount = 0;
+	for (std::size_t i = 0; i <= numberOfBounds; i++)
+	{
+		cumulativeCount += counts[i].load(std::memory_order_relaxed);
+		std::array<char, 32> label;
+		if (i < numberOfBounds)
+		{
+			std::snprintf(label.data(), label.size(), "le=\"%g\"", bounds[i] * scale);
+		}
+		else
+		{
+			std::snprintf(label.data(), label.size(), "le=\"+Inf\"");
+		}
+		append_value(output, bucketName.c_str(), label.data(), cumulativeCount);
+	}
+	std::array<char, 32> sumText;
+	std::snprintf(sumText.data(), sumText.size(), "%.6f", sum.load(std::memory_order_relaxed) * scale);
+	output.append(name).append("_sum ").append(sumText.data()).append("\n");
+	output.append(name).append("_count ").append(std::to_string(cumulativeCount)).append("\n");
+}
+
+void Metrics::count_udp_packet_received(std::uint8_t pgn)
+{
+	counters.udpPacketsReceived[pgn].fetch_add(1, std::memory_order_relaxed);
+}
+
+void Metrics::count_udp_packet_sent(std::uint8_t pgn)
+{
+	counters.udpPacketsSent[pgn].fetch_add(1, std::memory_order_relaxed);
+}
+
+void Metrics::count_udp_crc_error()
+{
+	counters.udpCrcErrors.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Metrics::count_can_frame_received()
+{
+	counters.canFramesReceived.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Metrics::count_can_frame_sent()
+{
+	counters.canFramesSent.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Metrics::count_set_value_sent()
+{
+	counters.setValuesSent.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Metrics::count_process_data_acknowledge_error(std::uint64_t clientName)
+{
+	for (auto &client : counters.processDataAcknowledgeErrors)
+	{
+		std::uint64_t name = client.name.load(std::memory_order_relaxed);
+		if ((0 == name) && client.name.compare_exchange_strong(name, clientName, std::memory_order_relaxed))
+		{
+			name = clientName;
+		}
+		if (name == clientName)
+		{
+			client.count.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+	}
+	counters.otherProcessDataAcknowledgeErrors.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Metrics::count_section_switch()
+{
+	counters.sectionSwitches.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Metrics::count_loop_stall()
+{
+	counters.loopStalls.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Metrics::set_number_of_active_clients(std::uint32_t numberOfClients)
+{
+	counters.activeClients.store(numberOfClients, std::memory_order_relaxed);
+}
+
+void Metrics::observe_loop_duration(std::uint32_t duration_us)
+{
+	counters.loopDuration.observe(duration_us);
+}
+
+void Metrics::observe_section_latency(std::uint32_t latency_ms)
+{
+	counters.sectionLatency.observe(latency_ms);
+}
+
+std::uint64_t Metrics::get_number_of_can_frames()
+{
+	return counters.canFramesReceived.load(std::memory_order_relaxed) + counters.canFramesSent.load(std::memory_order_relaxed);
+}
+
+std::string Metrics::format()
+{
+	std::string output;
+	output.reserve(8192);
+
+	append_packets_by_pgn(output, "tc_udp_packets_received_total", "UDP packets received from AgIO, by PGN", counters.udpPacketsReceived);
+	append_packets_by_pgn(output, "tc_udp_packets_sent_total", "UDP packets sent to AgIO, by PGN", counters.udpPacketsSent);
+	append_header(output, "tc_udp_crc_errors_total", "UDP packets from AgIO with a CRC mismatch", "counter");
+	append_value(output, "tc_udp_crc_errors_total", "", counters.udpCrcErrors.load(std::memory_order_relaxed));
+
+	append_header(output, "tc_can_frames_received_total", "CAN frames received", "counter");
+	append_value(output, "tc_can_frames_received_total", "", counters.canFramesReceived.load(std::memory_order_relaxed));
+	append_header(output, "tc_can_frames_sent_total", "CAN frames sent", "counter");
+	append_value(output, "tc_can_frames_sent_total", "", counters.canFramesSent.load(std::memory_order_relaxed));
+	append_header(output, "tc_set_values_sent_total", "Set value commands sent to clients", "counter");
+	append_value(output, "tc_set_values_sent_total", "", counters.setValuesSent.load(std::memory_order_relaxed));
+
+	append_header(output, "tc_process_data_acknowledge_errors_total", "Process data acknowledges with errors, by client NAME", "counter");
+	for (const auto &client : counters.processDataAcknowledgeErrors)
+	{
+		std::uint64_t name = client.name.load(std::memory_order_relaxed);
+		if (0 != name)
+		{
+			std::array<char, 32> label;
+			std::snprintf(label.data(), label.size(), "client=\"%016llX\"", static_cast<unsigned long long>(name));
+			append_value(output, "tc_process_data_acknowledge_errors_total", label.data(), client.count.load(std::memory_order_relaxed));
+		}
+	}
+	std::uint64_t otherErrors = counters.otherProcessDataAcknowledgeErrors.load(std::memory_order_relaxed);
+	if (otherErrors > 0)
+	{
+		append_value(output, "tc_process_data_acknowledge_errors_total", "client=\"other\"", otherErrors);
+	}
+
+	append_header(output, "tc_active_clients", "Clients with an activated object pool", "gauge");
+	append_value(output, "tc_active_clients", "", counters.activeClients.load(std::memory_order_relaxed));
+	append_header(output, "tc_section_switches_total", "Actual section state changes reported by the clients", "counter");
+	append_value(output, "tc_section_switches_total", "", counters.sectionSwitches.load(std::memory_order_relaxed));
+
+	append_header(output, "tc_loop_stalls_total", "Main loop updates that exceeded the watchdog threshold", "counter");
+	append_value(output, "tc_loop_stalls_total", "", counters.loopStalls.load(std::memory_order_relaxed));
+
+	counters.loopDuration.format(output, "tc_loop_duration_seconds", "Duration of one main loop update", 1e-6);
+	counters.sectionLatency.format(output, "tc_section_latency_seconds", "Time from a section setpoint to the matching actual state", 1e-3);
+	return output;
+}
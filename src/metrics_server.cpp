@@ -0,0 +1,124 @@
+/**
+ * @author Daan Steenbergen
+ * @brief Serves the metrics over HTTP on localhost
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright 2026 Daan Steenbergen
+ */
+#include "metrics_server.hpp"
+#include "log_macros.hpp"
+#include "metrics.hpp"
+
+#include <memory>
+#include <string>
+
+using boost::asio::ip::tcp;
+
+constexpr std::size_t MAX_REQUEST_SIZE = 4096;
+
+/// @brief One request, kept alive by the handlers until the response is written
+struct MetricsConnection : std::enable_shared_from_this<MetricsConnection>
+{
+	explicit MetricsConnection(tcp::socket socket) :
+	  socket(std::move(socket)),
+	  request(MAX_REQUEST_SIZE)
+	{
+	}
+
+	void start()
+	{
+		auto self = shared_from_this();
+		boost::asio::async_read_until(socket, request, "\r\n\r\n", [self](const boost::system::error_code &error, std::size_t) {
+			if (!error)
+			{
+				self->respond();
+			}
+		});
+	}
+
+	void respond()
+	{
+		std::istream stream(&request);
+		std::string method;
+		std::string target;
+		stream >> method >> target;
+
+		std::string body;
+		std::string status;
+		if (("GET" == method) && (("/metrics" == target) || (0 == target.rfind("/metrics?", 0))))
+		{
+			status = "200 OK";
+			body = Metrics::format();
+		}
+		else
+		{
+			status = "404 Not Found";
+			body = "Metrics are served on /metrics\n";
+		}
+		response = "HTTP/1.1 " + status + "\r\nContent-Type: text/plain; version=0.0.4; charset=utf-8\r\nContent-Length: " +
+		  std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+
+		auto self = shared_from_this();
+		boost::asio::async_write(socket, boost::asio::buffer(response), [self](const boost::system::error_code &, std::size_t) {
+			boost::system::error_code ignored;
+			self->socket.shutdown(tcp::socket::shutdown_both, ignored);
+		});
+	}
+
+	tcp::socket socket;
+	boost::asio::streambuf request;
+	std::string response;
+};
+
+MetricsServer::MetricsServer(boost::asio::io_context &ioContext) :
+  acceptor(ioContext)
+{
+}
+
+bool MetricsServer::open(std::uint16_t port)
+{
+	boost::system::error_code error;
+	tcp::endpoint endpoint(boost::asio::ip::address_v4::loopback(), port);
+	acceptor.open(endpoint.protocol(), error);
+	if (!error)
+	{
+		acceptor.set_option(tcp::acceptor::reuse_address(true), error);
+		acceptor.bind(endpoint, error);
+	}
+	if (!error)
+	{
+		acceptor.listen(boost::asio::socket_base::max_listen_connections, error);
+	}
+	if (error)
+	{
+		TC_LOG_ERROR("Unable to serve metrics on port {}: {}", port, error.message());
+		close();
+		return false;
+	}
+
+	TC_LOG_INFO("Serving metrics on http://127.0.0.1:{}/metrics", port);
+	accept();
+	return true;
+}
+
+void MetricsServer::close()
+{
+	boost::system::error_code ignored;
+	acceptor.close(ignored);
+}
+
+void MetricsServer::accept()
+{
+	acceptor.async_accept([this](const boost::system::error_code &error, tcp::socket socket) {
+		if (boost::asio::error::operation_aborted == error)
+		{
+			return; // Closed
+		}
+		if (!error)
+		{
+			std::make_shared<MetricsConnection>(std::move(socket))->start();
+		}
+		accept();
+	});
+}
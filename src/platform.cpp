@@ -0,0 +1,51 @@
+/**
+ * @author Daan Steenbergen
+ * @brief The few operating system specific functions the task controller needs
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright 2026 Daan Steenbergen
+ */
+#include "platform.hpp"
+
+#include <cstdlib>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <ShlObj_core.h>
+#endif
+
+std::filesystem::path Platform::get_data_directory()
+{
+#ifdef _WIN32
+	char path[MAX_PATH];
+	if (SHGetFolderPath(NULL, CSIDL_APPDATA, NULL, 0, path) != S_OK)
+	{
+		throw std::runtime_error("Failed to get AppData path");
+	}
+	return std::filesystem::path(path) / PROJECT_NAME;
+#else
+	const char *dataHome = std::getenv("XDG_DATA_HOME");
+	if ((nullptr != dataHome) && ('\0' != dataHome[0]))
+	{
+		return std::filesystem::path(dataHome) / PROJECT_NAME;
+	}
+	const char *home = std::getenv("HOME");
+	if ((nullptr == home) || ('\0' == home[0]))
+	{
+		throw std::runtime_error("Failed to get the home directory, HOME is not set");
+	}
+	return std::filesystem::path(home) / ".local" / "share" / PROJECT_NAME;
+#endif
+}
+
+std::tm Platform::get_local_time(std::time_t time)
+{
+	std::tm localTime = {};
+#ifdef _WIN32
+	localtime_s(&localTime, &time);
+#else
+	localtime_r(&time, &localTime);
+#endif
+	return localTime;
+}
@@ -0,0 +1,200 @@
+/**
+ * @author Daan Steenbergen
+ * @brief A grid based prescription map for variable rate application
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright 2026 Daan Steenbergen
+ */
+#include "prescription_map.hpp"
+#include "log_macros.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <nlohmann/json.hpp>
+#include <numbers>
+
+using json = nlohmann::json;
+
+constexpr double METERS_PER_DEGREE_LATITUDE = 111320.0;
+
+bool PrescriptionMap::load(const std::string &path)
+{
+	std::ifstream file(path);
+	if (!file.is_open())
+	{
+		TC_LOG_ERROR("Unable to open prescription map {}", path);
+		return false;
+	}
+
+	try
+	{
+		json data;
+		file >> data;
+
+		auto columns = data.at("columns").get<std::uint32_t>();
+		auto rows = data.at("rows").get<std::uint32_t>();
+		std::vector<std::int32_t> rates;
+		if (data.contains("rates"))
+		{
+			rates = data["rates"].get<std::vector<std::int32_t>>();
+		}
+		else
+		{
+			// Binary grid files are stored next to the description
+			auto gridPath = std::filesystem::path(path).parent_path() / data.at("file").get<std::string>();
+			std::ifstream gridFile(gridPath, std::ios::binary);
+			if (!gridFile.is_open())
+			{
+				TC_LOG_ERROR("Unable to open prescription grid {}", gridPath.string());
+				return false;
+			}
+			std::vector<std::uint8_t> buffer(static_cast<std::size_t>(columns) * rows * sizeof(std::int32_t));
+			gridFile.read(reinterpret_cast<char *>(buffer.data()), buffer.size());
+			if (static_cast<std::size_t>(gridFile.gcount()) != buffer.size())
+			{
+				TC_LOG_ERROR("Prescription grid {} is smaller than {}x{} cells", gridPath.string(), columns, rows);
+				return false;
+			}
+			rates.resize(static_cast<std::size_t>(columns) * rows);
+			for (std::size_t i = 0; i < rates.size(); i++)
+			{
+				rates[i] = static_cast<std::int32_t>(buffer[4 * i] | (buffer[4 * i + 1] << 8) | (buffer[4 * i + 2] << 16) | (static_cast<std::uint32_t>(buffer[4 * i + 3]) << 24));
+			}
+		}
+
+		if (!set_grid(data.at("ddi").get<std::uint16_t>(),
+		              data.at("minimumNorth").get<double>(),
+		              data.at("minimumEast").get<double>(),
+		              data.at("cellNorthSize").get<double>(),
+		              data.at("cellEastSize").get<double>(),
+		              columns,
+		              rows,
+		              rates,
+		              data.value("defaultRate", NO_RATE)))
+		{
+			TC_LOG_ERROR("Prescription map {} has an invalid grid definition", path);
+			return false;
+		}
+	}
+	catch (const nlohmann::json::exception &e)
+	{
+		TC_LOG_ERROR("Error parsing prescription map {}: {}", path, e.what());
+		return false;
+	}
+
+	TC_LOG_INFO("Loaded prescription map for DDI {} with {}x{} cells ({} kB)", ddi, numberOfColumns, numberOfRows, get_memory_usage() / 1024);
+	return true;
+}
+
+bool PrescriptionMap::set_grid(std::uint16_t newDdi,
+                               double newMinimumNorth,
+                               double newMinimumEast,
+                               double cellNorthSize,
+                               double cellEastSize,
+                               std::uint32_t columns,
+                               std::uint32_t rows,
+                               const std::vector<std::int32_t> &rates,
+                               std::int32_t newDefaultRate)
+{
+	cells.clear();
+	numberOfColumns = 0;
+	numberOfRows = 0;
+	if ((0 == columns) || (0 == rows) || (cellNorthSize <= 0.0) || (cellEastSize <= 0.0) || (rates.size() != static_cast<std::size_t>(columns) * rows))
+	{
+		return false;
+	}
+
+	ddi = newDdi;
+	minimumNorth = newMinimumNorth;
+	minimumEast = newMinimumEast;
+	rowsPerDegree = 1.0 / cellNorthSize;
+	columnsPerDegree = 1.0 / cellEastSize;
+	defaultRate = newDefaultRate;
+	double centerLatitude = (minimumNorth + cellNorthSize * rows / 2.0) * std::numbers::pi / 180.0;
+	cellSize_m = std::min(cellNorthSize * METERS_PER_DEGREE_LATITUDE, cellEastSize * METERS_PER_DEGREE_LATITUDE * std::cos(centerLatitude));
+
+	// Reorder the rows into blocks, the padding of partial blocks at the edges has no prescription
+	numberOfColumns = columns;
+	numberOfRows = rows;
+	blocksPerRow = (columns + BLOCK_SIZE - 1) >> BLOCK_SHIFT;
+	std::uint32_t blocksPerColumn = (rows + BLOCK_SIZE - 1) >> BLOCK_SHIFT;
+	cells.assign(static_cast<std::size_t>(blocksPerRow) * blocksPerColumn * BLOCK_SIZE * BLOCK_SIZE, NO_RATE);
+	for (std::uint32_t row = 0; row < rows; row++)
+	{
+		for (std::uint32_t column = 0; column < columns; column++)
+		{
+			cells[get_index(column, row)] = rates[static_cast<std::size_t>(row) * columns + column];
+		}
+	}
+	return true;
+}
+
+bool PrescriptionMap::is_loaded() const
+{
+	return !cells.empty();
+}
+
+std::uint16_t PrescriptionMap::get_ddi() const
+{
+	return ddi;
+}
+
+std::int32_t PrescriptionMap::get_rate(double latitude, double longitude) const
+{
+	double row = (latitude - minimumNorth) * rowsPerDegree;
+	double column = (longitude - minimumEast) * columnsPerDegree;
+	if ((row < 0.0) || (column < 0.0) || (row >= numberOfRows) || (column >= numberOfColumns))
+	{
+		return defaultRate;
+	}
+	return cells[get_index(static_cast<std::uint32_t>(column), static_cast<std::uint32_t>(row))];
+}
+
+std::int32_t PrescriptionMap::get_section_rate(double latitude, double longitude, double heading_deg, double xOffset_m, double yOffset_m, double width_m) const
+{
+	if (!is_loaded())
+	{
+		return NO_RATE;
+	}
+
+	// Sample the line across the section, about one point per cell
+	double heading = heading_deg * std::numbers::pi / 180.0;
+	double sinHeading = std::sin(heading);
+	double cosHeading = std::cos(heading);
+	double metersPerDegreeLongitude = METERS_PER_DEGREE_LATITUDE * std::cos(latitude * std::numbers::pi / 180.0);
+	auto numberOfSamples = static_cast<std::uint8_t>(std::clamp(std::ceil(width_m / cellSize_m), 1.0, static_cast<double>(MAX_SAMPLES_PER_SECTION)));
+
+	std::int64_t sum = 0;
+	std::uint8_t numberOfRates = 0;
+	for (std::uint8_t i = 0; i < numberOfSamples; i++)
+	{
+		double right_m = yOffset_m + width_m * ((i + 0.5) / numberOfSamples - 0.5);
+		double north_m = xOffset_m * cosHeading - right_m * sinHeading;
+		double east_m = xOffset_m * sinHeading + right_m * cosHeading;
+		std::int32_t rate = get_rate(latitude + north_m / METERS_PER_DEGREE_LATITUDE, longitude + east_m / metersPerDegreeLongitude);
+		if (NO_RATE != rate)
+		{
+			sum += rate;
+			numberOfRates++;
+		}
+	}
+	if (0 == numberOfRates)
+	{
+		return NO_RATE;
+	}
+	return static_cast<std::int32_t>(sum / numberOfRates);
+}
+
+std::size_t PrescriptionMap::get_memory_usage() const
+{
+	return cells.capacity() * sizeof(std::int32_t);
+}
+
+std::size_t PrescriptionMap::get_index(std::uint32_t column, std::uint32_t row) const
+{
+	std::size_t block = static_cast<std::size_t>(row >> BLOCK_SHIFT) * blocksPerRow + (column >> BLOCK_SHIFT);
+	return (block << (2 * BLOCK_SHIFT)) | ((row & (BLOCK_SIZE - 1)) << BLOCK_SHIFT) | (column & (BLOCK_SIZE - 1));
+}
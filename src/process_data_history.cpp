@@ -0,0 +1,156 @@
+/**
+ * @author Daan Steenbergen
+ * @brief Keeps the recent history of the process data reported by the clients
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright 2026 Daan Steenbergen
+ */
+#include "process_data_history.hpp"
+
+#include <algorithm>
+
+template<typename T, std::size_t N>
+void ProcessDataHistory::Ring<T, N>::push(const T &entry)
+{
+	entries[next] = entry;
+	next = (next + 1) % N;
+	count = std::min(count + 1, N);
+}
+
+template<typename T, std::size_t N>
+T &ProcessDataHistory::Ring<T, N>::newest()
+{
+	return entries[(next + N - 1) % N];
+}
+
+template<typename T, std::size_t N>
+const T &ProcessDataHistory::Ring<T, N>::at(std::size_t age) const
+{
+	return entries[(next + N - 1 - age) % N];
+}
+
+std::size_t ProcessDataHistory::KeyHash::operator()(const Key &key) const
+{
+	std::uint64_t hash = key.clientName ^ (static_cast<std::uint64_t>(key.elementAndDdi) * 0x9E3779B97F4A7C15ULL);
+	hash ^= hash >> 31;
+	return static_cast<std::size_t>(hash * 0xBF58476D1CE4E5B9ULL);
+}
+
+void ProcessDataHistory::add(std::uint64_t clientName, std::uint16_t elementNumber, std::uint16_t ddi, std::int32_t value, Clock::time_point now)
+{
+	Key key{ clientName, (static_cast<std::uint32_t>(elementNumber) << 16) | ddi };
+	auto it = series.find(key);
+	if (it == series.end())
+	{
+		if (series.size() >= MAX_NUMBER_OF_SERIES)
+		{
+			return;
+		}
+		it = series.emplace(key, std::make_unique<Series>()).first;
+	}
+
+	auto &values = *it->second;
+	values.raw.push({ now, value });
+	add_to_rollups(values.seconds, now, std::chrono::seconds(1), value);
+	add_to_rollups(values.minutes, now, std::chrono::minutes(1), value);
+}
+
+bool ProcessDataHistory::get_history(std::uint64_t clientName,
+                                     std::uint16_t elementNumber,
+                                     std::uint16_t ddi,
+                                     Resolution resolution,
+                                     Clock::duration span,
+                                     std::vector<Sample> &history) const
+{
+	history.clear();
+	auto it = series.find({ clientName, (static_cast<std::uint32_t>(elementNumber) << 16) | ddi });
+	if (it == series.end())
+	{
+		return false;
+	}
+
+	const auto &values = *it->second;
+	switch (resolution)
+	{
+		case Resolution::Raw:
+		{
+			if (values.raw.count > 0)
+			{
+				auto oldest = values.raw.at(0).time - span;
+				for (std::size_t age = 0; (age < values.raw.count) && (values.raw.at(age).time >= oldest); age++)
+				{
+					const auto &sample = values.raw.at(age);
+					history.push_back({ sample.time, sample.value, sample.value, static_cast<double>(sample.value) });
+				}
+				std::reverse(history.begin(), history.end());
+			}
+		}
+		break;
+
+		case Resolution::Second:
+		{
+			get_rollups(values.seconds, span, history);
+		}
+		break;
+
+		case Resolution::Minute:
+		{
+			get_rollups(values.minutes, span, history);
+		}
+		break;
+	}
+	return true;
+}
+
+bool ProcessDataHistory::get_latest(std::uint64_t clientName, std::uint16_t elementNumber, std::uint16_t ddi, std::int32_t &value) const
+{
+	auto it = series.find({ clientName, (static_cast<std::uint32_t>(elementNumber) << 16) | ddi });
+	if ((it == series.end()) || (0 == it->second->raw.count))
+	{
+		return false;
+	}
+	value = it->second->raw.at(0).value;
+	return true;
+}
+
+void ProcessDataHistory::remove_client(std::uint64_t clientName)
+{
+	std::erase_if(series, [clientName](const auto &entry) { return entry.first.clientName == clientName; });
+}
+
+template<std::size_t N>
+void ProcessDataHistory::add_to_rollups(Ring<Rollup, N> &rollups, Clock::time_point now, Clock::duration period, std::int32_t value)
+{
+	// Periods are aligned to the clock, so the rollups of different series line up
+	Clock::time_point start(now.time_since_epoch() - (now.time_since_epoch() % period));
+	if ((rollups.count > 0) && (rollups.newest().start == start))
+	{
+		auto &rollup = rollups.newest();
+		rollup.minimum = std::min(rollup.minimum, value);
+		rollup.maximum = std::max(rollup.maximum, value);
+		rollup.sum += value;
+		rollup.count++;
+	}
+	else
+	{
+		rollups.push({ start, value, value, value, 1 });
+	}
+}
+
+template<std::size_t N>
+void ProcessDataHistory::get_rollups(const Ring<Rollup, N> &rollups, Clock::duration span, std::vector<Sample> &history)
+{
+	if (0 == rollups.count)
+	{
+		return;
+	}
+
+	auto oldest = rollups.at(0).start - span;
+	for (std::size_t age = 0; (age < rollups.count) && (rollups.at(age).start >= oldest); age++)
+	{
+		const auto &rollup = rollups.at(age);
+		history.push_back({ rollup.start, rollup.minimum, rollup.maximum, static_cast<double>(rollup.sum) / rollup.count });
+	}
+	std::reverse(history.begin(), history.end());
+}
@@ -0,0 +1,181 @@
+/**
+ * @author Daan Steenbergen
+ * @brief Measures how long each section takes to follow its setpoint
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright 2026 Daan Steenbergen
+ */
+#include "section_latency_profiler.hpp"
+#include "log_macros.hpp"
+#include "metrics.hpp"
+
+#include <algorithm>
+#include <fstream>
+
+void SectionLatencyProfiler::Histogram::add(std::chrono::milliseconds latency)
+{
+	auto bucket = std::min<std::int64_t>(latency.count() / BUCKET_WIDTH_MS, NUMBER_OF_BUCKETS - 1);
+	if (counts[bucket] == UINT16_MAX)
+	{
+		// Halve everything instead of saturating, this keeps the shape and favours recent samples
+		numberOfSamples = 0;
+		for (auto &count : counts)
+		{
+			count /= 2;
+			numberOfSamples += count;
+		}
+	}
+	counts[bucket]++;
+	numberOfSamples++;
+}
+
+std::uint32_t SectionLatencyProfiler::Histogram::get_percentile(float percentile) const
+{
+	if (0 == numberOfSamples)
+	{
+		return 0;
+	}
+
+	// Interpolate within the bucket that contains the percentile
+	float target = std::clamp(percentile, 0.0f, 1.0f) * numberOfSamples;
+	std::uint32_t cumulative = 0;
+	for (std::uint16_t bucket = 0; bucket < NUMBER_OF_BUCKETS; bucket++)
+	{
+		if ((counts[bucket] > 0) && (cumulative + counts[bucket] >= target))
+		{
+			float fraction = (target - cumulative) / counts[bucket];
+			return static_cast<std::uint32_t>((bucket + fraction) * BUCKET_WIDTH_MS);
+		}
+		cumulative += counts[bucket];
+	}
+	return NUMBER_OF_BUCKETS * BUCKET_WIDTH_MS;
+}
+
+void SectionLatencyProfiler::set_number_of_sections(std::uint8_t number)
+{
+	sections.assign(number, SectionState());
+}
+
+void SectionLatencyProfiler::on_setpoint_sent(std::uint8_t section, bool on, Clock::time_point now)
+{
+	if (section >= sections.size())
+	{
+		return;
+	}
+
+	auto &state = sections[section];
+	if (on != state.lastSetpoint)
+	{
+		// A setpoint that reverts an unanswered one cancels the measurement, the section may never have moved
+		state.isPending = (on != state.lastActual);
+		state.setpointTime = now;
+		state.lastSetpoint = on;
+	}
+}
+
+void SectionLatencyProfiler::on_actual_state(std::uint8_t section, bool on, Clock::time_point now)
+{
+	if (section >= sections.size())
+	{
+		return;
+	}
+
+	auto &state = sections[section];
+	if (on == state.lastActual)
+	{
+		return;
+	}
+	state.lastActual = on;
+	Metrics::count_section_switch();
+
+	// Changes that weren't requested (e.g. switched by the operator) are not measured
+	if (state.isPending && (on == state.lastSetpoint))
+	{
+		auto latency = std::chrono::duration_cast<std::chrono::milliseconds>(now - state.setpointTime);
+		if (latency < MAXIMUM_LATENCY)
+		{
+			(on ? state.onLatency : state.offLatency).add(latency);
+			Metrics::observe_section_latency(static_cast<std::uint32_t>(latency.count()));
+			hasNewSamples = true;
+		}
+	}
+	state.isPending = false;
+}
+
+const SectionLatencyProfiler::Histogram &SectionLatencyProfiler::get_histogram(std::uint8_t section, bool on) const
+{
+	static const Histogram NO_SAMPLES;
+	if (section >= sections.size())
+	{
+		return NO_SAMPLES;
+	}
+	return on ? sections[section].onLatency : sections[section].offLatency;
+}
+
+std::uint32_t SectionLatencyProfiler::get_recommended_delay(bool on) const
+{
+	// AOG has a single delay for all sections, so the median over all of them is the best fit
+	Histogram combined;
+	for (const auto &state : sections)
+	{
+		const auto &histogram = on ? state.onLatency : state.offLatency;
+		for (std::uint16_t bucket = 0; bucket < NUMBER_OF_BUCKETS; bucket++)
+		{
+			combined.counts[bucket] = static_cast<std::uint16_t>(std::min<std::uint32_t>(combined.counts[bucket] + histogram.counts[bucket], UINT16_MAX));
+		}
+	}
+	for (auto count : combined.counts)
+	{
+		combined.numberOfSamples += count;
+	}
+	return combined.get_percentile(0.5f);
+}
+
+std::uint32_t SectionLatencyProfiler::get_number_of_samples(bool on) const
+{
+	std::uint32_t numberOfSamples = 0;
+	for (const auto &state : sections)
+	{
+		numberOfSamples += on ? state.onLatency.numberOfSamples : state.offLatency.numberOfSamples;
+	}
+	return numberOfSamples;
+}
+
+bool SectionLatencyProfiler::export_csv(const std::string &path)
+{
+	if (!hasNewSamples)
+	{
+		return true;
+	}
+
+	std::ofstream file(path, std::ios::trunc);
+	if (!file.is_open())
+	{
+		TC_LOG_ERROR("Unable to export section latencies. (Failed to open file)");
+		return false;
+	}
+
+	file << "section,direction,samples,p10_ms,p50_ms,p90_ms";
+	for (std::uint16_t bucket = 0; bucket < NUMBER_OF_BUCKETS; bucket++)
+	{
+		file << ',' << bucket * BUCKET_WIDTH_MS;
+	}
+	file << '\n';
+	for (std::uint8_t section = 0; section < sections.size(); section++)
+	{
+		for (bool on : { true, false })
+		{
+			const auto &histogram = get_histogram(section, on);
+			file << static_cast<int>(section) << ',' << (on ? "on" : "off") << ',' << histogram.numberOfSamples << ','
+			     << histogram.get_percentile(0.1f) << ',' << histogram.get_percentile(0.5f) << ',' << histogram.get_percentile(0.9f);
+			for (auto count : histogram.counts)
+			{
+				file << ',' << count;
+			}
+			file << '\n';
+		}
+	}
+	hasNewSamples = !file.good();
+	return file.good();
+}
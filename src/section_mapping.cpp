@@ -0,0 +1,131 @@
+/**
+ * @author Daan Steenbergen
+ * @brief Maps AOG's sections onto the physical sections of an implement
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright 2026 Daan Steenbergen
+ */
+#include "section_mapping.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <limits>
+
+bool VirtualSectionMapping::configure(const std::vector<LateralSection> &physicalSections, std::uint8_t virtualSections)
+{
+	numberOfVirtualSections = 0;
+	physicalMasks.clear();
+	rowOffsets.clear();
+	overlapEntries.clear();
+
+	if ((0 == virtualSections) || (virtualSections > MAX_VIRTUAL_SECTIONS) || physicalSections.empty() || (physicalSections.size() > MAX_NUMBER_OF_SECTIONS))
+	{
+		return false;
+	}
+
+	std::int32_t leftEdge = std::numeric_limits<std::int32_t>::max();
+	std::int32_t rightEdge = std::numeric_limits<std::int32_t>::min();
+	for (const auto &section : physicalSections)
+	{
+		leftEdge = std::min(leftEdge, section.yOffset_mm - section.width_mm / 2);
+		rightEdge = std::max(rightEdge, section.yOffset_mm + section.width_mm / 2);
+	}
+	if (rightEdge <= leftEdge)
+	{
+		return false;
+	}
+
+	// Compute the overlap matrix, virtual sections are numbered from left to right like in AOG
+	double virtualWidth = static_cast<double>(rightEdge - leftEdge) / virtualSections;
+	std::vector<float> bestFraction(physicalSections.size(), 0.0f);
+	std::vector<std::uint8_t> bestVirtualSection(physicalSections.size(), 0);
+	rowOffsets.push_back(0);
+	for (std::uint8_t v = 0; v < virtualSections; v++)
+	{
+		double virtualLeft = leftEdge + v * virtualWidth;
+		double virtualRight = virtualLeft + virtualWidth;
+		for (std::size_t p = 0; p < physicalSections.size(); p++)
+		{
+			const auto &section = physicalSections[p];
+			if (section.width_mm <= 0)
+			{
+				continue;
+			}
+			double physicalLeft = section.yOffset_mm - section.width_mm / 2.0;
+			double overlap = std::min(virtualRight, physicalLeft + section.width_mm) - std::max(virtualLeft, physicalLeft);
+			if (overlap > 0.0)
+			{
+				auto fraction = static_cast<float>(overlap / section.width_mm);
+				overlapEntries.push_back({ static_cast<std::uint8_t>(p), fraction });
+				if (fraction > bestFraction[p])
+				{
+					bestFraction[p] = fraction;
+					bestVirtualSection[p] = v;
+				}
+			}
+		}
+		rowOffsets.push_back(static_cast<std::uint32_t>(overlapEntries.size()));
+	}
+
+	// Collapse the matrix into one physical mask per virtual section
+	physicalMasks.assign(virtualSections, SectionMask());
+	for (std::uint8_t v = 0; v < virtualSections; v++)
+	{
+		for (std::uint32_t i = rowOffsets[v]; i < rowOffsets[v + 1]; i++)
+		{
+			const auto &entry = overlapEntries[i];
+			if ((entry.fraction >= MINIMUM_OVERLAP_FRACTION) || (bestVirtualSection[entry.physicalSection] == v))
+			{
+				physicalMasks[v].set(entry.physicalSection);
+			}
+		}
+	}
+	numberOfVirtualSections = virtualSections;
+	return true;
+}
+
+bool VirtualSectionMapping::is_enabled() const
+{
+	return numberOfVirtualSections > 0;
+}
+
+std::uint8_t VirtualSectionMapping::get_number_of_virtual_sections() const
+{
+	return numberOfVirtualSections;
+}
+
+SectionMask VirtualSectionMapping::to_physical(const SectionMask &virtualSections) const
+{
+	SectionMask physicalSections;
+	std::uint64_t remaining = virtualSections.words[0];
+	if (numberOfVirtualSections < 64)
+	{
+		remaining &= (1ULL << numberOfVirtualSections) - 1;
+	}
+	while (0 != remaining)
+	{
+		physicalSections |= physicalMasks[std::countr_zero(remaining)];
+		remaining &= remaining - 1; // Clear the lowest set bit
+	}
+	return physicalSections;
+}
+
+SectionMask VirtualSectionMapping::to_virtual(const SectionMask &physicalSections) const
+{
+	SectionMask virtualSections;
+	for (std::uint8_t v = 0; v < numberOfVirtualSections; v++)
+	{
+		virtualSections.set(v, (physicalMasks[v] & physicalSections).any());
+	}
+	return virtualSections;
+}
+
+std::vector<VirtualSectionMapping::OverlapEntry> VirtualSectionMapping::get_overlaps(std::uint8_t virtualSection) const
+{
+	if (virtualSection >= numberOfVirtualSections)
+	{
+		return {};
+	}
+	return std::vector<OverlapEntry>(overlapEntries.begin() + rowOffsets[virtualSection], overlapEntries.begin() + rowOffsets[virtualSection + 1]);
+}
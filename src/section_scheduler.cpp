@@ -0,0 +1,131 @@
+/**
+ * @author Daan Steenbergen
+ * @brief A look-ahead scheduler that compensates section switching latencies
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright 2026 Daan Steenbergen
+ */
+#include "section_scheduler.hpp"
+
+#include <cstdlib>
+
+void SectionScheduler::set_number_of_sections(std::uint8_t number)
+{
+	pendingChanges.assign(number, PendingChange());
+	onLatencies_ms.resize(number, 0);
+	offLatencies_ms.resize(number, 0);
+}
+
+void SectionScheduler::set_section_latency(std::uint8_t section, std::uint32_t onLatency_ms, std::uint32_t offLatency_ms)
+{
+	if (section < pendingChanges.size())
+	{
+		onLatencies_ms[section] = onLatency_ms;
+		offLatencies_ms[section] = offLatency_ms;
+	}
+}
+
+void SectionScheduler::set_look_ahead(std::uint32_t onLookAhead, std::uint32_t offLookAhead)
+{
+	onLookAhead_ms = onLookAhead;
+	offLookAhead_ms = offLookAhead;
+}
+
+bool SectionScheduler::is_enabled() const
+{
+	return (onLookAhead_ms > 0) || (offLookAhead_ms > 0);
+}
+
+void SectionScheduler::update_speed(std::int32_t speed, Clock::time_point now)
+{
+	if (now > odometerTime)
+	{
+		auto elapsed_us = std::chrono::duration_cast<std::chrono::microseconds>(now - odometerTime).count();
+		odometer_um += (static_cast<std::int64_t>(speed_mm_per_s) * elapsed_us) / 1000;
+		odometerTime = now;
+	}
+	speed_mm_per_s = std::abs(speed);
+
+	// The remaining distance to each boundary is fixed, but the time to get there changed
+	for (std::uint8_t i = 0; i < pendingChanges.size(); i++)
+	{
+		if (pendingChanges[i].pending)
+		{
+			pendingChanges[i].dueTime = calculate_due_time(i, pendingChanges[i]);
+		}
+	}
+}
+
+void SectionScheduler::schedule(std::uint8_t section, bool on, bool currentlyOn, Clock::time_point now)
+{
+	if (section >= pendingChanges.size())
+	{
+		return;
+	}
+
+	auto &change = pendingChanges[section];
+	if (on == currentlyOn)
+	{
+		// AOG reverted the request before it was sent, nothing to do anymore
+		change.pending = false;
+		return;
+	}
+	if (change.pending && (change.on == on))
+	{
+		// Already on its way, keep the original boundary
+		return;
+	}
+
+	update_speed(speed_mm_per_s, now);
+	std::uint32_t lookAhead_ms = on ? onLookAhead_ms : offLookAhead_ms;
+	change.pending = true;
+	change.on = on;
+	change.boundaryDistance_um = odometer_um + static_cast<std::int64_t>(speed_mm_per_s) * lookAhead_ms;
+	change.dueTime = calculate_due_time(section, change);
+}
+
+bool SectionScheduler::pop_due_changes(Clock::time_point now, std::vector<SectionChange> &changes)
+{
+	bool anyDue = false;
+	for (std::uint8_t i = 0; i < pendingChanges.size(); i++)
+	{
+		if (pendingChanges[i].pending && (pendingChanges[i].dueTime <= now))
+		{
+			changes.push_back({ i, pendingChanges[i].on });
+			pendingChanges[i].pending = false;
+			anyDue = true;
+		}
+	}
+	return anyDue;
+}
+
+SectionScheduler::Clock::time_point SectionScheduler::get_next_due_time() const
+{
+	Clock::time_point nextDueTime = Clock::time_point::max();
+	for (const auto &change : pendingChanges)
+	{
+		if (change.pending && (change.dueTime < nextDueTime))
+		{
+			nextDueTime = change.dueTime;
+		}
+	}
+	return nextDueTime;
+}
+
+SectionScheduler::Clock::time_point SectionScheduler::calculate_due_time(std::uint8_t section, const PendingChange &change) const
+{
+	if (speed_mm_per_s < MINIMUM_SPEED_MM_PER_S)
+	{
+		return odometerTime;
+	}
+
+	std::uint32_t latency_ms = change.on ? onLatencies_ms[section] : offLatencies_ms[section];
+	std::int64_t remaining_um = change.boundaryDistance_um - odometer_um - static_cast<std::int64_t>(speed_mm_per_s) * latency_ms;
+	if (remaining_um <= 0)
+	{
+		// The latency is longer than the look-ahead, the best we can do is to switch right away
+		return odometerTime;
+	}
+	return odometerTime + std::chrono::microseconds((remaining_um * 1000) / speed_mm_per_s);
+}
@@ -7,8 +7,9 @@
  * @copyright 2025 Daan Steenbergen
  */
 #include "settings.hpp"
+#include "platform.hpp"
 
-#include <ShlObj_core.h>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <nlohmann/json.hpp>
@@ -44,6 +45,16 @@ bool Settings::load()
 		configuredSubnet = DEFAULT_SUBNET; // Key not found, use default
 	}
 
+	sectionLookAheadOn_ms = data.value("sectionLookAheadOn", 0u);
+	sectionLookAheadOff_ms = data.value("sectionLookAheadOff", 0u);
+	coverageSectionControl = data.value("coverageSectionControl", false);
+	coverageMemoryPerClient_MB = data.value("coverageMemoryPerClient", 32u);
+	numberOfVirtualSections = data.value("virtualSections", static_cast<std::uint8_t>(0));
+	prescriptionMapPath = data.value("prescriptionMap", std::string());
+	metricsPort = data.value("metricsPort", static_cast<std::uint16_t>(9464));
+	dashboardPort = data.value("dashboardPort", static_cast<std::uint16_t>(9465));
+	dashboardFrameRate = data.value("dashboardFrameRate", static_cast<std::uint8_t>(10));
+
 	return true;
 }
 
@@ -51,6 +62,15 @@ bool Settings::save() const
 {
 	json data;
 	data["subnet"] = configuredSubnet;
+	data["sectionLookAheadOn"] = sectionLookAheadOn_ms;
+	data["sectionLookAheadOff"] = sectionLookAheadOff_ms;
+	data["coverageSectionControl"] = coverageSectionControl;
+	data["coverageMemoryPerClient"] = coverageMemoryPerClient_MB;
+	data["virtualSections"] = numberOfVirtualSections;
+	data["prescriptionMap"] = prescriptionMapPath;
+	data["metricsPort"] = metricsPort;
+	data["dashboardPort"] = dashboardPort;
+	data["dashboardFrameRate"] = dashboardFrameRate;
 
 	std::ofstream file(get_filename_path("settings.json"));
 	if (!file.is_open())
@@ -82,45 +102,76 @@ bool Settings::set_subnet(std::array<std::uint8_t, 3> subnet, bool save)
 	return true;
 }
 
+std::uint32_t Settings::get_section_look_ahead_on() const
+{
+	return sectionLookAheadOn_ms;
+}
+
+std::uint32_t Settings::get_section_look_ahead_off() const
+{
+	return sectionLookAheadOff_ms;
+}
+
+bool Settings::is_coverage_section_control_enabled() const
+{
+	return coverageSectionControl;
+}
+
+std::uint32_t Settings::get_coverage_memory_per_client() const
+{
+	return coverageMemoryPerClient_MB;
+}
+
+std::uint8_t Settings::get_number_of_virtual_sections() const
+{
+	return numberOfVirtualSections;
+}
+
+const std::string &Settings::get_prescription_map_path() const
+{
+	return prescriptionMapPath;
+}
+
+std::uint16_t Settings::get_metrics_port() const
+{
+	return metricsPort;
+}
+
+std::uint16_t Settings::get_dashboard_port() const
+{
+	return dashboardPort;
+}
+
+std::uint8_t Settings::get_dashboard_frame_rate() const
+{
+	return dashboardFrameRate;
+}
+
 std::string Settings::get_filename_path(std::string fileName)
 {
-	char path[MAX_PATH];
-	if (SHGetFolderPath(NULL, CSIDL_APPDATA, NULL, 0, path) != S_OK)
+	// File names use '/' between directories, make_preferred turns them into '\\' on Windows
+	std::filesystem::path fullPath = Platform::get_data_directory() / fileName;
+	fullPath.make_preferred();
+
+	std::error_code error;
+	std::filesystem::create_directories(fullPath.parent_path(), error);
+	if (error)
 	{
-		throw std::runtime_error("Failed to get AppData path");
+		throw std::runtime_error("Failed to create directory: " + fullPath.parent_path().string());
 	}
+	return fullPath.string();
+}
 
-	std::string baseDir = std::string(path) + "\\" + PROJECT_NAME;
-	std::string fullPath = baseDir + "\\" + fileName;
+std::string Settings::get_directory_path(std::string directoryName)
+{
+	std::filesystem::path fullPath = Platform::get_data_directory() / directoryName;
+	fullPath.make_preferred();
 
-	// Find the last directory separator (before the actual file name)
-	size_t lastSlash = fullPath.find_last_of("\\/");
-	if (lastSlash != std::string::npos)
+	std::error_code error;
+	std::filesystem::create_directories(fullPath, error);
+	if (error)
 	{
-		std::string directoryPath = fullPath.substr(0, lastSlash); // Extract the directory part
-
-		// Create each directory level iteratively
-		std::istringstream dirStream(directoryPath);
-		std::string segment;
-		std::string currentPath;
-
-		while (std::getline(dirStream, segment, '\\')) // Split by `\`
-		{
-			if (!currentPath.empty())
-				currentPath += "\\"; // Append separator only after first segment
-
-			currentPath += segment;
-
-			if (CreateDirectory(currentPath.c_str(), NULL) == 0)
-			{
-				DWORD error = GetLastError();
-				if (error != ERROR_ALREADY_EXISTS)
-				{
-					throw std::runtime_error("Failed to create directory: " + currentPath);
-				}
-			}
-		}
+		throw std::runtime_error("Failed to create directory: " + fullPath.string());
 	}
-
-	return fullPath;
+	return fullPath.string();
 }
@@ -0,0 +1,356 @@
+/**
+ * @author Daan Steenbergen
+ * @brief A synthetic implement ECU that connects to the task controller as a TC client
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright 2026 Daan Steenbergen
+ */
+#include "simulated_implement.hpp"
+#include "log_macros.hpp"
+
+#include "isobus/isobus/can_network_manager.hpp"
+#include "isobus/isobus/isobus_standard_data_description_indices.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <utility>
+
+using isobus::task_controller_object::DeviceElementObject;
+using isobus::task_controller_object::DeviceProcessDataObject;
+
+constexpr std::uint8_t SECTIONS_PER_CONDENSED_GROUP = 16;
+constexpr std::uint16_t NO_PRESENTATION = 0xFFFF;
+
+SimulatedImplement::SimulatedImplement(std::uint32_t identityNumber, const Configuration &configuration) :
+  identityNumber(identityNumber),
+  configuration(configuration)
+{
+}
+
+SimulatedImplement::~SimulatedImplement()
+{
+	terminate();
+}
+
+bool SimulatedImplement::initialize(std::uint8_t canPort)
+{
+	if ((0 == get_number_of_sections()) || (get_number_of_sections() > MAX_NUMBER_OF_SECTIONS))
+	{
+		TC_LOG_ERROR("[Simulator] An implement needs 1 to {} sections, not {}", MAX_NUMBER_OF_SECTIONS, get_number_of_sections());
+		return false;
+	}
+
+	isobus::NAME name(0);
+	name.set_arbitrary_address_capable(true);
+	name.set_industry_group(2);
+	name.set_device_class(6); // Sprayers
+	name.set_function_code(static_cast<std::uint8_t>(isobus::NAME::Function::RateControl));
+	name.set_identity_number(identityNumber);
+	name.set_ecu_instance(0);
+	name.set_function_instance(0);
+	name.set_device_class_instance(0);
+	name.set_manufacturer_code(1407);
+
+	if (!generate_pool(name.get_full_name()))
+	{
+		TC_LOG_ERROR("[Simulator] Failed to generate the DDOP of implement {}", identityNumber);
+		return false;
+	}
+
+	// Addresses from 128 on are free for self-configurable ECUs, the address claim resolves any overlap
+	auto clientCF = isobus::CANNetworkManager::CANNetwork.create_internal_control_function(name, canPort, static_cast<std::uint8_t>(0x80 + (identityNumber % 0x70)));
+	const std::vector<isobus::NAMEFilter> filters = { isobus::NAMEFilter(isobus::NAME::NAMEParameters::FunctionCode, static_cast<std::uint8_t>(isobus::NAME::Function::TaskController)) };
+	auto taskControllerPartner = isobus::CANNetworkManager::CANNetwork.create_partnered_control_function(canPort, filters);
+
+	client = std::make_unique<isobus::TaskControllerClient>(taskControllerPartner, clientCF, nullptr);
+	client->configure(pool,
+	                  configuration.numberOfBooms,
+	                  static_cast<std::uint8_t>(std::min<std::uint16_t>(get_number_of_sections(), 255)),
+	                  0,
+	                  true,
+	                  false,
+	                  false,
+	                  false,
+	                  true);
+	client->add_request_value_callback(on_request_value, this);
+	client->add_value_command_callback(on_value_command, this);
+	client->initialize(false); // Updated from update(), together with the latency of the sections
+	return true;
+}
+
+bool SimulatedImplement::generate_binary_pool(std::uint64_t clientName, std::vector<std::uint8_t> &binaryPool)
+{
+	return generate_pool(clientName) && pool->generate_binary_object_pool(binaryPool);
+}
+
+void SimulatedImplement::update()
+{
+	// Triggers are sent after unlocking, the client may ask for the value right away
+	std::vector<std::pair<std::uint16_t, std::uint16_t>> changedValues;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		auto now = Clock::now();
+		std::vector<std::uint16_t> changedGroups(booms.size(), 0);
+		while (!pendingStates.empty() && (pendingStates.front().dueTime <= now))
+		{
+			const auto &pendingState = pendingStates.front();
+			if (actualStates.test(pendingState.section) != pendingState.isOn)
+			{
+				actualStates.set(pendingState.section, pendingState.isOn);
+				std::uint16_t sectionInBoom = pendingState.section % configuration.numberOfSectionsPerBoom;
+				changedGroups[pendingState.section / configuration.numberOfSectionsPerBoom] |= 1 << (sectionInBoom / SECTIONS_PER_CONDENSED_GROUP);
+			}
+			pendingStates.pop_front();
+		}
+		for (std::size_t i = 0; i < booms.size(); i++)
+		{
+			for (std::uint8_t group = 0; group < MAX_NUMBER_OF_SECTIONS / SECTIONS_PER_CONDENSED_GROUP; group++)
+			{
+				if ((changedGroups[i] >> group) & 1)
+				{
+					changedValues.emplace_back(booms[i].elementNumber, static_cast<std::uint16_t>(isobus::DataDescriptionIndex::ActualCondensedWorkState1_16) + group);
+				}
+			}
+		}
+
+		if (isWorkStatePending && (workStateDueTime <= now))
+		{
+			isWorkStatePending = false;
+			if (isWorking != pendingWorkState)
+			{
+				isWorking = pendingWorkState;
+				changedValues.emplace_back(DEVICE_ELEMENT_NUMBER, static_cast<std::uint16_t>(isobus::DataDescriptionIndex::ActualWorkState));
+			}
+		}
+	}
+
+	if (nullptr != client)
+	{
+		for (const auto &changedValue : changedValues)
+		{
+			client->on_value_changed_trigger(changedValue.first, changedValue.second);
+		}
+		client->update();
+	}
+}
+
+void SimulatedImplement::terminate()
+{
+	if (nullptr != client)
+	{
+		client->terminate();
+		client.reset();
+	}
+}
+
+bool SimulatedImplement::is_connected() const
+{
+	return (nullptr != client) && client->get_is_connected();
+}
+
+std::uint16_t SimulatedImplement::get_number_of_sections() const
+{
+	return static_cast<std::uint16_t>(configuration.numberOfBooms * configuration.numberOfSectionsPerBoom);
+}
+
+std::size_t SimulatedImplement::get_pool_size() const
+{
+	return poolSize;
+}
+
+std::uint32_t SimulatedImplement::get_number_of_set_values() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return numberOfSetValues;
+}
+
+SectionMask SimulatedImplement::get_actual_states() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return actualStates;
+}
+
+SimulatedImplement::Clock::time_point SimulatedImplement::get_next_due_time() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	auto dueTime = Clock::time_point::max();
+	if (!pendingStates.empty())
+	{
+		dueTime = pendingStates.front().dueTime;
+	}
+	if (isWorkStatePending)
+	{
+		dueTime = std::min(dueTime, workStateDueTime);
+	}
+	return dueTime;
+}
+
+bool SimulatedImplement::generate_pool(std::uint64_t clientName)
+{
+	pool = std::make_shared<isobus::DeviceDescriptorObjectPool>();
+	booms.clear();
+
+	// The structure label changes with the shape, so the TC never mixes up pools of different shapes
+	std::array<char, 8> structureLabel;
+	std::snprintf(structureLabel.data(), structureLabel.size(), "S%02u%02u%02u", configuration.numberOfBooms % 100, configuration.numberOfSectionsPerBoom % 100, configuration.elementDepth % 100);
+	bool isAdded = pool->add_device("AOG-TC simulator",
+	                                "1.0",
+	                                std::to_string(identityNumber),
+	                                std::string(structureLabel.data(), 7),
+	                                { 'e', 'n', 0x50, 0x00, 0x55, 0x55, 0xFF },
+	                                {},
+	                                clientName);
+	if (!isAdded)
+	{
+		return false;
+	}
+
+	std::uint16_t nextObjectId = 1; // The device object is 0
+	std::uint16_t nextElementNumber = DEVICE_ELEMENT_NUMBER;
+	auto add_element = [&](const std::string &designator, std::uint16_t parentObjectId, DeviceElementObject::Type type) -> std::shared_ptr<DeviceElementObject> {
+		std::uint16_t objectId = nextObjectId++;
+		isAdded &= pool->add_device_element(designator, nextElementNumber++, parentObjectId, type, objectId);
+		return std::static_pointer_cast<DeviceElementObject>(pool->get_object_by_id(objectId));
+	};
+	auto add_process_data = [&](const std::shared_ptr<DeviceElementObject> &element, const std::string &designator, std::uint16_t ddi, DeviceProcessDataObject::PropertiesBit property, DeviceProcessDataObject::AvailableTriggerMethods triggerMethod) {
+		std::uint16_t objectId = nextObjectId++;
+		isAdded &= pool->add_device_process_data(designator, ddi, NO_PRESENTATION, static_cast<std::uint8_t>(property), static_cast<std::uint8_t>(triggerMethod), objectId);
+		element->add_reference_to_child_object(objectId);
+	};
+	auto add_property = [&](const std::shared_ptr<DeviceElementObject> &element, const std::string &designator, isobus::DataDescriptionIndex ddi, std::int32_t value) {
+		std::uint16_t objectId = nextObjectId++;
+		isAdded &= pool->add_device_property(designator, value, static_cast<std::uint16_t>(ddi), NO_PRESENTATION, objectId);
+		element->add_reference_to_child_object(objectId);
+	};
+
+	auto deviceElement = add_element("Implement", 0, DeviceElementObject::Type::Device);
+	add_process_data(deviceElement, "Section control", static_cast<std::uint16_t>(isobus::DataDescriptionIndex::SectionControlState), DeviceProcessDataObject::PropertiesBit::Settable, DeviceProcessDataObject::AvailableTriggerMethods::OnChange);
+	add_process_data(deviceElement, "Work state", static_cast<std::uint16_t>(isobus::DataDescriptionIndex::ActualWorkState), DeviceProcessDataObject::PropertiesBit::MemberOfDefaultSet, DeviceProcessDataObject::AvailableTriggerMethods::OnChange);
+	add_process_data(deviceElement, "Setpoint work state", static_cast<std::uint16_t>(isobus::DataDescriptionIndex::SetpointWorkState), DeviceProcessDataObject::PropertiesBit::Settable, DeviceProcessDataObject::AvailableTriggerMethods::OnChange);
+	add_property(deviceElement, "Latency", isobus::DataDescriptionIndex::PhysicalSetpointTimeLatency, static_cast<std::int32_t>(configuration.latency.count()));
+
+	// Booms side by side, centered on the reference point
+	const std::int32_t boomWidth_mm = configuration.numberOfSectionsPerBoom * configuration.sectionWidth_mm;
+	const std::int32_t leftEdge_mm = -(configuration.numberOfBooms * boomWidth_mm) / 2;
+	const std::uint8_t numberOfGroups = static_cast<std::uint8_t>((configuration.numberOfSectionsPerBoom + SECTIONS_PER_CONDENSED_GROUP - 1) / SECTIONS_PER_CONDENSED_GROUP);
+	for (std::uint8_t b = 0; b < configuration.numberOfBooms; b++)
+	{
+		std::string boomName = "Boom " + std::to_string(b + 1);
+		auto boomElement = add_element(boomName, deviceElement->get_object_id(), DeviceElementObject::Type::Function);
+		booms.push_back({ boomElement->get_element_number(), static_cast<std::uint16_t>(b * configuration.numberOfSectionsPerBoom) });
+		add_property(boomElement, "Offset X", isobus::DataDescriptionIndex::DeviceElementOffsetX, -1000);
+		add_property(boomElement, "Offset Y", isobus::DataDescriptionIndex::DeviceElementOffsetY, leftEdge_mm + b * boomWidth_mm + boomWidth_mm / 2);
+		add_property(boomElement, "Offset Z", isobus::DataDescriptionIndex::DeviceElementOffsetZ, 0);
+		for (std::uint8_t group = 0; group < numberOfGroups; group++)
+		{
+			add_process_data(boomElement, "Actual states", static_cast<std::uint16_t>(isobus::DataDescriptionIndex::ActualCondensedWorkState1_16) + group, DeviceProcessDataObject::PropertiesBit::MemberOfDefaultSet, DeviceProcessDataObject::AvailableTriggerMethods::OnChange);
+			add_process_data(boomElement, "Setpoint states", static_cast<std::uint16_t>(isobus::DataDescriptionIndex::SetpointCondensedWorkState1_16) + group, DeviceProcessDataObject::PropertiesBit::Settable, DeviceProcessDataObject::AvailableTriggerMethods::OnChange);
+		}
+
+		// Deeper hierarchies make every walk up to the device element longer
+		auto parentElement = boomElement;
+		for (std::uint8_t level = 1; level < configuration.elementDepth; level++)
+		{
+			parentElement = add_element(boomName + " level " + std::to_string(level + 1), parentElement->get_object_id(), DeviceElementObject::Type::Function);
+			add_property(parentElement, "Offset X", isobus::DataDescriptionIndex::DeviceElementOffsetX, -1000);
+			add_property(parentElement, "Offset Y", isobus::DataDescriptionIndex::DeviceElementOffsetY, leftEdge_mm + b * boomWidth_mm + boomWidth_mm / 2);
+			add_property(parentElement, "Offset Z", isobus::DataDescriptionIndex::DeviceElementOffsetZ, 0);
+		}
+
+		for (std::uint8_t s = 0; s < configuration.numberOfSectionsPerBoom; s++)
+		{
+			auto sectionElement = add_element("Section " + std::to_string(b * configuration.numberOfSectionsPerBoom + s + 1), parentElement->get_object_id(), DeviceElementObject::Type::Section);
+			add_property(sectionElement, "Offset X", isobus::DataDescriptionIndex::DeviceElementOffsetX, -1000);
+			add_property(sectionElement, "Offset Y", isobus::DataDescriptionIndex::DeviceElementOffsetY, leftEdge_mm + b * boomWidth_mm + s * configuration.sectionWidth_mm + configuration.sectionWidth_mm / 2);
+			add_property(sectionElement, "Offset Z", isobus::DataDescriptionIndex::DeviceElementOffsetZ, 0);
+			add_property(sectionElement, "Width", isobus::DataDescriptionIndex::ActualWorkingWidth, configuration.sectionWidth_mm);
+		}
+	}
+
+	std::vector<std::uint8_t> binaryPool;
+	if (!isAdded || !pool->generate_binary_object_pool(binaryPool))
+	{
+		return false;
+	}
+	poolSize = binaryPool.size();
+	return true;
+}
+
+const SimulatedImplement::Boom *SimulatedImplement::get_boom(std::uint16_t elementNumber) const
+{
+	for (const auto &boom : booms)
+	{
+		if (boom.elementNumber == elementNumber)
+		{
+			return &boom;
+		}
+	}
+	return nullptr;
+}
+
+bool SimulatedImplement::on_request_value(std::uint16_t elementNumber, std::uint16_t ddi, std::int32_t &value, void *parent)
+{
+	auto implement = static_cast<SimulatedImplement *>(parent);
+	std::lock_guard<std::mutex> lock(implement->mutex);
+	value = 0;
+
+	auto firstGroupDdi = static_cast<std::uint16_t>(isobus::DataDescriptionIndex::ActualCondensedWorkState1_16);
+	auto boom = implement->get_boom(elementNumber);
+	if ((nullptr != boom) && (ddi >= firstGroupDdi) && (ddi <= static_cast<std::uint16_t>(isobus::DataDescriptionIndex::ActualCondensedWorkState241_256)))
+	{
+		std::uint16_t firstSectionInBoom = (ddi - firstGroupDdi) * SECTIONS_PER_CONDENSED_GROUP;
+		std::uint32_t condensedStates = 0;
+		for (std::uint8_t i = 0; i < SECTIONS_PER_CONDENSED_GROUP; i++)
+		{
+			std::uint16_t sectionInBoom = firstSectionInBoom + i;
+			// 0 = off, 1 = on, 3 = not installed
+			std::uint32_t sectionState = (sectionInBoom < implement->configuration.numberOfSectionsPerBoom) ? (implement->actualStates.test(boom->firstSection + sectionInBoom) ? 1 : 0) : 3;
+			condensedStates |= sectionState << (2 * i);
+		}
+		value = static_cast<std::int32_t>(condensedStates);
+	}
+	else if (static_cast<std::uint16_t>(isobus::DataDescriptionIndex::ActualWorkState) == ddi)
+	{
+		value = implement->isWorking ? 1 : 0;
+	}
+	else if (static_cast<std::uint16_t>(isobus::DataDescriptionIndex::SectionControlState) == ddi)
+	{
+		value = implement->isSectionControlEnabled ? 1 : 0;
+	}
+	return true;
+}
+
+bool SimulatedImplement::on_value_command(std::uint16_t elementNumber, std::uint16_t ddi, std::int32_t value, void *parent)
+{
+	auto implement = static_cast<SimulatedImplement *>(parent);
+	std::lock_guard<std::mutex> lock(implement->mutex);
+	implement->numberOfSetValues++;
+	auto dueTime = Clock::now() + implement->configuration.latency;
+
+	auto firstGroupDdi = static_cast<std::uint16_t>(isobus::DataDescriptionIndex::SetpointCondensedWorkState1_16);
+	auto boom = implement->get_boom(elementNumber);
+	if ((nullptr != boom) && (ddi >= firstGroupDdi) && (ddi <= static_cast<std::uint16_t>(isobus::DataDescriptionIndex::SetpointCondensedWorkState241_256)))
+	{
+		std::uint16_t firstSectionInBoom = (ddi - firstGroupDdi) * SECTIONS_PER_CONDENSED_GROUP;
+		for (std::uint8_t i = 0; (i < SECTIONS_PER_CONDENSED_GROUP) && (firstSectionInBoom + i < implement->configuration.numberOfSectionsPerBoom); i++)
+		{
+			std::uint8_t sectionState = (value >> (2 * i)) & 0x03;
+			if (sectionState <= 1) // 2 and 3 ask for no action
+			{
+				implement->pendingStates.push_back({ dueTime, static_cast<std::uint16_t>(boom->firstSection + firstSectionInBoom + i), 1 == sectionState });
+			}
+		}
+	}
+	else if (static_cast<std::uint16_t>(isobus::DataDescriptionIndex::SetpointWorkState) == ddi)
+	{
+		implement->isWorkStatePending = true;
+		implement->pendingWorkState = (1 == value);
+		implement->workStateDueTime = dueTime;
+	}
+	else if (static_cast<std::uint16_t>(isobus::DataDescriptionIndex::SectionControlState) == ddi)
+	{
+		implement->isSectionControlEnabled = (1 == value);
+	}
+	return true;
+}
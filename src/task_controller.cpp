@@ -7,14 +7,49 @@
  * @copyright 2025 Daan Steenbergen
  */
 #include "task_controller.hpp"
+#include "log_macros.hpp"
+#include "metrics.hpp"
 #include "settings.hpp"
 
 #include "isobus/isobus/isobus_device_descriptor_object_pool_helpers.hpp"
 #include "isobus/isobus/isobus_task_controller_server.hpp"
 
-#include <bitset>
+#include <algorithm>
+#include <cstdlib>
 #include <fstream>
-#include <iostream>
+#include <limits>
+#include <string>
+#include <utility>
+
+/**
+ * @brief Calculate which fraction of a boom's width lies within the lateral extent of another boom
+ * @param sections The lateral geometry of all sections, in section index order
+ * @param boom The boom to calculate the fraction for
+ * @param otherBoom The boom to compare against
+ * @return The overlapping fraction of the boom's width, 0 if it has no width
+ */
+static double get_lateral_overlap(const std::vector<VirtualSectionMapping::LateralSection> &sections, const BoomState &boom, const BoomState &otherBoom)
+{
+	auto get_extent = [&sections](const BoomState &extentBoom, std::int32_t &left, std::int32_t &right) {
+		left = std::numeric_limits<std::int32_t>::max();
+		right = std::numeric_limits<std::int32_t>::min();
+		for (std::uint8_t i = extentBoom.firstSection; i < extentBoom.firstSection + extentBoom.numberOfSections; i++)
+		{
+			left = std::min(left, sections[i].yOffset_mm - sections[i].width_mm / 2);
+			right = std::max(right, sections[i].yOffset_mm + sections[i].width_mm / 2);
+		}
+	};
+
+	std::int32_t left, right, otherLeft, otherRight;
+	get_extent(boom, left, right);
+	get_extent(otherBoom, otherLeft, otherRight);
+	if (right <= left)
+	{
+		return 0.0;
+	}
+	std::int32_t overlap = std::min(right, otherRight) - std::max(left, otherLeft);
+	return std::max(overlap, 0) / static_cast<double>(right - left);
+}
 
 void ClientState::set_number_of_sections(std::uint8_t number)
 {
@@ -22,6 +57,9 @@ void ClientState::set_number_of_sections(std::uint8_t number)
 	sectionSetpointStates.resize(number);
 	sectionActualStates.resize(number);
 	sectionToElementNumber.resize(number, 0); // Initialize all sections mapped to element 0 by default
+	sectionScheduler.set_number_of_sections(number);
+	latencyProfiler.set_number_of_sections(number);
+	update_actual_states();
 }
 
 void ClientState::set_section_setpoint_state(std::uint8_t section, std::uint8_t state)
@@ -75,9 +113,7 @@ std::uint8_t ClientState::get_section_actual_state(std::uint8_t section) const
 {
 	if (section < numberOfSections)
 	{
-		// Check if the element or any parent is off
-		std::uint16_t elementNumber = get_element_number_for_section(section);
-		if (is_element_or_parent_off(elementNumber))
+		if (sectionsOffByElement.test(section))
 		{
 			return SectionState::OFF;
 		}
@@ -86,6 +122,29 @@ std::uint8_t ClientState::get_section_actual_state(std::uint8_t section) const
 	return SectionState::NOT_INSTALLED;
 }
 
+const SectionMask &ClientState::get_section_actual_states() const
+{
+	return effectiveActualStates;
+}
+
+void ClientState::update_actual_states()
+{
+	// Walking the hierarchy is proportional to the pool size, so it's done once per report instead of on every read.
+	// The sections of a condensed group share their element, so consecutive sections reuse the previous result.
+	effectiveActualStates.clear();
+	sectionsOffByElement.clear();
+	bool isElementOff = false;
+	for (std::uint16_t i = 0; i < numberOfSections; i++)
+	{
+		if ((0 == i) || (sectionToElementNumber[i] != sectionToElementNumber[i - 1]))
+		{
+			isElementOff = is_element_or_parent_off(sectionToElementNumber[i]);
+		}
+		sectionsOffByElement.set(i, isElementOff);
+		effectiveActualStates.set(i, !isElementOff && (sectionActualStates[i] == SectionState::ON));
+	}
+}
+
 bool ClientState::is_any_section_setpoint_on() const
 {
 	for (std::uint8_t state : sectionSetpointStates)
@@ -150,7 +209,7 @@ std::uint16_t ClientState::get_element_number_for_ddi(isobus::DataDescriptionInd
 	{
 		return it->second;
 	}
-	std::cout << "Cached element number not found for DDI " << static_cast<int>(ddi) << std::endl;
+	TC_LOG_WARNING_EVERY(10000, "Cached element number not found for DDI {}", ddi);
 	return 0;
 }
 
@@ -225,10 +284,269 @@ bool ClientState::try_get_element_work_state(std::uint16_t elementNumber, bool &
 	return false;
 }
 
+SectionScheduler &ClientState::get_section_scheduler()
+{
+	return sectionScheduler;
+}
+
+const SectionScheduler &ClientState::get_section_scheduler() const
+{
+	return sectionScheduler;
+}
+
+CoverageMap &ClientState::get_coverage_map()
+{
+	return coverageMap;
+}
+
+const CoverageMap &ClientState::get_coverage_map() const
+{
+	return coverageMap;
+}
+
+VirtualSectionMapping &ClientState::get_section_mapping()
+{
+	return sectionMapping;
+}
+
+const VirtualSectionMapping &ClientState::get_section_mapping() const
+{
+	return sectionMapping;
+}
+
+WorkStatistics &ClientState::get_work_statistics()
+{
+	return workStatistics;
+}
+
+const WorkStatistics &ClientState::get_work_statistics() const
+{
+	return workStatistics;
+}
+
+SectionLatencyProfiler &ClientState::get_latency_profiler()
+{
+	return latencyProfiler;
+}
+
+const SectionLatencyProfiler &ClientState::get_latency_profiler() const
+{
+	return latencyProfiler;
+}
+
+void ClientState::add_boom(const BoomState &boom, const std::vector<std::uint16_t> &elementNumbers)
+{
+	auto boomIndex = static_cast<std::uint8_t>(booms.size());
+	booms.push_back(boom);
+	for (std::uint16_t elementNumber : elementNumbers)
+	{
+		elementToBoomIndex[elementNumber] = boomIndex;
+	}
+	sectionToBoomIndex.resize(boom.firstSection + boom.numberOfSections, boomIndex);
+	numberOfAogSections = std::max<std::uint16_t>(numberOfAogSections, boom.aogSectionOffset + boom.numberOfSections);
+}
+
+std::vector<BoomState> &ClientState::get_booms()
+{
+	return booms;
+}
+
+std::uint8_t ClientState::get_boom_index_for_element(std::uint16_t elementNumber) const
+{
+	auto it = elementToBoomIndex.find(elementNumber);
+	if (it != elementToBoomIndex.end())
+	{
+		return it->second;
+	}
+	return 0; // Elements above the booms (e.g. the device itself) are treated as part of the first boom
+}
+
+std::uint8_t ClientState::get_boom_index_for_section(std::uint8_t section) const
+{
+	if (section < sectionToBoomIndex.size())
+	{
+		return sectionToBoomIndex[section];
+	}
+	return 0;
+}
+
+void ClientState::set_element_number_for_boom_ddi(std::uint16_t ddi, std::uint16_t elementNumber)
+{
+	if (!booms.empty())
+	{
+		booms[get_boom_index_for_element(elementNumber)].condensedElementNumbers[ddi] = elementNumber;
+	}
+}
+
+void ClientState::mark_section_setpoint_changed(std::uint8_t section)
+{
+	if (!booms.empty())
+	{
+		auto &boom = booms[get_boom_index_for_section(section)];
+		boom.pendingGroups |= (1 << ((section - boom.firstSection) / NUMBER_SECTIONS_PER_CONDENSED_MESSAGE));
+	}
+}
+
+SectionMask ClientState::map_aog_section_states(const SectionMask &aogStates) const
+{
+	if (sectionMapping.is_enabled())
+	{
+		return sectionMapping.to_physical(aogStates);
+	}
+	if (booms.empty())
+	{
+		return aogStates;
+	}
+
+	SectionMask states;
+	for (const auto &boom : booms)
+	{
+		for (std::uint8_t i = 0; i < boom.numberOfSections; i++)
+		{
+			states.set(boom.firstSection + i, aogStates.test(boom.aogSectionOffset + i));
+		}
+	}
+	return states;
+}
+
+SectionMask ClientState::get_aog_section_actual_states() const
+{
+	return to_aog_sections(get_section_actual_states());
+}
+
+SectionMask ClientState::to_aog_sections(const SectionMask &sections) const
+{
+	if (sectionMapping.is_enabled())
+	{
+		return sectionMapping.to_virtual(sections);
+	}
+	if (booms.empty())
+	{
+		return sections;
+	}
+
+	// An AOG section is set when it is set for any of the booms that follow it
+	SectionMask aogSections;
+	for (const auto &boom : booms)
+	{
+		for (std::uint8_t i = 0; i < boom.numberOfSections; i++)
+		{
+			if (sections.test(boom.firstSection + i))
+			{
+				aogSections.set(boom.aogSectionOffset + i);
+			}
+		}
+	}
+	return aogSections;
+}
+
+std::uint8_t ClientState::get_number_of_aog_sections() const
+{
+	if (sectionMapping.is_enabled())
+	{
+		return sectionMapping.get_number_of_virtual_sections();
+	}
+	if (booms.empty())
+	{
+		return numberOfSections;
+	}
+	return static_cast<std::uint8_t>(std::min<std::uint16_t>(numberOfAogSections, MAX_NUMBER_OF_SECTIONS_TOTAL));
+}
+
+bool ClientState::get_condensed_group_sections(std::uint16_t elementNumber, std::uint8_t group, std::uint8_t &firstSection, std::uint8_t &numberOfSections) const
+{
+	std::uint8_t groupOffset = NUMBER_SECTIONS_PER_CONDENSED_MESSAGE * group;
+	if (booms.empty())
+	{
+		firstSection = groupOffset;
+		numberOfSections = NUMBER_SECTIONS_PER_CONDENSED_MESSAGE;
+		return true;
+	}
+
+	// Each boom addresses its own sections, numbered from 1 on that boom
+	const auto &boom = booms[get_boom_index_for_element(elementNumber)];
+	if (groupOffset >= boom.numberOfSections)
+	{
+		return false;
+	}
+	firstSection = boom.firstSection + groupOffset;
+	numberOfSections = std::min<std::uint8_t>(NUMBER_SECTIONS_PER_CONDENSED_MESSAGE, boom.numberOfSections - groupOffset);
+	return true;
+}
+
+bool ClientState::set_section_override_state(std::uint8_t section, bool overridden)
+{
+	if (sectionOverrideStates.test(section) == overridden)
+	{
+		return false;
+	}
+	sectionOverrideStates.set(section, overridden);
+	return true;
+}
+
+bool ClientState::is_section_overridden(std::uint8_t section) const
+{
+	return sectionOverrideStates.test(section);
+}
+
+SectionMask ClientState::get_aog_section_override_states() const
+{
+	return to_aog_sections(sectionOverrideStates);
+}
+
+SectionMask ClientState::take_section_request_changes(const SectionMask &requestedStates)
+{
+	SectionMask changes = requestedStates ^ lastSectionRequest;
+	if (!isSectionRequestValid)
+	{
+		for (std::uint8_t i = 0; i < numberOfSections; i++)
+		{
+			changes.set(i);
+		}
+		isSectionRequestValid = true;
+	}
+	lastSectionRequest = requestedStates;
+	return changes;
+}
+
+void ClientState::invalidate_section_request()
+{
+	isSectionRequestValid = false;
+}
+
+void ClientState::add_rate_control_target(const RateControlTarget &target)
+{
+	rateControlTargets.push_back(target);
+}
+
+std::vector<RateControlTarget> &ClientState::get_rate_control_targets()
+{
+	return rateControlTargets;
+}
+
+void ClientState::add_measurement_subscription(std::uint16_t ddi, std::uint16_t elementNumber, std::uint32_t timeInterval_ms, bool isOnChange)
+{
+	for (auto &subscription : measurementSubscriptions)
+	{
+		if ((subscription.ddi == ddi) && (subscription.elementNumber == elementNumber))
+		{
+			subscription.timeInterval_ms = (0 != timeInterval_ms) ? timeInterval_ms : subscription.timeInterval_ms;
+			subscription.isOnChange = subscription.isOnChange || isOnChange;
+			return;
+		}
+	}
+	measurementSubscriptions.push_back({ ddi, elementNumber, timeInterval_ms, isOnChange });
+}
+
+const std::vector<MeasurementSubscription> &ClientState::get_measurement_subscriptions() const
+{
+	return measurementSubscriptions;
+}
+
 MyTCServer::MyTCServer(std::shared_ptr<isobus::InternalControlFunction> internalControlFunction) :
   TaskControllerServer(internalControlFunction,
-                       1, // AOG limits to 1 boom
-                       16, // AOG limits to 16 sections of unique width
+                       MAX_NUMBER_OF_BOOMS, // Each boom has its own condensed work states
+                       MAX_NUMBER_OF_SECTIONS_TOTAL, // AOG's sections are mapped onto all sections of all booms
                        16, // 16 channels for position based control
                        isobus::TaskControllerOptions()
                          .with_implement_section_control(), // We support section control
@@ -258,7 +576,7 @@ bool MyTCServer::activate_object_pool(std::shared_ptr<isobus::ControlFunction> p
 	}
 	if (deserialized)
 	{
-		std::cout << "Successfully deserialized device descriptor object pool." << std::endl;
+		TC_LOG_INFO("Successfully deserialized device descriptor object pool.");
 
 		// Save to NVM
 		std::shared_ptr<isobus::task_controller_object::DeviceObject> deviceObject;
@@ -271,7 +589,7 @@ bool MyTCServer::activate_object_pool(std::shared_ptr<isobus::ControlFunction> p
 				break;
 			}
 		}
-		auto fileName = std::to_string(partnerCF->get_NAME().get_full_name()) + "\\" + std::string(deviceObject->get_localization_label().begin(), deviceObject->get_localization_label().end()) + ".iop";
+		auto fileName = std::to_string(partnerCF->get_NAME().get_full_name()) + "/" + std::string(deviceObject->get_localization_label().begin(), deviceObject->get_localization_label().end()) + ".iop";
 		std::vector<std::uint8_t> binaryPool;
 		if (state.get_pool().generate_binary_object_pool(binaryPool))
 		{
@@ -283,54 +601,147 @@ bool MyTCServer::activate_object_pool(std::shared_ptr<isobus::ControlFunction> p
 			}
 			else
 			{
-				std::cout << "Unable to save DDOP to NVM. (Failed to open file)" << std::endl;
+				TC_LOG_ERROR("Unable to save DDOP to NVM. (Failed to open file)");
 			}
 		}
 		else
 		{
-			std::cout << "Unable to save DDOP to NVM. (Failed to generate binary object pool)" << std::endl;
+			TC_LOG_ERROR("Unable to save DDOP to NVM. (Failed to generate binary object pool)");
 		}
 
 		auto implement = isobus::DeviceDescriptorObjectPoolHelper::get_implement_geometry(state.get_pool());
 		std::uint8_t numberOfSections = 0;
-
-		std::cout << "Implement geometry: " << std::endl;
-		std::cout << "Number of booms=" << implement.booms.size() << std::endl;
+		std::vector<std::uint16_t> sectionElementNumbers;
+		std::vector<CoverageMap::SectionGeometry> sectionGeometries;
+		std::vector<VirtualSectionMapping::LateralSection> lateralSections;
+		std::map<std::uint16_t, std::pair<std::uint8_t, std::uint8_t>> elementSections; ///< First section and number of sections below each element
+
+		auto add_section = [&](const isobus::DeviceDescriptorObjectPoolHelper::Section &section) {
+			elementSections[section.elementNumber] = { numberOfSections, 1 };
+			numberOfSections++;
+			sectionElementNumbers.push_back(section.elementNumber);
+			sectionGeometries.push_back({ section.xOffset_mm.get() / 1000.0, section.yOffset_mm.get() / 1000.0, section.width_mm.get() / 1000.0 });
+			lateralSections.push_back({ section.yOffset_mm.get(), section.width_mm.get() });
+			TC_LOG_INFO("Section: id={}, X offset: {}, Y offset: {}, Z offset: {}, width: {}",
+			            section.elementNumber,
+			            section.xOffset_mm.get(),
+			            section.yOffset_mm.get(),
+			            section.zOffset_mm.get(),
+			            section.width_mm.get());
+		};
+
+		TC_LOG_INFO("Implement geometry: number of booms={}", implement.booms.size());
+		std::uint16_t nextAogSection = 0;
 		for (const auto &boom : implement.booms)
 		{
-			std::cout << "Boom: id=" << static_cast<int>(boom.elementNumber) << std::endl;
+			TC_LOG_INFO("Boom: id={}", boom.elementNumber);
+			BoomState boomState;
+			boomState.elementNumber = boom.elementNumber;
+			boomState.firstSection = numberOfSections;
+			std::vector<std::uint16_t> boomElementNumbers = { boom.elementNumber };
 			for (const auto &subBoom : boom.subBooms)
 			{
-				std::cout << "SubBoom: id=" << static_cast<int>(subBoom.elementNumber) << std::endl;
+				TC_LOG_INFO("SubBoom: id={}", subBoom.elementNumber);
+				boomElementNumbers.push_back(subBoom.elementNumber);
+				std::uint8_t subBoomFirstSection = numberOfSections;
 				for (const auto &section : subBoom.sections)
 				{
-					numberOfSections++;
-					std::cout << "Section: id=" << static_cast<int>(section.elementNumber) << std::endl;
-					std::cout << "X Offset: " << section.xOffset_mm.get() << std::endl;
-					std::cout << "Y Offset: " << section.yOffset_mm.get() << std::endl;
-					std::cout << "Z Offset: " << section.zOffset_mm.get() << std::endl;
-					std::cout << "Width: " << section.width_mm.get() << std::endl;
+					add_section(section);
+					boomElementNumbers.push_back(section.elementNumber);
 				}
+				elementSections[subBoom.elementNumber] = { subBoomFirstSection, static_cast<std::uint8_t>(numberOfSections - subBoomFirstSection) };
 			}
 			for (const auto &section : boom.sections)
 			{
-				numberOfSections++;
-				std::cout << "Section: id=" << static_cast<int>(section.elementNumber) << std::endl;
-				std::cout << "X Offset: " << section.xOffset_mm.get() << std::endl;
-				std::cout << "Y Offset: " << section.yOffset_mm.get() << std::endl;
-				std::cout << "Z Offset: " << section.zOffset_mm.get() << std::endl;
-				std::cout << "Width: " << section.width_mm.get() << std::endl;
+				add_section(section);
+				boomElementNumbers.push_back(section.elementNumber);
+			}
+			boomState.numberOfSections = numberOfSections - boomState.firstSection;
+			elementSections[boom.elementNumber] = { boomState.firstSection, boomState.numberOfSections };
+
+			// Booms that work the same strip (e.g. seeder and fertilizer) follow the same AOG sections,
+			// booms that are next to each other are addressed one after the other
+			boomState.aogSectionOffset = nextAogSection;
+			bool isParallel = false;
+			for (auto &otherBoom : state.get_booms())
+			{
+				if (get_lateral_overlap(lateralSections, boomState, otherBoom) > 0.5)
+				{
+					boomState.aogSectionOffset = otherBoom.aogSectionOffset;
+					isParallel = true;
+					break;
+				}
+			}
+			if (!isParallel)
+			{
+				nextAogSection += boomState.numberOfSections;
 			}
+			TC_LOG_INFO("Boom {} has {} sections, driven by AOG section {} and up",
+			            state.get_booms().size(),
+			            boomState.numberOfSections,
+			            boomState.aogSectionOffset + 1);
+			state.add_boom(boomState, boomElementNumbers);
 		}
 		state.set_number_of_sections(numberOfSections);
+
+		auto &scheduler = state.get_section_scheduler();
+		scheduler.set_look_ahead(sectionLookAheadOn_ms, sectionLookAheadOff_ms);
+		for (std::uint8_t i = 0; i < numberOfSections; i++)
+		{
+			std::uint32_t latency_ms = get_section_latency(state.get_pool(), sectionElementNumbers[i]);
+			scheduler.set_section_latency(i, latency_ms, latency_ms);
+			TC_LOG_INFO("Section {} latency: {} ms", i, latency_ms);
+		}
+		state.get_coverage_map().set_max_tiles(coverageMaxTilesPerClient);
+		state.get_coverage_map().set_sections(sectionGeometries);
+		std::vector<std::uint32_t> sectionWidths;
+		for (const auto &section : lateralSections)
+		{
+			sectionWidths.push_back(static_cast<std::uint32_t>(std::max(section.width_mm, 0)));
+		}
+		state.get_work_statistics().set_section_widths(std::move(sectionWidths));
+		add_rate_control_targets(state, elementSections);
+
+		// AOG only switches the sections the steer data carries, more are squeezed onto those by width
+		std::uint8_t numberOfMappedSections = numberOfVirtualSections;
+		if (numberOfMappedSections > MAX_NUMBER_OF_AOG_SECTIONS)
+		{
+			TC_LOG_WARNING("AOG switches at most {} sections, using {} instead of {} virtual sections", MAX_NUMBER_OF_AOG_SECTIONS, MAX_NUMBER_OF_AOG_SECTIONS, numberOfMappedSections);
+			numberOfMappedSections = MAX_NUMBER_OF_AOG_SECTIONS;
+		}
+		else if ((0 == numberOfMappedSections) && (state.get_number_of_aog_sections() > MAX_NUMBER_OF_AOG_SECTIONS))
+		{
+			TC_LOG_WARNING("The implement needs {} AOG sections but AOG switches at most {}, they are mapped by width", state.get_number_of_aog_sections(), MAX_NUMBER_OF_AOG_SECTIONS);
+			numberOfMappedSections = MAX_NUMBER_OF_AOG_SECTIONS;
+		}
+
+		if ((numberOfMappedSections > 0) && (numberOfSections > numberOfMappedSections) &&
+		    state.get_section_mapping().configure(lateralSections, numberOfMappedSections))
+		{
+			for (std::uint8_t i = 0; i < numberOfMappedSections; i++)
+			{
+				std::string sections;
+				for (const auto &overlap : state.get_section_mapping().get_overlaps(i))
+				{
+					sections += " " + std::to_string(overlap.physicalSection) + " (" + std::to_string(static_cast<int>(overlap.fraction * 100)) + "%)";
+				}
+				TC_LOG_INFO("AOG section {} maps to sections:{}", i, sections);
+			}
+		}
+		else if (state.get_number_of_aog_sections() > MAX_NUMBER_OF_AOG_SECTIONS)
+		{
+			TC_LOG_WARNING("Sections driven by AOG section {} and up can't be switched, AOG switches at most {} sections", MAX_NUMBER_OF_AOG_SECTIONS + 1, MAX_NUMBER_OF_AOG_SECTIONS);
+		}
 	}
 	else
 	{
-		std::cout << "Failed to deserialize device descriptor object pool." << std::endl;
+		TC_LOG_ERROR("Failed to deserialize device descriptor object pool.");
 		return false;
 	}
 
-	clients[partnerCF] = state;
+	taskDataWriter.add_device(partnerCF->get_NAME().get_full_name(), state.get_pool());
+	eventJournal.log_pool_activated(partnerCF->get_NAME().get_full_name(), state.get_number_of_sections(), static_cast<std::uint8_t>(state.get_booms().size()));
+	clients[partnerCF] = std::move(state);
 	return true;
 }
 
@@ -341,6 +752,8 @@ bool MyTCServer::change_designator(std::shared_ptr<isobus::ControlFunction>, std
 
 bool MyTCServer::deactivate_object_pool(std::shared_ptr<isobus::ControlFunction> partnerCF)
 {
+	eventJournal.log_client_disconnected(partnerCF->get_NAME().get_full_name());
+	taskDataWriter.remove_device(partnerCF->get_NAME().get_full_name());
 	clients.erase(partnerCF);
 	uploadedPools.erase(partnerCF);
 	return true;
@@ -348,13 +761,16 @@ bool MyTCServer::deactivate_object_pool(std::shared_ptr<isobus::ControlFunction>
 
 bool MyTCServer::delete_device_descriptor_object_pool(std::shared_ptr<isobus::ControlFunction> partnerCF, ObjectPoolDeletionErrors &)
 {
+	taskDataWriter.remove_device(partnerCF->get_NAME().get_full_name());
 	clients.erase(partnerCF);
 	uploadedPools.erase(partnerCF);
 	return true;
 }
 
-bool MyTCServer::get_is_stored_device_descriptor_object_pool_by_structure_label(std::shared_ptr<isobus::ControlFunction>, const std::vector<std::uint8_t> &, const std::vector<std::uint8_t> &)
+bool MyTCServer::get_is_stored_device_descriptor_object_pool_by_structure_label(std::shared_ptr<isobus::ControlFunction> partnerCF, const std::vector<std::uint8_t> &, const std::vector<std::uint8_t> &)
 {
+	// The first thing a client asks after connecting
+	eventJournal.log_client_connected(partnerCF->get_NAME().get_full_name(), partnerCF->get_address());
 	return false;
 }
 
@@ -377,6 +793,8 @@ void MyTCServer::identify_task_controller(std::uint8_t)
 void MyTCServer::on_client_timeout(std::shared_ptr<isobus::ControlFunction> partner)
 {
 	// Cleanup the client state
+	eventJournal.log_client_disconnected(partner->get_NAME().get_full_name());
+	taskDataWriter.remove_device(partner->get_NAME().get_full_name());
 	clients.erase(partner);
 }
 
@@ -387,15 +805,28 @@ void MyTCServer::on_process_data_acknowledge(std::shared_ptr<isobus::ControlFunc
                                              ProcessDataCommands processDataCommand)
 {
 	// This callback lets you know when a client sends a process data acknowledge (PDACK) message to you
-	std::cout << "Received process data acknowledge from client " << int(partner->get_address()) << " for DDI " << dataDescriptionIndex << " element " << elementNumber << " with error codes " << std::bitset<8>(errorCodesFromClient) << " and command " << static_cast<int>(processDataCommand) << std::endl;
+	TC_LOG_DEBUG("Received process data acknowledge from client {} for DDI {} element {} with error codes {} and command {}",
+	             partner->get_address(),
+	             dataDescriptionIndex,
+	             elementNumber,
+	             errorCodesFromClient,
+	             processDataCommand);
+	if (0 != errorCodesFromClient)
+	{
+		Metrics::count_process_data_acknowledge_error(partner->get_NAME().get_full_name());
+		eventJournal.log_process_data_acknowledge_error(partner->get_NAME().get_full_name(), dataDescriptionIndex, elementNumber, errorCodesFromClient, static_cast<std::uint8_t>(processDataCommand));
+	}
 }
 
 bool MyTCServer::on_value_command(std::shared_ptr<isobus::ControlFunction> partner,
                                   std::uint16_t dataDescriptionIndex,
                                   std::uint16_t elementNumber,
                                   std::int32_t processDataValue,
-                                  std::uint8_t &errorCodes)
+                                  std::uint8_t &)
 {
+	taskDataWriter.set_value(partner->get_NAME().get_full_name(), elementNumber, dataDescriptionIndex, processDataValue);
+	processDataHistory.add(partner->get_NAME().get_full_name(), elementNumber, dataDescriptionIndex, processDataValue, ProcessDataHistory::Clock::now());
+
 	switch (dataDescriptionIndex)
 	{
 		case static_cast<std::uint16_t>(isobus::DataDescriptionIndex::ActualCondensedWorkState1_16):
@@ -415,13 +846,75 @@ bool MyTCServer::on_value_command(std::shared_ptr<isobus::ControlFunction> partn
 		case static_cast<std::uint16_t>(isobus::DataDescriptionIndex::ActualCondensedWorkState225_240):
 		case static_cast<std::uint16_t>(isobus::DataDescriptionIndex::ActualCondensedWorkState241_256):
 		{
-			std::uint8_t sectionIndexOffset = NUMBER_SECTIONS_PER_CONDENSED_MESSAGE * static_cast<std::uint8_t>(dataDescriptionIndex - static_cast<std::uint16_t>(isobus::DataDescriptionIndex::ActualCondensedWorkState1_16));
+			auto &state = clients[partner];
+			auto group = static_cast<std::uint8_t>(dataDescriptionIndex - static_cast<std::uint16_t>(isobus::DataDescriptionIndex::ActualCondensedWorkState1_16));
+			std::uint8_t sectionIndexOffset = 0;
+			std::uint8_t numberOfSectionsInGroup = 0;
+			if (!state.get_condensed_group_sections(elementNumber, group, sectionIndexOffset, numberOfSectionsInGroup))
+			{
+				break;
+			}
 
-			for (std::uint_fast8_t i = 0; i < NUMBER_SECTIONS_PER_CONDENSED_MESSAGE; i++)
+			auto now = SectionLatencyProfiler::Clock::now();
+			for (std::uint_fast8_t i = 0; i < numberOfSectionsInGroup; i++)
 			{
 				std::uint8_t sectionState = ((processDataValue >> (2 * i)) & 0x03);
-				clients[partner].set_section_actual_state(i + sectionIndexOffset, sectionState);
-				clients[partner].set_element_number_for_section(i + sectionIndexOffset, elementNumber);
+				state.get_latency_profiler().on_actual_state(i + sectionIndexOffset, sectionState == SectionState::ON, now);
+				state.set_section_actual_state(i + sectionIndexOffset, sectionState);
+				state.set_element_number_for_section(i + sectionIndexOffset, elementNumber);
+			}
+			state.update_actual_states();
+			state.get_work_statistics().update_section_states(state.get_section_actual_states(), WorkStatistics::Clock::now());
+			eventJournal.log_section_change(partner->get_NAME().get_full_name(), state.get_number_of_sections(), state.get_section_actual_states());
+		}
+		break;
+
+		case static_cast<std::uint16_t>(isobus::DataDescriptionIndex::CondensedSectionOverrideState1_16):
+		case static_cast<std::uint16_t>(isobus::DataDescriptionIndex::CondensedSectionOverrideState17_32):
+		case static_cast<std::uint16_t>(isobus::DataDescriptionIndex::CondensedSectionOverrideState33_48):
+		case static_cast<std::uint16_t>(isobus::DataDescriptionIndex::CondensedSectionOverrideState49_64):
+		case static_cast<std::uint16_t>(isobus::DataDescriptionIndex::CondensedSectionOverrideState65_80):
+		case static_cast<std::uint16_t>(isobus::DataDescriptionIndex::CondensedSectionOverrideState81_96):
+		case static_cast<std::uint16_t>(isobus::DataDescriptionIndex::CondensedSectionOverrideState97_112):
+		case static_cast<std::uint16_t>(isobus::DataDescriptionIndex::CondensedSectionOverrideState113_128):
+		case static_cast<std::uint16_t>(isobus::DataDescriptionIndex::CondensedSectionOverrideState129_144):
+		case static_cast<std::uint16_t>(isobus::DataDescriptionIndex::CondensedSectionOverrideState145_160):
+		case static_cast<std::uint16_t>(isobus::DataDescriptionIndex::CondensedSectionOverrideState161_176):
+		case static_cast<std::uint16_t>(isobus::DataDescriptionIndex::CondensedSectionOverrideState177_192):
+		case static_cast<std::uint16_t>(isobus::DataDescriptionIndex::CondensedSectionOverrideState193_208):
+		case static_cast<std::uint16_t>(isobus::DataDescriptionIndex::CondensedSectionOverrideState209_224):
+		case static_cast<std::uint16_t>(isobus::DataDescriptionIndex::CondensedSectionOverrideState225_240):
+		case static_cast<std::uint16_t>(isobus::DataDescriptionIndex::CondensedSectionOverrideState241_256):
+		{
+			auto &state = clients[partner];
+			auto group = static_cast<std::uint8_t>(dataDescriptionIndex - static_cast<std::uint16_t>(isobus::DataDescriptionIndex::CondensedSectionOverrideState1_16));
+			std::uint8_t sectionIndexOffset = 0;
+			std::uint8_t numberOfSectionsInGroup = 0;
+			if (!state.get_condensed_group_sections(elementNumber, group, sectionIndexOffset, numberOfSectionsInGroup))
+			{
+				break;
+			}
+
+			bool isChanged = false;
+			for (std::uint_fast8_t i = 0; i < numberOfSectionsInGroup; i++)
+			{
+				// 0 = not overridden, 1 = overridden, 2 = error, 3 = not installed
+				bool isOverridden = (((processDataValue >> (2 * i)) & 0x03) == 1);
+				if (state.set_section_override_state(i + sectionIndexOffset, isOverridden))
+				{
+					isChanged = true;
+					// Released sections get their setpoint again with the next update, overridden ones are masked out of it
+					state.mark_section_setpoint_changed(i + sectionIndexOffset);
+				}
+			}
+			if (isChanged)
+			{
+				state.invalidate_section_request();
+			}
+
+			if (isChanged && sectionStatusCallback)
+			{
+				sectionStatusCallback(state);
 			}
 		}
 		break;
@@ -429,14 +922,26 @@ bool MyTCServer::on_value_command(std::shared_ptr<isobus::ControlFunction> partn
 		case static_cast<std::uint16_t>(isobus::DataDescriptionIndex::SectionControlState):
 		{
 			clients[partner].set_section_control_enabled(processDataValue == 1);
+			clients[partner].invalidate_section_request();
 		}
 		break;
 
 		case static_cast<std::uint16_t>(isobus::DataDescriptionIndex::ActualWorkState):
 		{
 			// Store the work state per element rather than globally
-			clients[partner].set_element_work_state(elementNumber, processDataValue == 1);
+			auto &state = clients[partner];
+			state.set_element_work_state(elementNumber, processDataValue == 1);
+			state.update_actual_states();
+			state.get_work_statistics().update_section_states(state.get_section_actual_states(), WorkStatistics::Clock::now());
+			eventJournal.log_section_change(partner->get_NAME().get_full_name(), state.get_number_of_sections(), state.get_section_actual_states());
+		}
+		break;
+
+		default:
+		{
+			taskTotals.update(partner->get_NAME().get_full_name(), elementNumber, dataDescriptionIndex, processDataValue);
 		}
+		break;
 	}
 
 	return true;
@@ -489,19 +994,19 @@ void MyTCServer::request_measurement_commands()
 									{
 										// TODO: This is a bit of a hack, but it works for now
 										client.second.set_element_number_for_ddi(static_cast<isobus::DataDescriptionIndex>(processDataObject->get_ddi()), elementObject->get_element_number());
-										const auto &entryB = isobus::DataDictionary::get_entry(processDataObject->get_ddi());
-										std::cout << "Mapped DDI " << processDataObject->get_ddi() << " (" << entryB.to_string() << ") to element "
-										          << elementObject->get_element_number() << std::endl;
+										client.second.set_element_number_for_boom_ddi(processDataObject->get_ddi(), elementObject->get_element_number());
+										TC_LOG_INFO("Mapped DDI {} ({}) to element {}", processDataObject->get_ddi(), isobus::DataDictionary::get_entry(processDataObject->get_ddi()).name, elementObject->get_element_number());
 
 										if (processDataObject->has_trigger_method(isobus::task_controller_object::DeviceProcessDataObject::AvailableTriggerMethods::OnChange))
 										{
 											send_change_threshold_measurement_command(client.first, processDataObject->get_ddi(), elementObject->get_element_number(), 1);
-											std::cout << "Subscribed (OnChange) to DDI " << processDataObject->get_ddi() << " (" << entryB.to_string() << ") for element "
-											          << elementObject->get_element_number() << std::endl;
+											client.second.add_measurement_subscription(processDataObject->get_ddi(), elementObject->get_element_number(), 0, true);
+											TC_LOG_INFO("Subscribed (OnChange) to DDI {} ({}) for element {}", processDataObject->get_ddi(), isobus::DataDictionary::get_entry(processDataObject->get_ddi()).name, elementObject->get_element_number());
 										}
 										if (processDataObject->has_trigger_method(isobus::task_controller_object::DeviceProcessDataObject::AvailableTriggerMethods::TimeInterval))
 										{
 											send_time_interval_measurement_command(client.first, processDataObject->get_ddi(), elementObject->get_element_number(), 1000);
+											client.second.add_measurement_subscription(processDataObject->get_ddi(), elementObject->get_element_number(), 1000, false);
 										}
 									}
 								}
@@ -536,18 +1041,17 @@ void MyTCServer::request_measurement_commands()
 									{
 										// TODO: This is a bit of a hack, but it works for now
 										client.second.set_element_number_for_ddi(static_cast<isobus::DataDescriptionIndex>(processDataObject->get_ddi()), elementObject->get_element_number());
-										const auto &entryB = isobus::DataDictionary::get_entry(processDataObject->get_ddi());
+										client.second.set_element_number_for_boom_ddi(processDataObject->get_ddi(), elementObject->get_element_number());
 
 										if (processDataObject->has_trigger_method(isobus::task_controller_object::DeviceProcessDataObject::AvailableTriggerMethods::OnChange))
 										{
 											send_change_threshold_measurement_command(client.first, processDataObject->get_ddi(), elementObject->get_element_number(), 1);
-											std::cout << "Subscribed (OnChange) to DDI " << processDataObject->get_ddi() << " (" << entryB.to_string() << ") for element "
-											          << elementObject->get_element_number() << std::endl;
+											client.second.add_measurement_subscription(processDataObject->get_ddi(), elementObject->get_element_number(), 0, true);
+											TC_LOG_INFO("Subscribed (OnChange) to DDI {} ({}) for element {}", processDataObject->get_ddi(), isobus::DataDictionary::get_entry(processDataObject->get_ddi()).name, elementObject->get_element_number());
 										}
 										else
 										{
-											std::cout << "Mapped (no OnChange) DDI " << processDataObject->get_ddi() << " (" << entryB.to_string() << ") to element "
-											          << elementObject->get_element_number() << std::endl;
+											TC_LOG_INFO("Mapped (no OnChange) DDI {} ({}) to element {}", processDataObject->get_ddi(), isobus::DataDictionary::get_entry(processDataObject->get_ddi()).name, elementObject->get_element_number());
 										}
 									}
 								}
@@ -557,107 +1061,475 @@ void MyTCServer::request_measurement_commands()
 				}
 			}
 
-			std::cout << "Measurement commands sent." << std::endl;
+			request_total_measurement_commands(client.first, client.second);
+
+			TC_LOG_INFO("Measurement commands sent.");
 			client.second.mark_measurement_commands_sent();
 		}
 	}
 }
 
-void MyTCServer::update_section_states(std::vector<bool> &sectionStates)
+void MyTCServer::update_section_states(const SectionMask &sectionStates)
 {
+	requestedSectionStates = sectionStates;
+	hasRequestedSectionStates = true;
+	auto now = SectionScheduler::Clock::now();
 	for (auto &client : clients)
 	{
 		auto &state = client.second;
 		if (!state.is_section_control_enabled())
 		{
 			// According to standard, the section setpoint states should only be sent when in auto mode
-			return;
+			continue;
+		}
+
+		// Every client maps AOG's sections onto its own booms and sections
+		SectionMask desiredStates = state.map_aog_section_states(sectionStates);
+		if (isCoverageSectionControlEnabled)
+		{
+			const auto &coverageMap = state.get_coverage_map();
+			desiredStates.for_each_set([&desiredStates, &coverageMap](std::uint16_t section) {
+				if (coverageMap.is_section_covered(static_cast<std::uint8_t>(section)))
+				{
+					desiredStates.set(section, false);
+				}
+			});
+		}
+
+		// Only the sections whose request changed are evaluated, most packets change nothing at all
+		SectionMask changedStates = state.take_section_request_changes(desiredStates);
+		if (changedStates.any())
+		{
+			auto &scheduler = state.get_section_scheduler();
+			changedStates.for_each_set([&](std::uint16_t section) {
+				auto i = static_cast<std::uint8_t>(section);
+				if ((section >= state.get_number_of_sections()) || state.is_section_overridden(i))
+				{
+					// Don't fight the operator, the section is left alone until it is released
+					return;
+				}
+				bool isOn = (state.get_section_setpoint_state(i) == SectionState::ON);
+				bool shouldBeOn = desiredStates.test(i);
+				if (scheduler.is_enabled())
+				{
+					scheduler.schedule(i, shouldBeOn, isOn, now);
+				}
+				else if (shouldBeOn != isOn)
+				{
+					state.set_section_setpoint_state(i, shouldBeOn ? SectionState::ON : SectionState::OFF);
+					state.mark_section_setpoint_changed(i);
+				}
+			});
 		}
 
-		bool requiresUpdate = false;
-		for (std::uint8_t i = 0; i < state.get_number_of_sections(); i++)
+		// Changes that can't be delayed (e.g. when standing still) are sent right away
+		apply_due_section_changes(state, now);
+		send_pending_section_setpoint_states(client.first);
+	}
+}
+
+void MyTCServer::update_section_control_enabled(bool enabled)
+{
+	for (auto &client : clients)
+	{
+		if (client.second.is_section_control_enabled() != enabled)
 		{
-			if ((i % NUMBER_SECTIONS_PER_CONDENSED_MESSAGE == 0) && requiresUpdate)
+			client.second.set_section_control_enabled(enabled);
+			client.second.invalidate_section_request();
+			send_section_control_state(client.first, enabled);
+		}
+	}
+}
+
+void MyTCServer::update_speed(std::int32_t speed)
+{
+	speed_mm_per_s = std::abs(speed);
+	auto now = SectionScheduler::Clock::now();
+	for (auto &client : clients)
+	{
+		client.second.get_section_scheduler().update_speed(speed, now);
+		client.second.get_work_statistics().update_speed(speed, now);
+	}
+}
+
+void MyTCServer::update_position(double latitude, double longitude, double heading_deg)
+{
+	// Evaluate the coverage where the sections will be once AOG's look-ahead has passed
+	double lookAhead_m = (static_cast<double>(speed_mm_per_s) * sectionLookAheadOn_ms) / 1000000.0;
+	for (auto &client : clients)
+	{
+		auto &state = client.second;
+		state.get_coverage_map().update(latitude, longitude, heading_deg, state.get_section_actual_states(), lookAhead_m);
+	}
+	update_rates(latitude, longitude, heading_deg, lookAhead_m);
+	taskDataWriter.add_position(latitude, longitude);
+	if (asAppliedLog.is_open())
+	{
+		for (auto &client : clients)
+		{
+			std::array<std::int32_t, AsAppliedLog::MAX_NUMBER_OF_RATES> rates;
+			std::size_t numberOfRates = 0;
+			for (const auto &target : client.second.get_rate_control_targets())
 			{
-				// Send the previous 16 sections
-				std::uint8_t ddiOffset = (i / NUMBER_SECTIONS_PER_CONDENSED_MESSAGE) - 1;
-				send_section_setpoint_states(client.first, ddiOffset);
-				requiresUpdate = false;
+				if (numberOfRates < rates.size())
+				{
+					rates[numberOfRates++] = target.lastSentRate;
+				}
 			}
+			asAppliedLog.append(client.first->get_NAME().get_full_name(),
+			                    latitude,
+			                    longitude,
+			                    heading_deg,
+			                    client.second.get_section_actual_states(),
+			                    client.second.get_number_of_sections(),
+			                    rates.data(),
+			                    numberOfRates);
+		}
+	}
+
+	if (isCoverageSectionControlEnabled && hasRequestedSectionStates)
+	{
+		// Re-evaluate at the GNSS rate instead of waiting for the next request from AOG
+		update_section_states(requestedSectionStates);
+	}
+}
+
+void MyTCServer::set_coverage_section_control(bool enabled)
+{
+	isCoverageSectionControlEnabled = enabled;
+}
+
+void MyTCServer::set_coverage_memory_per_client(std::uint32_t megabytes)
+{
+	coverageMaxTilesPerClient = static_cast<std::size_t>(megabytes) * 1024 * 1024 / CoverageMap::TILE_MEMORY;
+}
+
+void MyTCServer::set_number_of_virtual_sections(std::uint8_t number)
+{
+	numberOfVirtualSections = number;
+}
+
+void MyTCServer::set_section_status_callback(SectionStatusCallback callback)
+{
+	sectionStatusCallback = std::move(callback);
+}
+
+TaskTotals &MyTCServer::get_task_totals()
+{
+	return taskTotals;
+}
+
+void MyTCServer::request_total_measurement_commands(std::shared_ptr<isobus::ControlFunction> client, ClientState &state)
+{
+	auto &pool = state.get_pool();
+	for (std::uint32_t i = 0; i < pool.size(); i++)
+	{
+		auto object = pool.get_object_by_index(i);
+		if (object->get_object_type() != isobus::task_controller_object::ObjectTypes::DeviceElement)
+		{
+			continue;
+		}
+
+		auto elementObject = std::static_pointer_cast<isobus::task_controller_object::DeviceElementObject>(object);
+		for (std::uint16_t childId : elementObject->get_child_object_ids())
+		{
+			auto childObject = pool.get_object_by_id(childId);
+			if ((nullptr == childObject) || (childObject->get_object_type() != isobus::task_controller_object::ObjectTypes::DeviceProcessData))
+			{
+				continue;
+			}
+
+			auto processDataObject = std::static_pointer_cast<isobus::task_controller_object::DeviceProcessDataObject>(childObject);
+			if (!TaskTotals::is_total_ddi(processDataObject->get_ddi()))
+			{
+				continue;
+			}
+
+			// Totals change all the time while working, a time interval keeps the bus load predictable
+			taskTotals.add_total(client->get_NAME().get_full_name(), elementObject->get_element_number(), processDataObject->get_ddi());
+			if (processDataObject->has_trigger_method(isobus::task_controller_object::DeviceProcessDataObject::AvailableTriggerMethods::TimeInterval))
+			{
+				send_time_interval_measurement_command(client, processDataObject->get_ddi(), elementObject->get_element_number(), 1000);
+				state.add_measurement_subscription(processDataObject->get_ddi(), elementObject->get_element_number(), 1000, false);
+			}
+			else if (processDataObject->has_trigger_method(isobus::task_controller_object::DeviceProcessDataObject::AvailableTriggerMethods::OnChange))
+			{
+				send_change_threshold_measurement_command(client, processDataObject->get_ddi(), elementObject->get_element_number(), 1);
+				state.add_measurement_subscription(processDataObject->get_ddi(), elementObject->get_element_number(), 0, true);
+			}
+			TC_LOG_INFO("Collecting total DDI {} ({}) of element {}", processDataObject->get_ddi(), isobus::DataDictionary::get_entry(processDataObject->get_ddi()).name, elementObject->get_element_number());
+		}
+	}
+}
+
+TaskDataWriter &MyTCServer::get_task_data_writer()
+{
+	return taskDataWriter;
+}
+
+AsAppliedLog &MyTCServer::get_as_applied_log()
+{
+	return asAppliedLog;
+}
+
+const ProcessDataHistory &MyTCServer::get_process_data_history() const
+{
+	return processDataHistory;
+}
+
+EventJournal &MyTCServer::get_event_journal()
+{
+	return eventJournal;
+}
+
+bool MyTCServer::load_prescription_map(const std::string &path)
+{
+	return prescriptionMap.load(path);
+}
+
+void MyTCServer::update_rates(double latitude, double longitude, double heading_deg, double lookAhead_m)
+{
+	if (!prescriptionMap.is_loaded())
+	{
+		return;
+	}
 
-			if (i < sectionStates.size())
+	for (auto &client : clients)
+	{
+		auto &state = client.second;
+		if (state.get_rate_control_targets().empty() || !state.is_section_control_enabled())
+		{
+			continue;
+		}
+
+		// Look up every section once, elements above the sections get the average of their sections
+		const auto &sections = state.get_coverage_map().get_sections();
+		sectionRates.resize(sections.size());
+		for (std::size_t i = 0; i < sections.size(); i++)
+		{
+			sectionRates[i] = prescriptionMap.get_section_rate(latitude, longitude, heading_deg, sections[i].xOffset_m + lookAhead_m, sections[i].yOffset_m, sections[i].width_m);
+		}
+
+		for (auto &target : state.get_rate_control_targets())
+		{
+			std::int64_t sum = 0;
+			std::uint8_t numberOfRates = 0;
+			for (std::uint8_t i = target.firstSection; (i < target.firstSection + target.numberOfSections) && (i < sectionRates.size()); i++)
 			{
-				if (sectionStates[i] != (state.get_section_setpoint_state(i) == SectionState::ON))
+				if (PrescriptionMap::NO_RATE != sectionRates[i])
 				{
-					state.set_section_setpoint_state(i, sectionStates[i] ? SectionState::ON : SectionState::OFF);
-					requiresUpdate = true;
+					sum += sectionRates[i];
+					numberOfRates++;
 				}
 			}
+			if (0 == numberOfRates)
+			{
+				// Keep the last rate, the implement falls back to its own rate if it never received one
+				continue;
+			}
+
+			auto rate = static_cast<std::int32_t>(sum / numberOfRates);
+			if (rate != target.lastSentRate)
+			{
+				send_set_value(client.first, prescriptionMap.get_ddi(), target.elementNumber, rate);
+				target.lastSentRate = rate;
+			}
 		}
-		if (requiresUpdate)
+	}
+}
+
+void MyTCServer::add_rate_control_targets(ClientState &state, const std::map<std::uint16_t, std::pair<std::uint8_t, std::uint8_t>> &elementSections)
+{
+	if (!prescriptionMap.is_loaded())
+	{
+		return;
+	}
+
+	auto &pool = state.get_pool();
+	for (std::uint32_t i = 0; i < pool.size(); i++)
+	{
+		auto object = pool.get_object_by_index(i);
+		if (object->get_object_type() != isobus::task_controller_object::ObjectTypes::DeviceElement)
 		{
-			std::uint8_t ddiOffset = (state.get_number_of_sections() - 1) / NUMBER_SECTIONS_PER_CONDENSED_MESSAGE;
-			send_section_setpoint_states(client.first, ddiOffset);
+			continue;
+		}
+
+		auto elementObject = std::static_pointer_cast<isobus::task_controller_object::DeviceElementObject>(object);
+		for (std::uint16_t childId : elementObject->get_child_object_ids())
+		{
+			auto childObject = pool.get_object_by_id(childId);
+			if ((nullptr == childObject) ||
+			    (childObject->get_object_type() != isobus::task_controller_object::ObjectTypes::DeviceProcessData) ||
+			    (std::static_pointer_cast<isobus::task_controller_object::DeviceProcessDataObject>(childObject)->get_ddi() != prescriptionMap.get_ddi()))
+			{
+				continue;
+			}
+
+			// Elements above the booms (e.g. the device or a product bin) apply to all sections
+			RateControlTarget target;
+			target.elementNumber = elementObject->get_element_number();
+			target.numberOfSections = state.get_number_of_sections();
+			auto it = elementSections.find(target.elementNumber);
+			if (it != elementSections.end())
+			{
+				target.firstSection = it->second.first;
+				target.numberOfSections = it->second.second;
+			}
+			state.add_rate_control_target(target);
+			TC_LOG_INFO("Prescribed rate is sent to element {} for sections {} to {}", target.elementNumber, target.firstSection, target.firstSection + target.numberOfSections - 1);
 		}
 	}
 }
 
-void MyTCServer::update_section_control_enabled(bool enabled)
+void MyTCServer::set_section_look_ahead(std::uint32_t onLookAhead_ms, std::uint32_t offLookAhead_ms)
 {
+	sectionLookAheadOn_ms = onLookAhead_ms;
+	sectionLookAheadOff_ms = offLookAhead_ms;
 	for (auto &client : clients)
 	{
-		if (client.second.is_section_control_enabled() != enabled)
+		client.second.get_section_scheduler().set_look_ahead(onLookAhead_ms, offLookAhead_ms);
+	}
+}
+
+void MyTCServer::update_scheduled_section_states()
+{
+	auto now = SectionScheduler::Clock::now();
+	for (auto &client : clients)
+	{
+		if (client.second.get_section_scheduler().get_next_due_time() <= now)
 		{
-			client.second.set_section_control_enabled(enabled);
-			send_section_control_state(client.first, enabled);
+			apply_due_section_changes(client.second, now);
+			send_pending_section_setpoint_states(client.first);
 		}
 	}
 }
 
-void MyTCServer::send_section_setpoint_states(std::shared_ptr<isobus::ControlFunction> client, std::uint8_t ddiOffset)
+SectionScheduler::Clock::time_point MyTCServer::get_next_scheduled_section_time() const
 {
-	std::uint8_t sectionOffset = ddiOffset * NUMBER_SECTIONS_PER_CONDENSED_MESSAGE;
+	auto nextDueTime = SectionScheduler::Clock::time_point::max();
+	for (const auto &client : clients)
+	{
+		nextDueTime = std::min(nextDueTime, client.second.get_section_scheduler().get_next_due_time());
+	}
+	return nextDueTime;
+}
+
+void MyTCServer::apply_due_section_changes(ClientState &state, SectionScheduler::Clock::time_point now)
+{
+	dueSectionChanges.clear();
+	if (!state.get_section_scheduler().pop_due_changes(now, dueSectionChanges) || !state.is_section_control_enabled())
+	{
+		// Changes scheduled before switching to manual mode are dropped
+		return;
+	}
+
+	for (const auto &change : dueSectionChanges)
+	{
+		if (state.is_section_overridden(change.section))
+		{
+			continue;
+		}
+		state.set_section_setpoint_state(change.section, change.on ? SectionState::ON : SectionState::OFF);
+		state.mark_section_setpoint_changed(change.section);
+	}
+}
+
+void MyTCServer::send_pending_section_setpoint_states(std::shared_ptr<isobus::ControlFunction> client)
+{
+	auto &booms = clients[client].get_booms();
+	for (std::uint8_t boomIndex = 0; boomIndex < booms.size(); boomIndex++)
+	{
+		std::uint16_t pendingGroups = std::exchange(booms[boomIndex].pendingGroups, 0);
+		for (std::uint8_t ddiOffset = 0; pendingGroups != 0; ddiOffset++, pendingGroups >>= 1)
+		{
+			if (pendingGroups & 1)
+			{
+				send_section_setpoint_states(client, boomIndex, ddiOffset);
+			}
+		}
+	}
+}
+
+void MyTCServer::send_section_setpoint_states(std::shared_ptr<isobus::ControlFunction> client, std::uint8_t boomIndex, std::uint8_t ddiOffset)
+{
+	auto &state = clients[client];
+	const auto &boom = state.get_booms()[boomIndex];
+	std::uint8_t groupOffset = ddiOffset * NUMBER_SECTIONS_PER_CONDENSED_MESSAGE;
 	std::uint32_t value = 0;
-	for (std::uint8_t i = 0; i < NUMBER_SECTIONS_PER_CONDENSED_MESSAGE; i++)
+	for (std::uint8_t i = 0; (i < NUMBER_SECTIONS_PER_CONDENSED_MESSAGE) && (groupOffset + i < boom.numberOfSections); i++)
 	{
-		value |= (clients[client].get_section_setpoint_state(sectionOffset + i) << (2 * i));
+		std::uint8_t section = boom.firstSection + groupOffset + i;
+		// Overridden sections are sent as "not available", which tells the implement to take no action
+		std::uint8_t sectionState = state.is_section_overridden(section) ? static_cast<std::uint8_t>(SectionState::NOT_INSTALLED) : static_cast<std::uint8_t>(state.get_section_setpoint_state(section));
+		value |= (sectionState << (2 * i));
 	}
 
+	// Prefer the element of the boom itself, fall back to the element of the first boom that has the DDI
+	auto get_element_number = [&state, &boom](std::uint16_t ddi, std::uint16_t &elementNumber) {
+		auto it = boom.condensedElementNumbers.find(ddi);
+		if (it != boom.condensedElementNumbers.end())
+		{
+			elementNumber = it->second;
+			return true;
+		}
+		if (state.has_element_number_for_ddi(static_cast<isobus::DataDescriptionIndex>(ddi)))
+		{
+			elementNumber = state.get_element_number_for_ddi(static_cast<isobus::DataDescriptionIndex>(ddi));
+			return true;
+		}
+		return false;
+	};
+
 	// Modern ECU? (DDI 290  SetpointCondensedWorkState1_16 exists)
 	std::uint16_t ddiTarget = static_cast<std::uint16_t>(isobus::DataDescriptionIndex::SetpointCondensedWorkState1_16) + ddiOffset;
 	// Legacy ECU? (DDI 161  ActualCondensedWorkState1_16 exists and Settable)
 	std::uint16_t ddiTargetLegacy = static_cast<std::uint16_t>(isobus::DataDescriptionIndex::ActualCondensedWorkState1_16) + ddiOffset;
-	if (clients[client].has_element_number_for_ddi(static_cast<isobus::DataDescriptionIndex>(ddiTarget)))
+	// Start the latency measurement of the sections that changed
+	auto mark_sent = [&state, &boom, groupOffset]() {
+		auto now = SectionLatencyProfiler::Clock::now();
+		for (std::uint8_t i = 0; (i < NUMBER_SECTIONS_PER_CONDENSED_MESSAGE) && (groupOffset + i < boom.numberOfSections); i++)
+		{
+			std::uint8_t section = boom.firstSection + groupOffset + i;
+			if (!state.is_section_overridden(section))
+			{
+				state.get_latency_profiler().on_setpoint_sent(section, state.get_section_setpoint_state(section) == SectionState::ON, now);
+			}
+		}
+	};
+
+	std::uint16_t elementNumber = 0;
+	if (get_element_number(ddiTarget, elementNumber))
 	{
-		std::uint16_t elementNumber = clients[client].get_element_number_for_ddi(static_cast<isobus::DataDescriptionIndex>(ddiTarget));
 		send_set_value(client, ddiTarget, elementNumber, value);
+		mark_sent();
 
-		bool setpointWorkState = clients[client].is_any_section_setpoint_on();
-		if ((clients[client].get_setpoint_work_state() != setpointWorkState) && clients[client].has_element_number_for_ddi(isobus::DataDescriptionIndex::SetpointWorkState))
+		bool setpointWorkState = state.is_any_section_setpoint_on();
+		if ((state.get_setpoint_work_state() != setpointWorkState) && state.has_element_number_for_ddi(isobus::DataDescriptionIndex::SetpointWorkState))
 		{
-			send_set_value(client, static_cast<std::uint16_t>(isobus::DataDescriptionIndex::SetpointWorkState), clients[client].get_element_number_for_ddi(isobus::DataDescriptionIndex::SetpointWorkState), setpointWorkState ? 1 : 0);
-			clients[client].set_setpoint_work_state(setpointWorkState);
+			send_set_value(client, static_cast<std::uint16_t>(isobus::DataDescriptionIndex::SetpointWorkState), state.get_element_number_for_ddi(isobus::DataDescriptionIndex::SetpointWorkState), setpointWorkState ? 1 : 0);
+			state.set_setpoint_work_state(setpointWorkState);
 		}
-		else if (!clients[client].has_element_number_for_ddi(isobus::DataDescriptionIndex::SetpointWorkState))
+		else if (!state.has_element_number_for_ddi(isobus::DataDescriptionIndex::SetpointWorkState))
 		{
-			std::cout << "[TC Server] DDI 289 (SetpointWorkState) not available!" << std::endl;
+			TC_LOG_WARNING_EVERY(10000, "[TC Server] DDI 289 (SetpointWorkState) not available!");
 		}
 	}
-	else if (clients[client].has_element_number_for_ddi(static_cast<isobus::DataDescriptionIndex>(ddiTargetLegacy)))
+	else if (get_element_number(ddiTargetLegacy, elementNumber))
 	{
 		if (is_ddi_settable(client, ddiTargetLegacy))
 		{
-			send_set_value(client, ddiTargetLegacy, clients[client].get_element_number_for_ddi(static_cast<isobus::DataDescriptionIndex>(ddiTargetLegacy)), value);
+			send_set_value(client, ddiTargetLegacy, elementNumber, value);
+			mark_sent();
 		}
 		else
 		{
-			std::cout << "[TC Server] Legacy DDI " << ddiTargetLegacy << " (ActualCondensedWorkState) is not settable!" << std::endl;
+			TC_LOG_WARNING_EVERY(10000, "[TC Server] Legacy DDI {} (ActualCondensedWorkState) is not settable!", ddiTargetLegacy);
 		}
 		return;
 	}
 	else
 	{
-		std::cout << "[TC Server] Neither condensed nor controllable-actual work state supported Missing DDI 290 and 141!" << std::endl;
+		TC_LOG_WARNING_EVERY(10000, "[TC Server] Neither condensed nor controllable-actual work state supported Missing DDI 290 and 141!");
 	}
 }
 
@@ -682,3 +1554,56 @@ bool MyTCServer::is_ddi_settable(std::shared_ptr<isobus::ControlFunction> client
 	}
 	return false;
 }
+
+bool MyTCServer::send_set_value(std::shared_ptr<isobus::ControlFunction> client, std::uint16_t dataDescriptionIndex, std::uint16_t elementNumber, std::int32_t processDataValue) const
+{
+	bool sent = TaskControllerServer::send_set_value(client, dataDescriptionIndex, elementNumber, processDataValue);
+	if (sent)
+	{
+		Metrics::count_set_value_sent();
+	}
+	return sent;
+}
+
+std::uint32_t MyTCServer::get_section_latency(isobus::DeviceDescriptorObjectPool &pool, std::uint16_t elementNumber)
+{
+	std::shared_ptr<isobus::task_controller_object::DeviceElementObject> elementObject;
+	for (std::uint32_t i = 0; i < pool.size(); i++)
+	{
+		auto object = pool.get_object_by_index(i);
+		if (object->get_object_type() == isobus::task_controller_object::ObjectTypes::DeviceElement)
+		{
+			auto candidate = std::static_pointer_cast<isobus::task_controller_object::DeviceElementObject>(object);
+			if (candidate->get_element_number() == elementNumber)
+			{
+				elementObject = candidate;
+				break;
+			}
+		}
+	}
+
+	// Walk up the hierarchy, a latency on a boom or device applies to all of its sections
+	while (nullptr != elementObject)
+	{
+		for (std::uint16_t childId : elementObject->get_child_object_ids())
+		{
+			auto childObject = pool.get_object_by_id(childId);
+			if ((nullptr != childObject) && (childObject->get_object_type() == isobus::task_controller_object::ObjectTypes::DeviceProperty))
+			{
+				auto propertyObject = std::static_pointer_cast<isobus::task_controller_object::DevicePropertyObject>(childObject);
+				if (propertyObject->get_ddi() == static_cast<std::uint16_t>(isobus::DataDescriptionIndex::PhysicalSetpointTimeLatency))
+				{
+					return static_cast<std::uint32_t>(std::max(propertyObject->get_value(), 0));
+				}
+			}
+		}
+
+		auto parentObject = pool.get_object_by_id(elementObject->get_parent_object());
+		if ((nullptr == parentObject) || (parentObject == elementObject) || (parentObject->get_object_type() != isobus::task_controller_object::ObjectTypes::DeviceElement))
+		{
+			break;
+		}
+		elementObject = std::static_pointer_cast<isobus::task_controller_object::DeviceElementObject>(parentObject);
+	}
+	return 0;
+}
@@ -0,0 +1,411 @@
+/**
+ * @author Daan Steenbergen
+ * @brief Records an ISO 11783-10 TASKDATA set with binary time logs
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright 2026 Daan Steenbergen
+ */
+#include "task_data_writer.hpp"
+#include "app_clock.hpp"
+#include "log_macros.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+
+constexpr std::int64_t DAYS_FROM_1970_TO_1980 = 3652; ///< Time log dates count from 1980-01-01
+constexpr const char *TIME_LOG_NAME = "TLG00001";
+
+/// @brief Convert bytes to upper case hexadecimal like ISO-XML expects
+template<typename Bytes>
+static std::string to_hex(const Bytes &bytes)
+{
+	std::ostringstream stream;
+	stream << std::hex << std::uppercase << std::setfill('0');
+	for (auto byte : bytes)
+	{
+		stream << std::setw(2) << static_cast<int>(static_cast<std::uint8_t>(byte));
+	}
+	return stream.str();
+}
+
+/// @brief Escape the characters that are not allowed in an XML attribute
+static std::string escape_xml(const std::string &text)
+{
+	std::string escaped;
+	for (char character : text)
+	{
+		switch (character)
+		{
+			case '&':
+				escaped += "&amp;";
+				break;
+			case '<':
+				escaped += "&lt;";
+				break;
+			case '>':
+				escaped += "&gt;";
+				break;
+			case '"':
+				escaped += "&quot;";
+				break;
+			default:
+				escaped += character;
+				break;
+		}
+	}
+	return escaped;
+}
+
+/// @brief Write a value to a record in little endian byte order
+template<typename T>
+static std::size_t put_value(std::uint8_t *destination, T value)
+{
+	for (std::size_t i = 0; i < sizeof(T); i++)
+	{
+		destination[i] = static_cast<std::uint8_t>(static_cast<std::uint64_t>(value) >> (8 * i));
+	}
+	return sizeof(T);
+}
+
+TaskDataWriter::~TaskDataWriter()
+{
+	stop();
+}
+
+bool TaskDataWriter::start(const std::string &directory, const std::string &taskDesignator)
+{
+	stop();
+
+	binaryFile.open(directory + "/" + TIME_LOG_NAME + ".BIN", std::ios::binary | std::ios::trunc);
+	if (!binaryFile.is_open())
+	{
+		TC_LOG_ERROR("Unable to record task data. (Failed to open time log in {})", directory);
+		return false;
+	}
+
+	outputDirectory = directory;
+	taskName = taskDesignator;
+	for (auto &buffer : buffers)
+	{
+		buffer.clear();
+		buffer.reserve(BUFFER_SIZE);
+	}
+	activeBuffer = 0;
+	isFlushRequested = false;
+	isStopRequested = false;
+	numberOfDroppedRecords = 0;
+
+	// Only the clients that are still connected carry over to the new task, with the values they reported before
+	std::erase_if(devices, [](const DeviceDescription &device) { return !device.isConnected; });
+	auto previousValues = std::move(loggedValues);
+	auto previousCurrentValues = currentValues;
+	loggedValues.clear();
+	valueIndices.clear();
+	changedValues.reset();
+	for (std::size_t i = 0; i < previousValues.size(); i++)
+	{
+		if (is_element_described(previousValues[i].clientName, previousValues[i].elementNumber))
+		{
+			currentValues[add_logged_value(previousValues[i])] = previousCurrentValues[i];
+		}
+	}
+	changedValues.set(); // The first record contains every known value
+	isRecording = true;
+	flushThread = std::thread(&TaskDataWriter::flush_thread, this);
+	TC_LOG_INFO("Recording task data to {}", directory);
+	return true;
+}
+
+void TaskDataWriter::stop()
+{
+	if (!isRecording)
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(bufferMutex);
+		isStopRequested = true;
+	}
+	flushCondition.notify_one();
+	flushThread.join();
+
+	// The thread is gone, so the remaining records can be written from here
+	binaryFile.write(reinterpret_cast<const char *>(buffers[activeBuffer].data()), buffers[activeBuffer].size());
+	binaryFile.close();
+	isRecording = false;
+	write_xml_files();
+	if (numberOfDroppedRecords > 0)
+	{
+		TC_LOG_WARNING("Task data recording dropped {} records", numberOfDroppedRecords.load());
+	}
+}
+
+bool TaskDataWriter::is_recording() const
+{
+	return isRecording;
+}
+
+void TaskDataWriter::add_device(std::uint64_t clientName, isobus::DeviceDescriptorObjectPool &pool)
+{
+	DeviceDescription device;
+	device.clientName = clientName;
+	for (std::uint16_t i = 0; i < pool.size(); i++)
+	{
+		auto object = pool.get_object_by_index(i);
+		if (object->get_object_type() == isobus::task_controller_object::ObjectTypes::Device)
+		{
+			auto deviceObject = std::static_pointer_cast<isobus::task_controller_object::DeviceObject>(object);
+			device.designator = deviceObject->get_designator();
+			device.softwareVersion = deviceObject->get_software_version();
+			device.serialNumber = deviceObject->get_serial_number();
+			device.structureLabel = to_hex(deviceObject->get_structure_label());
+			device.localizationLabel = to_hex(deviceObject->get_localization_label());
+		}
+		else if (object->get_object_type() == isobus::task_controller_object::ObjectTypes::DeviceElement)
+		{
+			auto elementObject = std::static_pointer_cast<isobus::task_controller_object::DeviceElementObject>(object);
+			device.elements.push_back({ elementObject->get_object_id(),
+			                            elementObject->get_element_number(),
+			                            elementObject->get_parent_object(),
+			                            static_cast<std::uint8_t>(elementObject->get_type()),
+			                            elementObject->get_designator() });
+		}
+	}
+
+	// A reconnected client replaces its previous description, but the values recorded so far keep their elements
+	auto previous = std::find_if(devices.begin(), devices.end(), [clientName](const DeviceDescription &existing) { return existing.clientName == clientName; });
+	if (previous != devices.end())
+	{
+		for (const auto &value : loggedValues)
+		{
+			auto is_value_element = [&value](const ElementDescription &element) { return element.elementNumber == value.elementNumber; };
+			if ((value.clientName == clientName) && std::none_of(device.elements.begin(), device.elements.end(), is_value_element))
+			{
+				auto element = std::find_if(previous->elements.begin(), previous->elements.end(), is_value_element);
+				if (element != previous->elements.end())
+				{
+					device.elements.push_back(*element);
+				}
+			}
+		}
+		devices.erase(previous);
+	}
+	devices.push_back(std::move(device));
+}
+
+void TaskDataWriter::remove_device(std::uint64_t clientName)
+{
+	for (auto &device : devices)
+	{
+		if (device.clientName == clientName)
+		{
+			device.isConnected = false;
+		}
+	}
+}
+
+void TaskDataWriter::set_value(std::uint64_t clientName, std::uint16_t elementNumber, std::uint16_t ddi, std::int32_t value)
+{
+	auto &clientIndices = valueIndices[clientName];
+	std::uint32_t key = (static_cast<std::uint32_t>(elementNumber) << 16) | ddi;
+	auto it = clientIndices.find(key);
+	bool isNew = false;
+	if (it == clientIndices.end())
+	{
+		if ((loggedValues.size() >= MAX_NUMBER_OF_VALUES) || !is_element_described(clientName, elementNumber))
+		{
+			return;
+		}
+		// New values are rare, they only allocate the first time they are seen
+		add_logged_value({ clientName, elementNumber, ddi });
+		it = clientIndices.find(key);
+		isNew = true;
+	}
+
+	if (isNew || (currentValues[it->second] != value))
+	{
+		currentValues[it->second] = value;
+		changedValues.set(it->second);
+	}
+}
+
+void TaskDataWriter::add_position(double latitude, double longitude)
+{
+	if (!isRecording)
+	{
+		return;
+	}
+
+	auto sinceEpoch = AppClock::get_wall_time().time_since_epoch();
+	auto days = std::chrono::duration_cast<std::chrono::days>(sinceEpoch);
+	auto millisecondsOfDay = std::chrono::duration_cast<std::chrono::milliseconds>(sinceEpoch - days);
+
+	// Layout as announced in the time log header: time, north, east, status, then the changed values
+	std::size_t size = 0;
+	size += put_value(&record[size], static_cast<std::uint32_t>(millisecondsOfDay.count()));
+	size += put_value(&record[size], static_cast<std::uint16_t>(days.count() - DAYS_FROM_1970_TO_1980));
+	size += put_value(&record[size], static_cast<std::int32_t>(std::lround(latitude * 10000000.0)));
+	size += put_value(&record[size], static_cast<std::int32_t>(std::lround(longitude * 10000000.0)));
+	size += put_value(&record[size], static_cast<std::uint8_t>(1)); // GNSS fix, AOG doesn't forward the fix quality
+	std::size_t countOffset = size++;
+	std::uint8_t numberOfValues = 0;
+	for (std::size_t i = 0; i < loggedValues.size(); i++)
+	{
+		if (changedValues.test(i))
+		{
+			size += put_value(&record[size], static_cast<std::uint8_t>(i));
+			size += put_value(&record[size], currentValues[i]);
+			numberOfValues++;
+		}
+	}
+	record[countOffset] = numberOfValues;
+	changedValues.reset();
+
+	std::unique_lock<std::mutex> lock(bufferMutex);
+	if (buffers[activeBuffer].size() + size > BUFFER_SIZE)
+	{
+		if (isFlushRequested)
+		{
+			// Both buffers are full, dropping is better than stalling the main loop
+			numberOfDroppedRecords++;
+			return;
+		}
+		isFlushRequested = true;
+		activeBuffer ^= 1;
+		lock.unlock();
+		flushCondition.notify_one();
+		lock.lock();
+	}
+	// Within the reserved capacity, so this never allocates
+	buffers[activeBuffer].insert(buffers[activeBuffer].end(), record.begin(), record.begin() + size);
+}
+
+std::uint32_t TaskDataWriter::get_number_of_dropped_records() const
+{
+	return numberOfDroppedRecords;
+}
+
+void TaskDataWriter::flush_thread()
+{
+	std::unique_lock<std::mutex> lock(bufferMutex);
+	while (!isStopRequested)
+	{
+		// Write at least every few seconds, so little is lost when the power is cut
+		if (!flushCondition.wait_for(lock, std::chrono::seconds(2), [this]() { return isFlushRequested || isStopRequested; }))
+		{
+			if (buffers[activeBuffer].empty())
+			{
+				continue;
+			}
+			isFlushRequested = true;
+			activeBuffer ^= 1;
+		}
+		if (!isFlushRequested)
+		{
+			continue;
+		}
+
+		auto &fullBuffer = buffers[activeBuffer ^ 1];
+		lock.unlock();
+		binaryFile.write(reinterpret_cast<const char *>(fullBuffer.data()), fullBuffer.size());
+		binaryFile.flush();
+		fullBuffer.clear();
+		lock.lock();
+		isFlushRequested = false;
+	}
+}
+
+void TaskDataWriter::write_xml_files()
+{
+	std::ofstream timeLogHeader(outputDirectory + "/" + TIME_LOG_NAME + ".XML", std::ios::trunc);
+	if (!timeLogHeader.is_open())
+	{
+		TC_LOG_ERROR("Unable to write time log header to {}", outputDirectory);
+		return;
+	}
+	timeLogHeader << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+	timeLogHeader << "<TIM A=\"\" D=\"4\">\n";
+	timeLogHeader << "\t<PTN A=\"\" B=\"\" D=\"\"/>\n";
+	for (const auto &value : loggedValues)
+	{
+		timeLogHeader << "\t<DLV A=\"" << to_hex(std::array<std::uint8_t, 2>{ static_cast<std::uint8_t>(value.ddi >> 8), static_cast<std::uint8_t>(value.ddi) })
+		              << "\" B=\"\" C=\"" << get_element_id(value.clientName, value.elementNumber) << "\"/>\n";
+	}
+	timeLogHeader << "</TIM>\n";
+
+	std::ofstream taskData(outputDirectory + "/TASKDATA.XML", std::ios::trunc);
+	if (!taskData.is_open())
+	{
+		TC_LOG_ERROR("Unable to write TASKDATA.XML to {}", outputDirectory);
+		return;
+	}
+	taskData << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+	taskData << "<ISO11783_TaskData VersionMajor=\"4\" VersionMinor=\"3\" ManagementSoftwareManufacturer=\"\" ManagementSoftwareVersion=\"\" "
+	         << "TaskControllerManufacturer=\"AgOpenGPS\" TaskControllerVersion=\"" << PROJECT_VERSION << "\" DataTransferOrigin=\"2\">\n";
+	for (std::size_t i = 0; i < devices.size(); i++)
+	{
+		const auto &device = devices[i];
+		std::array<std::uint8_t, 8> name;
+		for (std::size_t j = 0; j < name.size(); j++)
+		{
+			name[j] = static_cast<std::uint8_t>(device.clientName >> (8 * (7 - j)));
+		}
+		taskData << "\t<DVC A=\"DVC-" << i + 1 << "\" B=\"" << escape_xml(device.designator) << "\" C=\"" << escape_xml(device.softwareVersion) << "\" D=\"" << to_hex(name)
+		         << "\" E=\"" << escape_xml(device.serialNumber) << "\" F=\"" << device.structureLabel << "\" G=\"" << device.localizationLabel << "\">\n";
+		for (const auto &element : device.elements)
+		{
+			taskData << "\t\t<DET A=\"" << get_element_id(device.clientName, element.elementNumber) << "\" B=\"" << element.objectId << "\" C=\"" << static_cast<int>(element.type)
+			         << "\" D=\"" << escape_xml(element.designator) << "\" E=\"" << element.elementNumber << "\" F=\"" << element.parentObjectId << "\"/>\n";
+		}
+		taskData << "\t</DVC>\n";
+	}
+	taskData << "\t<TSK A=\"TSK1\" B=\"" << escape_xml(taskName) << "\" G=\"4\">\n";
+	taskData << "\t\t<TLG A=\"" << TIME_LOG_NAME << "\"/>\n";
+	taskData << "\t</TSK>\n";
+	taskData << "</ISO11783_TaskData>\n";
+	TC_LOG_INFO("Task data written to {}", outputDirectory);
+}
+
+std::string TaskDataWriter::get_element_id(std::uint64_t clientName, std::uint16_t elementNumber) const
+{
+	// Element ids have to be unique over all devices, so they are numbered in device order
+	std::size_t id = 1;
+	for (const auto &device : devices)
+	{
+		for (const auto &element : device.elements)
+		{
+			if ((device.clientName == clientName) && (element.elementNumber == elementNumber))
+			{
+				return "DET-" + std::to_string(id);
+			}
+			id++;
+		}
+	}
+	return "DET-0"; // Not reached for logged values, set_value only accepts described elements
+}
+
+bool TaskDataWriter::is_element_described(std::uint64_t clientName, std::uint16_t elementNumber) const
+{
+	for (const auto &device : devices)
+	{
+		if (device.clientName == clientName)
+		{
+			return std::any_of(device.elements.begin(), device.elements.end(), [elementNumber](const ElementDescription &element) { return element.elementNumber == elementNumber; });
+		}
+	}
+	return false;
+}
+
+std::uint8_t TaskDataWriter::add_logged_value(const LoggedValue &value)
+{
+	auto index = static_cast<std::uint8_t>(loggedValues.size());
+	valueIndices[value.clientName].emplace((static_cast<std::uint32_t>(value.elementNumber) << 16) | value.ddi, index);
+	loggedValues.push_back(value);
+	return index;
+}
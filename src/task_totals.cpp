@@ -0,0 +1,246 @@
+/**
+ * @author Daan Steenbergen
+ * @brief Accumulates the totals reported by the implements per task
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright 2026 Daan Steenbergen
+ */
+#include "task_totals.hpp"
+#include "log_macros.hpp"
+
+#include "isobus/isobus/isobus_data_dictionary.hpp"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+/// @brief Append a value to a buffer in host byte order
+template<typename T>
+static void write_value(std::vector<std::uint8_t> &buffer, T value)
+{
+	auto offset = buffer.size();
+	buffer.resize(offset + sizeof(T));
+	std::memcpy(buffer.data() + offset, &value, sizeof(T));
+}
+
+/// @brief Read a value from a buffer in host byte order
+template<typename T>
+static bool read_value(const std::vector<std::uint8_t> &buffer, std::size_t &offset, T &value)
+{
+	if (offset + sizeof(T) > buffer.size())
+	{
+		return false;
+	}
+	std::memcpy(&value, buffer.data() + offset, sizeof(T));
+	offset += sizeof(T);
+	return true;
+}
+
+bool TaskTotals::is_total_ddi(std::uint16_t ddi)
+{
+	// Lifetime totals are never reset by the implement, they are not related to a task
+	const auto &entry = isobus::DataDictionary::get_entry(ddi);
+	return (entry.name.find("Total") != std::string::npos) && (entry.name.find("Lifetime") == std::string::npos);
+}
+
+std::size_t TaskTotals::KeyHash::operator()(const Key &key) const
+{
+	std::uint64_t hash = key.clientName ^ (static_cast<std::uint64_t>(key.elementAndDdi) * 0x9E3779B97F4A7C15ULL);
+	hash ^= hash >> 31;
+	return static_cast<std::size_t>(hash * 0xBF58476D1CE4E5B9ULL);
+}
+
+void TaskTotals::add_total(std::uint64_t clientName, std::uint16_t elementNumber, std::uint16_t ddi)
+{
+	Key key = { clientName, (static_cast<std::uint32_t>(elementNumber) << 16) | ddi };
+	if (reportStates.find(key) != reportStates.end())
+	{
+		// Reconnected client, the next report starts a new increase
+		reportStates[key].hasLastValue = false;
+		return;
+	}
+	reportStates[key] = ReportState();
+	build_task_index();
+}
+
+bool TaskTotals::update(std::uint64_t clientName, std::uint16_t elementNumber, std::uint16_t ddi, std::int32_t reportedValue)
+{
+	auto it = reportStates.find({ clientName, (static_cast<std::uint32_t>(elementNumber) << 16) | ddi });
+	if (it == reportStates.end())
+	{
+		return false;
+	}
+
+	auto &state = it->second;
+	if (state.hasLastValue)
+	{
+		// A lower value means the implement reset its total, everything it reports since then is new
+		std::int64_t increase = (reportedValue >= state.lastValue) ? (static_cast<std::int64_t>(reportedValue) - state.lastValue) : reportedValue;
+		if (0 != increase)
+		{
+			(*currentTotals)[state.indexInTask].value += increase;
+			isDirty = true;
+		}
+	}
+	state.lastValue = reportedValue;
+	state.hasLastValue = true;
+	return true;
+}
+
+void TaskTotals::start_task(std::uint32_t taskId)
+{
+	if (taskId != currentTask)
+	{
+		currentTask = taskId;
+		build_task_index();
+		isDirty = true;
+	}
+}
+
+std::uint32_t TaskTotals::get_current_task() const
+{
+	return currentTask;
+}
+
+const std::vector<TaskTotals::Total> &TaskTotals::get_totals(std::uint32_t taskId) const
+{
+	static const std::vector<Total> NO_TOTALS;
+	auto it = tasks.find(taskId);
+	return (it != tasks.end()) ? it->second : NO_TOTALS;
+}
+
+bool TaskTotals::save_checkpoint(const std::string &path)
+{
+	if (!isDirty)
+	{
+		return true;
+	}
+
+	std::vector<std::uint8_t> buffer;
+	write_value(buffer, CHECKPOINT_MAGIC);
+	write_value(buffer, CHECKPOINT_VERSION);
+	write_value(buffer, currentTask);
+	write_value(buffer, static_cast<std::uint32_t>(tasks.size()));
+	for (const auto &task : tasks)
+	{
+		write_value(buffer, task.first);
+		write_value(buffer, static_cast<std::uint32_t>(task.second.size()));
+		for (const auto &total : task.second)
+		{
+			write_value(buffer, total.clientName);
+			write_value(buffer, total.elementNumber);
+			write_value(buffer, total.ddi);
+			write_value(buffer, total.value);
+		}
+	}
+
+	// Write to a temporary file first, so a power loss never leaves a half written checkpoint
+	std::string temporaryPath = path + ".tmp";
+	{
+		std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+		{
+			TC_LOG_ERROR("Unable to save task totals. (Failed to open file)");
+			return false;
+		}
+		file.write(reinterpret_cast<const char *>(buffer.data()), buffer.size());
+		if (!file.good())
+		{
+			TC_LOG_ERROR("Unable to save task totals. (Failed to write file)");
+			return false;
+		}
+	}
+	std::error_code error;
+	std::filesystem::rename(temporaryPath, path, error);
+	if (error)
+	{
+		TC_LOG_ERROR("Unable to save task totals. ({})", error.message());
+		return false;
+	}
+	isDirty = false;
+	return true;
+}
+
+bool TaskTotals::load_checkpoint(const std::string &path)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open())
+	{
+		return false;
+	}
+	std::vector<std::uint8_t> buffer((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+	std::size_t offset = 0;
+	std::uint32_t magic = 0;
+	std::uint16_t version = 0;
+	std::uint32_t storedTask = 0;
+	std::uint32_t numberOfTasks = 0;
+	if (!read_value(buffer, offset, magic) || (CHECKPOINT_MAGIC != magic) ||
+	    !read_value(buffer, offset, version) || (CHECKPOINT_VERSION != version) ||
+	    !read_value(buffer, offset, storedTask) || !read_value(buffer, offset, numberOfTasks))
+	{
+		TC_LOG_WARNING("Ignoring task totals checkpoint {} (unknown format)", path);
+		return false;
+	}
+
+	std::map<std::uint32_t, std::vector<Total>> storedTasks;
+	for (std::uint32_t i = 0; i < numberOfTasks; i++)
+	{
+		std::uint32_t taskId = 0;
+		std::uint32_t numberOfTotals = 0;
+		if (!read_value(buffer, offset, taskId) || !read_value(buffer, offset, numberOfTotals))
+		{
+			TC_LOG_WARNING("Ignoring task totals checkpoint {} (truncated)", path);
+			return false;
+		}
+		auto &totals = storedTasks[taskId];
+		for (std::uint32_t j = 0; j < numberOfTotals; j++)
+		{
+			Total total;
+			if (!read_value(buffer, offset, total.clientName) || !read_value(buffer, offset, total.elementNumber) ||
+			    !read_value(buffer, offset, total.ddi) || !read_value(buffer, offset, total.value))
+			{
+				TC_LOG_WARNING("Ignoring task totals checkpoint {} (truncated)", path);
+				return false;
+			}
+			totals.push_back(total);
+		}
+	}
+
+	tasks = std::move(storedTasks);
+	currentTask = storedTask;
+	for (auto &reportState : reportStates)
+	{
+		reportState.second.hasLastValue = false;
+	}
+	build_task_index();
+	isDirty = false;
+	TC_LOG_INFO("Restored the totals of {} task(s), continuing task {}", tasks.size(), currentTask);
+	return true;
+}
+
+void TaskTotals::build_task_index()
+{
+	// Totals that were never reported in this task start at zero
+	auto &totals = tasks[currentTask];
+	currentTotals = &totals;
+	for (auto &reportState : reportStates)
+	{
+		const Key &key = reportState.first;
+		auto elementNumber = static_cast<std::uint16_t>(key.elementAndDdi >> 16);
+		auto ddi = static_cast<std::uint16_t>(key.elementAndDdi & 0xFFFF);
+		std::uint32_t index = 0;
+		while ((index < totals.size()) &&
+		       ((totals[index].clientName != key.clientName) || (totals[index].elementNumber != elementNumber) || (totals[index].ddi != ddi)))
+		{
+			index++;
+		}
+		if (index == totals.size())
+		{
+			totals.push_back({ key.clientName, elementNumber, ddi, 0 });
+		}
+		reportState.second.indexInTask = index;
+	}
+}
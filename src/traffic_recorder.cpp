@@ -0,0 +1,238 @@
+/**
+ * @author Daan Steenbergen
+ * @brief Records the traffic with AgIO and on the CAN bus, to replay it later
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright 2026 Daan Steenbergen
+ */
+#include "traffic_recorder.hpp"
+#include "log_macros.hpp"
+
+#include <algorithm>
+#include <iterator>
+
+constexpr std::uint16_t RECORDING_VERSION = 2;
+constexpr std::size_t RECORDING_HEADER_SIZE = 16; ///< Magic, version, two reserved bytes and the start time
+constexpr std::size_t MAX_VARINT_SIZE = 10;
+constexpr std::uint32_t EXTENDED_FRAME_FLAG = 0x80000000;
+
+/// @brief Write a value as a varint
+static std::size_t put_varint(std::uint8_t *destination, std::uint64_t value)
+{
+	std::size_t size = 0;
+	while (value >= 0x80)
+	{
+		destination[size++] = static_cast<std::uint8_t>(value | 0x80);
+		value >>= 7;
+	}
+	destination[size++] = static_cast<std::uint8_t>(value);
+	return size;
+}
+
+/// @brief Read a varint, false if it runs past the end of the data
+static bool get_varint(const std::vector<std::uint8_t> &source, std::size_t &index, std::uint64_t &value)
+{
+	value = 0;
+	for (std::size_t shift = 0; (index < source.size()) && (shift < 64); shift += 7)
+	{
+		std::uint8_t byte = source[index++];
+		value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+		if (0 == (byte & 0x80))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+TrafficRecorder::~TrafficRecorder()
+{
+	close();
+}
+
+bool TrafficRecorder::open(const std::string &path)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	file.open(path, std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	{
+		TC_LOG_ERROR("Unable to open traffic recording {}", path);
+		return false;
+	}
+
+	std::array<std::uint8_t, RECORDING_HEADER_SIZE> header = {};
+	std::copy(MAGIC.begin(), MAGIC.end(), header.begin());
+	header[4] = static_cast<std::uint8_t>(RECORDING_VERSION & 0xFF);
+	header[5] = static_cast<std::uint8_t>(RECORDING_VERSION >> 8);
+	startTime = AppClock::now();
+	auto startWallTime_us = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(AppClock::get_wall_time().time_since_epoch()).count());
+	for (std::size_t i = 0; i < 8; i++)
+	{
+		header[8 + i] = static_cast<std::uint8_t>(startWallTime_us >> (8 * i));
+	}
+	file.write(reinterpret_cast<const char *>(header.data()), header.size());
+	lastRecordTime_us = 0;
+	TC_LOG_INFO("Recording traffic to {}", path);
+	return true;
+}
+
+void TrafficRecorder::close()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if (file.is_open())
+	{
+		file.close();
+	}
+}
+
+bool TrafficRecorder::is_open() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return file.is_open();
+}
+
+void TrafficRecorder::flush()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if (file.is_open())
+	{
+		file.flush();
+	}
+}
+
+void TrafficRecorder::record_datagram(bool isReceived, std::span<const std::uint8_t> datagram)
+{
+	std::array<std::uint8_t, MAX_VARINT_SIZE> length;
+	std::size_t lengthSize = put_varint(length.data(), datagram.size());
+
+	std::lock_guard<std::mutex> lock(mutex);
+	if (!file.is_open())
+	{
+		return;
+	}
+	write_record(isReceived ? RecordType::DatagramReceived : RecordType::DatagramSent, length.data(), lengthSize);
+	file.write(reinterpret_cast<const char *>(datagram.data()), static_cast<std::streamsize>(datagram.size()));
+}
+
+void TrafficRecorder::record_can_frame(bool isReceived, const isobus::CANMessageFrame &frame)
+{
+	std::array<std::uint8_t, 13> payload;
+	std::uint32_t identifier = frame.identifier | (frame.isExtendedFrame ? EXTENDED_FRAME_FLAG : 0);
+	for (std::size_t i = 0; i < 4; i++)
+	{
+		payload[i] = static_cast<std::uint8_t>(identifier >> (8 * i));
+	}
+	std::uint8_t dataLength = std::min<std::uint8_t>(frame.dataLength, 8);
+	payload[4] = dataLength;
+	std::copy(frame.data, frame.data + dataLength, payload.begin() + 5);
+
+	std::lock_guard<std::mutex> lock(mutex);
+	if (!file.is_open())
+	{
+		return;
+	}
+	write_record(isReceived ? RecordType::CanFrameReceived : RecordType::CanFrameSent, payload.data(), 5 + dataLength);
+}
+
+void TrafficRecorder::write_record(RecordType type, const std::uint8_t *payload, std::size_t payloadSize)
+{
+	auto time_us = static_cast<std::uint64_t>(std::max<std::int64_t>(std::chrono::duration_cast<std::chrono::microseconds>(AppClock::now() - startTime).count(), 0));
+	time_us = std::max(time_us, lastRecordTime_us); // Records from two threads may be taken out of order
+
+	std::array<std::uint8_t, 1 + MAX_VARINT_SIZE> header;
+	header[0] = static_cast<std::uint8_t>(type);
+	std::size_t headerSize = 1 + put_varint(header.data() + 1, time_us - lastRecordTime_us);
+	lastRecordTime_us = time_us;
+	file.write(reinterpret_cast<const char *>(header.data()), static_cast<std::streamsize>(headerSize));
+	file.write(reinterpret_cast<const char *>(payload), static_cast<std::streamsize>(payloadSize));
+}
+
+bool TrafficRecorder::read(const std::string &path, std::vector<Record> &records)
+{
+	std::chrono::system_clock::time_point startTime;
+	return read(path, records, startTime);
+}
+
+bool TrafficRecorder::read(const std::string &path, std::vector<Record> &records, std::chrono::system_clock::time_point &startTime)
+{
+	records.clear();
+	std::ifstream input(path, std::ios::binary);
+	if (!input.is_open())
+	{
+		TC_LOG_ERROR("Unable to open traffic recording {}", path);
+		return false;
+	}
+	std::vector<std::uint8_t> data((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+	if ((data.size() < RECORDING_HEADER_SIZE) ||
+	    !std::equal(MAGIC.begin(), MAGIC.end(), data.begin()) ||
+	    (RECORDING_VERSION != (data[4] | (data[5] << 8))))
+	{
+		TC_LOG_ERROR("Unable to read {}. (Not a traffic recording of this version)", path);
+		return false;
+	}
+	std::uint64_t startTime_us = 0;
+	for (std::size_t i = 0; i < 8; i++)
+	{
+		startTime_us |= static_cast<std::uint64_t>(data[8 + i]) << (8 * i);
+	}
+	startTime = std::chrono::system_clock::time_point(std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::microseconds(startTime_us)));
+
+	std::size_t index = RECORDING_HEADER_SIZE;
+	std::uint64_t time_us = 0;
+	while (index < data.size())
+	{
+		Record record;
+		record.type = static_cast<RecordType>(data[index++]);
+		std::uint64_t delta_us;
+		if (!get_varint(data, index, delta_us))
+		{
+			return false;
+		}
+		time_us += delta_us;
+		record.time_us = time_us;
+
+		std::uint64_t size;
+		switch (record.type)
+		{
+			case RecordType::DatagramReceived:
+			case RecordType::DatagramSent:
+			{
+				if (!get_varint(data, index, size) || (data.size() - index < size))
+				{
+					return false;
+				}
+			}
+			break;
+
+			case RecordType::CanFrameReceived:
+			case RecordType::CanFrameSent:
+			{
+				if (data.size() - index < 5)
+				{
+					return false;
+				}
+				std::uint32_t identifier = data[index] | (data[index + 1] << 8) | (data[index + 2] << 16) | (static_cast<std::uint32_t>(data[index + 3]) << 24);
+				record.identifier = identifier & ~EXTENDED_FRAME_FLAG;
+				record.isExtendedFrame = 0 != (identifier & EXTENDED_FRAME_FLAG);
+				size = std::min<std::uint8_t>(data[index + 4], 8);
+				index += 5;
+				if (data.size() - index < size)
+				{
+					return false;
+				}
+			}
+			break;
+
+			default:
+			{
+				TC_LOG_WARNING("Unknown record type {} in {}", static_cast<int>(record.type), path);
+				return false;
+			}
+		}
+		record.data.assign(data.begin() + index, data.begin() + index + size);
+		index += size;
+		records.push_back(std::move(record));
+	}
+	return true;
+}
@@ -8,6 +8,7 @@
  */
 
 #include "udp_connections.hpp"
+#include "metrics.hpp"
 #include <cassert>
 #include <iostream>
 
@@ -20,7 +21,17 @@ UdpConnections::UdpConnections(std::shared_ptr<Settings> settings, boost::asio::
 }
 void UdpConnections::set_packet_handler(PacketCallback packetCallback)
 {
-	this->packetCallback = packetCallback;
+	packetParser.set_packet_handler(packetCallback);
+}
+
+void UdpConnections::set_subnet_handler(SubnetCallback subnetCallback)
+{
+	this->subnetCallback = subnetCallback;
+}
+
+void UdpConnections::set_datagram_handler(DatagramCallback datagramCallback)
+{
+	this->datagramCallback = datagramCallback;
 }
 
 bool UdpConnections::open()
@@ -82,25 +93,14 @@ udp::endpoint UdpConnections::get_local_endpoint() const
 	return udp::endpoint(boost::asio::ip::address_v4::loopback(), 8888);
 }
 
-std::uint8_t UdpConnections::calculate_crc(std::span<std::uint8_t> data)
-{
-	int result = 0;
-	for (uint8_t i = 0; i < data.size(); i++)
-	{
-		result += data[i];
-	}
-	return static_cast<std::uint8_t>(result & 0xFF);
-}
-
 void UdpConnections::handle_incoming_packets()
 {
-	static std::array<std::uint8_t, 512> rxBuffer;
-	static std::size_t rxIndex = 0;
+	std::array<std::uint8_t, MAX_PACKET_SIZE> datagram;
 
 	// Peek to see if we have any data
 	boost::system::error_code error_code;
 	udp::endpoint sender_endpoint;
-	size_t bytesReceived = udpConnection.receive_from(boost::asio::buffer(rxBuffer.data() + rxIndex, sizeof(rxBuffer) - rxIndex), sender_endpoint, 0, error_code);
+	size_t bytesReceived = udpConnection.receive_from(boost::asio::buffer(datagram), sender_endpoint, 0, error_code);
 
 	if (error_code == boost::asio::error::would_block)
 	{
@@ -108,52 +108,7 @@ void UdpConnections::handle_incoming_packets()
 	}
 	else if (!error_code)
 	{
-		rxIndex += bytesReceived;
-		std::uint8_t index = 0;
-
-		while (rxIndex >= 8)
-		{
-			std::uint16_t start = (rxBuffer[index++] << 8) | rxBuffer[index++];
-			if (start == PACKET_START)
-			{
-				std::uint8_t src = rxBuffer[index++];
-				std::uint8_t pgn = rxBuffer[index++];
-				std::uint8_t len = rxBuffer[index++];
-				std::uint8_t crc = rxBuffer[index + len];
-
-				// Check CRC (skip start of packet, but include source, PGN, length and data)
-				// std::uint8_t crcCalc = calculate_crc({ rxBuffer.data() + index - 3, static_cast<size_t>(len) + 3 });
-				// if (crc != crcCalc)
-				// {
-				//  std::cout << "CRC mismatch (for PGN " << static_cast<int>(pgn) << "?), expected " << static_cast<int>(crc) << " but got " << static_cast<int>(crcCalc) << std::endl;
-				// 	rxIndex = 0;
-				// 	break;
-				// }
-
-				if (packetCallback)
-				{
-					packetCallback(src, pgn, { rxBuffer.data() + index, len });
-				}
-				index += len + 1;
-			}
-			else
-			{
-				// Unknown start of message, reset buffer
-				std::cout << "Unknown start of message: 0x" << std::hex << start << std::dec << std::endl;
-				rxIndex = 0;
-			}
-
-			// Move any remaining data to the front of the buffer
-			if (index < rxIndex)
-			{
-				std::memmove(rxBuffer.data(), rxBuffer.data() + index, rxIndex - index);
-				rxIndex -= index;
-			}
-			else
-			{
-				rxIndex = 0;
-			}
-		}
+		handle_datagram({ datagram.data(), bytesReceived });
 	}
 	else
 	{
@@ -161,6 +116,15 @@ void UdpConnections::handle_incoming_packets()
 	}
 }
 
+void UdpConnections::handle_datagram(std::span<const std::uint8_t> datagram)
+{
+	if (datagramCallback)
+	{
+		datagramCallback(true, datagram);
+	}
+	packetParser.parse(datagram);
+}
+
 void UdpConnections::handle_address_detection()
 {
 	static std::array<std::uint8_t, 512> rxBuffer;
@@ -177,6 +141,10 @@ void UdpConnections::handle_address_detection()
 	}
 	else if (!error_code)
 	{
+		if (datagramCallback)
+		{
+			datagramCallback(true, { rxBuffer.data() + rxIndex, bytesReceived });
+		}
 		rxIndex += bytesReceived;
 		std::uint8_t index = 0;
 
@@ -215,6 +183,10 @@ void UdpConnections::handle_address_detection()
 					udpConnection.set_option(boost::asio::socket_base::broadcast(true));
 					udpConnection.non_blocking(true);
 					udpConnection.bind(get_local_endpoint());
+					if (subnetCallback)
+					{
+						subnetCallback(settings->get_subnet());
+					}
 
 					index += len - 4;
 				}
@@ -261,7 +233,11 @@ bool UdpConnections::send(std::uint8_t src, std::uint8_t pgn, std::span<std::uin
 	std::copy(data.begin(), data.end(), txBuffer.begin() + index);
 	index += data.size();
 
-	txBuffer[index] = calculate_crc({ txBuffer.data() + 2, index - 2 });
+	txBuffer[index] = AogPacketParser::calculate_crc({ txBuffer.data() + 2, index - 2 });
+	if (datagramCallback)
+	{
+		datagramCallback(false, { txBuffer.data(), index + 1 }); // Also when it can't be sent, it's what the TC decided to send
+	}
 
 	auto subnet = settings->get_subnet();
 	boost::asio::ip::address_v4 broadcast_address = boost::asio::ip::make_address_v4(std::to_string(subnet[0]) + "." +
@@ -278,5 +254,6 @@ bool UdpConnections::send(std::uint8_t src, std::uint8_t pgn, std::span<std::uin
 		// Probably wrong subnet, ignore
 		return false;
 	}
+	Metrics::count_udp_packet_sent(pgn);
 	return true;
 }
@@ -0,0 +1,87 @@
+/**
+ * @author Daan Steenbergen
+ * @brief Live work rate statistics based on the actual section states
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright 2026 Daan Steenbergen
+ */
+#include "work_statistics.hpp"
+
+#include <cstdlib>
+#include <utility>
+
+void WorkStatistics::set_section_widths(std::vector<std::uint32_t> sectionWidths)
+{
+	sectionWidths_mm = std::move(sectionWidths);
+	lastSectionStates.clear();
+	workingWidth_mm = 0;
+}
+
+void WorkStatistics::update_section_states(const SectionMask &actualStates, Clock::time_point now)
+{
+	SectionMask changedStates = actualStates ^ lastSectionStates;
+	if (!changedStates.any())
+	{
+		return;
+	}
+
+	integrate(now);
+	changedStates.for_each_set([this, &actualStates](std::uint16_t section) {
+		if (section < sectionWidths_mm.size())
+		{
+			if (actualStates.test(section))
+			{
+				workingWidth_mm += sectionWidths_mm[section];
+			}
+			else
+			{
+				workingWidth_mm -= sectionWidths_mm[section];
+			}
+		}
+	});
+	lastSectionStates = actualStates;
+}
+
+void WorkStatistics::update_speed(std::int32_t speed, Clock::time_point now)
+{
+	integrate(now);
+	speed_mm_per_s = static_cast<std::uint32_t>(std::abs(speed));
+}
+
+std::uint32_t WorkStatistics::get_working_width() const
+{
+	return workingWidth_mm;
+}
+
+std::uint32_t WorkStatistics::get_area_rate() const
+{
+	// mm * mm/s to m2/h: 3600 s/h / 1000000 mm2/m2
+	return static_cast<std::uint32_t>(static_cast<std::uint64_t>(workingWidth_mm) * speed_mm_per_s * 36 / 10000);
+}
+
+double WorkStatistics::get_worked_area(Clock::time_point now) const
+{
+	double area_mm2 = workedArea_mm2;
+	if (hasLastUpdate && (now > lastUpdate))
+	{
+		area_mm2 += static_cast<double>(workingWidth_mm) * speed_mm_per_s * std::chrono::duration<double>(now - lastUpdate).count();
+	}
+	return area_mm2 / 1000000.0;
+}
+
+void WorkStatistics::reset(Clock::time_point now)
+{
+	integrate(now); // Moves the start of the integration to now
+	workedArea_mm2 = 0.0;
+}
+
+void WorkStatistics::integrate(Clock::time_point now)
+{
+	if (hasLastUpdate && (now > lastUpdate))
+	{
+		workedArea_mm2 += static_cast<double>(workingWidth_mm) * speed_mm_per_s * std::chrono::duration<double>(now - lastUpdate).count();
+	}
+	lastUpdate = now;
+	hasLastUpdate = true;
+}
@@ -0,0 +1,343 @@
+/**
+ * @author Daan Steenbergen
+ * @brief Microbenchmarks of the hot paths of the task controller
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright 2026 Daan Steenbergen
+ */
+#include "aog_packet_parser.hpp"
+#include "app.hpp"
+#include "async_logger.hpp"
+#include "loop_profiler.hpp"
+#include "prescription_map.hpp"
+#include "simulated_implement.hpp"
+#include "task_controller.hpp"
+
+#include "isobus/isobus/can_network_manager.hpp"
+#include "isobus/isobus/can_stack_logger.hpp"
+#include "isobus/isobus/isobus_standard_data_description_indices.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+static std::atomic<std::uint64_t> numberOfAllocations = { 0 };
+
+// Counts every allocation of the process, the CAN stack isn't running so nearly all of them are the benchmark's
+void *operator new(std::size_t size)
+{
+	numberOfAllocations.fetch_add(1, std::memory_order_relaxed);
+	void *pointer = std::malloc(size > 0 ? size : 1);
+	if (nullptr == pointer)
+	{
+		throw std::bad_alloc();
+	}
+	return pointer;
+}
+
+void operator delete(void *pointer) noexcept
+{
+	std::free(pointer);
+}
+
+void operator delete(void *pointer, std::size_t) noexcept
+{
+	std::free(pointer);
+}
+
+static volatile std::uint64_t sink = 0; ///< Results are added to this, so the compiler can't remove the work
+static std::string filter;
+static std::chrono::nanoseconds minimumDuration = std::chrono::milliseconds(200);
+
+using Clock = std::chrono::steady_clock;
+
+static void report(const std::string &name, std::chrono::nanoseconds duration, std::uint64_t allocations, std::uint64_t iterations)
+{
+	std::printf("%-60s %12.1f ns/op %8.2f allocs/op %10llu ops\n",
+	            name.c_str(),
+	            static_cast<double>(duration.count()) / static_cast<double>(iterations),
+	            static_cast<double>(allocations) / static_cast<double>(iterations),
+	            static_cast<unsigned long long>(iterations));
+}
+
+/**
+ * @brief Run an operation in doubling batches until it ran for the minimum duration, then report the averages
+ * @param name The name of the benchmark, also what --filter matches
+ * @param operation The operation to measure
+ */
+template<typename Operation>
+static void run(const std::string &name, Operation operation)
+{
+	if (!filter.empty() && (std::string::npos == name.find(filter)))
+	{
+		return;
+	}
+
+	operation(); // Warm up, first calls may allocate caches
+	std::uint64_t iterations = 0;
+	std::uint64_t allocations = 0;
+	std::chrono::nanoseconds duration(0);
+	for (std::uint64_t batch = 1; duration < minimumDuration; batch *= 2)
+	{
+		std::uint64_t allocationsBefore = numberOfAllocations.load(std::memory_order_relaxed);
+		auto start = Clock::now();
+		for (std::uint64_t i = 0; i < batch; i++)
+		{
+			operation();
+		}
+		duration += Clock::now() - start;
+		allocations += numberOfAllocations.load(std::memory_order_relaxed) - allocationsBefore;
+		iterations += batch;
+	}
+	report(name, duration, allocations, iterations);
+}
+
+/**
+ * @brief Run an operation that needs a fresh state every time, only the operation itself is measured
+ * @param name The name of the benchmark, also what --filter matches
+ * @param setup Prepares the state, not measured
+ * @param operation The operation to measure
+ */
+template<typename Setup, typename Operation>
+static void run_with_setup(const std::string &name, Setup setup, Operation operation)
+{
+	constexpr std::uint64_t MAX_ITERATIONS = 1000; // The setup may take far longer than the operation
+	if (!filter.empty() && (std::string::npos == name.find(filter)))
+	{
+		return;
+	}
+
+	std::uint64_t iterations = 0;
+	std::uint64_t allocations = 0;
+	std::chrono::nanoseconds duration(0);
+	while ((duration < minimumDuration) && (iterations < MAX_ITERATIONS))
+	{
+		setup();
+		std::uint64_t allocationsBefore = numberOfAllocations.load(std::memory_order_relaxed);
+		auto start = Clock::now();
+		operation();
+		duration += Clock::now() - start;
+		allocations += numberOfAllocations.load(std::memory_order_relaxed) - allocationsBefore;
+		iterations++;
+	}
+	report(name, duration, allocations, iterations);
+}
+
+static std::vector<std::uint8_t> make_packet(std::uint8_t pgn, const std::vector<std::uint8_t> &data)
+{
+	std::vector<std::uint8_t> packet = { 0x80, 0x81, 0x7F, pgn, static_cast<std::uint8_t>(data.size()) };
+	packet.insert(packet.end(), data.begin(), data.end());
+	packet.push_back(AogPacketParser::calculate_crc({ packet.data() + 2, packet.size() - 2 }));
+	return packet;
+}
+
+/// @brief The shapes of the simulated implements, from a small sprayer to the largest the TC supports
+struct PoolShape
+{
+	std::uint8_t numberOfBooms;
+	std::uint8_t numberOfSectionsPerBoom;
+	std::uint8_t elementDepth;
+};
+static const std::vector<PoolShape> POOL_SHAPES = { { 1, 8, 1 }, { 4, 16, 2 }, { 12, 16, 3 } };
+
+static std::vector<std::uint8_t> generate_pool(const PoolShape &shape)
+{
+	SimulatedImplement::Configuration configuration;
+	configuration.numberOfBooms = shape.numberOfBooms;
+	configuration.numberOfSectionsPerBoom = shape.numberOfSectionsPerBoom;
+	configuration.elementDepth = shape.elementDepth;
+	SimulatedImplement implement(1, configuration);
+	std::vector<std::uint8_t> binaryPool;
+	if (!implement.generate_binary_pool(0, binaryPool))
+	{
+		std::cerr << "Failed to generate a DDOP" << std::endl;
+	}
+	return binaryPool;
+}
+
+static std::string get_shape_name(const PoolShape &shape)
+{
+	return std::to_string(shape.numberOfBooms) + "x" + std::to_string(shape.numberOfSectionsPerBoom) + " sections, depth " + std::to_string(shape.elementDepth);
+}
+
+static bool connect(MyTCServer &tcServer, std::shared_ptr<isobus::ControlFunction> partner, const std::vector<std::uint8_t> &binaryPool)
+{
+	MyTCServer::ObjectPoolActivationError activationError;
+	MyTCServer::ObjectPoolErrorCodes poolErrorCodes;
+	std::uint16_t parentObjectId;
+	std::uint16_t faultyObjectId;
+	tcServer.store_device_descriptor_object_pool(partner, binaryPool, false);
+	return tcServer.activate_object_pool(partner, activationError, poolErrorCodes, parentObjectId, faultyObjectId);
+}
+
+static void benchmark_aog_packets()
+{
+	AogPacketParser parser;
+	std::uint64_t numberOfPackets = 0;
+	parser.set_packet_handler([&numberOfPackets](std::uint8_t, std::uint8_t, std::span<std::uint8_t> data) { numberOfPackets += data.size(); });
+
+	auto steerData = make_packet(0xFE, { 0x10, 0x00, 0x20, 0x00, 0x30, 0x00, 0xFF, 0x00 });
+	run("AogPacketParser::parse, steer data", [&]() { parser.parse(steerData); });
+
+	auto datagram = steerData;
+	for (const auto &packet : { make_packet(0xF1, { 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08 }), make_packet(0xEF, std::vector<std::uint8_t>(24, 0x55)) })
+	{
+		datagram.insert(datagram.end(), packet.begin(), packet.end());
+	}
+	run("AogPacketParser::parse, 3 packets in a datagram", [&]() { parser.parse(datagram); });
+	sink = sink + numberOfPackets;
+
+	for (std::size_t size : { 13, 64, 255 })
+	{
+		std::vector<std::uint8_t> data(size, 0xA5);
+		run("AogPacketParser::calculate_crc, " + std::to_string(size) + " bytes", [&]() { sink = sink + AogPacketParser::calculate_crc(data); });
+	}
+}
+
+static void benchmark_task_controller()
+{
+	isobus::NAME serverName(0);
+	serverName.set_arbitrary_address_capable(true);
+	serverName.set_industry_group(2);
+	serverName.set_function_code(static_cast<std::uint8_t>(isobus::NAME::Function::TaskController));
+	serverName.set_identity_number(20);
+	serverName.set_manufacturer_code(1407);
+	auto serverCF = isobus::CANNetworkManager::CANNetwork.create_internal_control_function(serverName, 0, 0xF7);
+	auto tcServer = std::make_shared<MyTCServer>(serverCF);
+
+	const std::vector<isobus::NAMEFilter> filters = { isobus::NAMEFilter(isobus::NAME::NAMEParameters::FunctionCode, static_cast<std::uint8_t>(isobus::NAME::Function::RateControl)) };
+	for (const auto &shape : POOL_SHAPES)
+	{
+		auto binaryPool = generate_pool(shape);
+		auto partner = isobus::CANNetworkManager::CANNetwork.create_partnered_control_function(0, filters);
+		if (!connect(*tcServer, partner, binaryPool))
+		{
+			std::cerr << "Failed to activate the DDOP of " << get_shape_name(shape) << std::endl;
+			continue;
+		}
+		auto &state = tcServer->get_clients()[partner];
+		std::string shapeName = get_shape_name(shape);
+
+		// The last section is the furthest from the device element
+		std::uint16_t lastElementNumber = static_cast<std::uint16_t>(shape.numberOfBooms * (shape.elementDepth + shape.numberOfSectionsPerBoom));
+		run("ClientState::is_element_or_parent_off, " + std::to_string(state.get_pool().size()) + " objects (" + shapeName + ")",
+		    [&]() { sink = sink + state.is_element_or_parent_off(lastElementNumber); });
+
+		run_with_setup(
+		  "MyTCServer::request_measurement_commands, " + shapeName,
+		  [&]() {
+			  tcServer->deactivate_object_pool(partner);
+			  connect(*tcServer, partner, binaryPool);
+		  },
+		  [&]() { tcServer->request_measurement_commands(); });
+
+		std::uint8_t errorCodes = 0;
+		tcServer->on_value_command(partner, static_cast<std::uint16_t>(isobus::DataDescriptionIndex::SectionControlState), 0, 1, errorCodes);
+		auto &clientState = tcServer->get_clients()[partner];
+		std::uint16_t firstBoomElementNumber = 1;
+		std::int32_t actualStates = 0;
+		run("MyTCServer::on_value_command, condensed work state (" + shapeName + ")", [&]() {
+			actualStates ^= 0x5555; // Sections 1 to 8 on and off, so every call changes something
+			tcServer->on_value_command(partner, static_cast<std::uint16_t>(isobus::DataDescriptionIndex::ActualCondensedWorkState1_16), firstBoomElementNumber, actualStates, errorCodes);
+		});
+
+		SectionMask requestedStates;
+		run("MyTCServer::update_section_states, condensed setpoints (" + shapeName + ")", [&]() {
+			requestedStates.words[0] ^= 0xFFFF; // Every call changes the first 16 sections, the set values aren't sent without a bus
+			tcServer->update_section_states(requestedStates);
+		});
+
+		run("Application::build_section_status, 0xF0 heartbeat (" + shapeName + ")", [&]() { sink = sink + Application::build_section_status(clientState).size(); });
+
+		tcServer->deactivate_object_pool(partner); // One client at a time, update_section_states visits all of them
+	}
+}
+
+static void benchmark_prescription_map()
+{
+	constexpr std::uint32_t GRID_SIZE = 5000;
+	constexpr double CELL_SIZE = 0.00001; // About a metre
+	std::vector<std::int32_t> rates(static_cast<std::size_t>(GRID_SIZE) * GRID_SIZE);
+	for (std::size_t i = 0; i < rates.size(); i++)
+	{
+		rates[i] = static_cast<std::int32_t>(i % 1000);
+	}
+	PrescriptionMap prescriptionMap;
+	if (!prescriptionMap.set_grid(static_cast<std::uint16_t>(isobus::DataDescriptionIndex::SetpointVolumePerAreaApplicationRate), 52.0, 5.0, CELL_SIZE, CELL_SIZE, GRID_SIZE, GRID_SIZE, rates))
+	{
+		std::cerr << "Failed to set the prescription grid" << std::endl;
+		return;
+	}
+
+	double latitude = 52.0 + CELL_SIZE * GRID_SIZE / 2;
+	double longitude = 5.0 + CELL_SIZE * GRID_SIZE / 2;
+	std::uint32_t step = 0;
+	run("PrescriptionMap::get_rate, 5000x5000 cells", [&]() {
+		step = (step + 7) % 1000;
+		sink = sink + static_cast<std::uint64_t>(prescriptionMap.get_rate(latitude + step * CELL_SIZE, longitude));
+	});
+	run("PrescriptionMap::get_section_rate, 3 m section, 5000x5000 cells", [&]() {
+		step = (step + 7) % 1000;
+		sink = sink + static_cast<std::uint64_t>(prescriptionMap.get_section_rate(latitude + step * CELL_SIZE, longitude, 45.0, -1.0, 1.5, 3.0));
+	});
+}
+
+static void benchmark_diagnostics()
+{
+	LoopProfiler loopProfiler;
+	run("LoopProfiler, loop of 3 phases", [&]() {
+		loopProfiler.start_loop();
+		loopProfiler.end_phase(LoopProfiler::Phase::UdpReceive);
+		loopProfiler.end_phase(LoopProfiler::Phase::TaskController);
+		loopProfiler.end_phase(LoopProfiler::Phase::Heartbeat);
+		sink = sink + static_cast<std::uint64_t>(loopProfiler.end_loop().count());
+	});
+
+	// Only the producer side, the background thread formats and writes the records
+	std::uint32_t value = 0;
+	run("AsyncLogger::log, 2 arguments", [&]() { AsyncLogger::log(AsyncLogger::Level::Critical, "Benchmark {} of {}", value++, "records"); });
+}
+
+int main(int argc, char **argv)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		std::string argument = argv[i];
+		if (0 == argument.rfind("--filter=", 0))
+		{
+			filter = argument.substr(9);
+		}
+		else if (0 == argument.rfind("--min_time_ms=", 0))
+		{
+			minimumDuration = std::chrono::milliseconds(std::stoul(argument.substr(14)));
+		}
+		else
+		{
+			std::cerr << "Usage: benchmarks [options]" << std::endl;
+			std::cerr << "  --filter=<text>\tOnly run the benchmarks whose name contains the text" << std::endl;
+			std::cerr << "  --min_time_ms=<n>\tHow long to run each benchmark at least (200)" << std::endl;
+			return 1;
+		}
+	}
+
+	// Activating a DDOP logs every section, and the logger's thread would allocate while measuring
+	isobus::CANStackLogger::set_log_level(isobus::CANStackLogger::LoggingLevel::Critical);
+	std::ofstream discardedLog;
+	AsyncLogger::start(discardedLog.rdbuf(), "");
+
+	benchmark_aog_packets();
+	benchmark_task_controller();
+	benchmark_prescription_map();
+	benchmark_diagnostics();
+
+	AsyncLogger::stop();
+	return 0;
+}
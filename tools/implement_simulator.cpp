@@ -0,0 +1,294 @@
+/**
+ * @author Daan Steenbergen
+ * @brief Runs the task controller in-process with a fleet of simulated implements on a virtual CAN bus
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright 2026 Daan Steenbergen
+ */
+#include "app.hpp"
+#include "app_clock.hpp"
+#include "async_logger.hpp"
+#include "loop_profiler.hpp"
+#include "simulated_implement.hpp"
+
+#include "isobus/hardware_integration/can_hardware_interface.hpp"
+#include "isobus/hardware_integration/virtual_can_plugin.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+/// @brief The progress of one implement towards the last commanded section states
+struct ImplementRun
+{
+	std::unique_ptr<SimulatedImplement> implement;
+	std::chrono::steady_clock::time_point connectedTime; ///< Real time, connecting runs on the CAN stack's own timers
+	bool isConnected = false;
+	bool isMatched = true;
+	std::uint32_t numberOfMissedPatterns = 0; ///< Patterns that were replaced before the implement reached them
+	LoopProfiler::Histogram latency; ///< From the command to the matching actual states
+};
+
+/// @brief The frames of each end of the virtual bus, to know when every frame has arrived
+static std::array<std::atomic<std::uint32_t>, 2> framesSent = {};
+static std::array<std::atomic<std::uint32_t>, 2> framesReceived = {};
+
+/**
+ * @brief Wait until the frames on the virtual bus have arrived and were processed by the CAN stack
+ * @return True if there was traffic since the last call, false if the bus was idle
+ */
+static bool settle_bus()
+{
+	// A bit longer than the update interval of the CAN stack's thread, which processes the received frames
+	constexpr auto QUIET_TIME = std::chrono::milliseconds(5);
+	static std::uint32_t lastNumberOfFrames = 0;
+
+	auto get_number_of_frames = []() { return framesSent[0] + framesSent[1]; };
+	auto is_in_flight = []() { return (framesSent[0] != framesReceived[1]) || (framesSent[1] != framesReceived[0]); };
+	if (!is_in_flight() && (get_number_of_frames() == lastNumberOfFrames))
+	{
+		return false;
+	}
+
+	std::uint32_t numberOfFrames;
+	do
+	{
+		numberOfFrames = get_number_of_frames();
+		std::this_thread::sleep_for(QUIET_TIME);
+	} while (is_in_flight() || (get_number_of_frames() != numberOfFrames));
+	lastNumberOfFrames = numberOfFrames;
+	return true;
+}
+
+static bool parse_number(const std::string &argument, const std::string &key, std::uint32_t &value)
+{
+	if (0 != argument.rfind(key + "=", 0))
+	{
+		return false;
+	}
+	value = static_cast<std::uint32_t>(std::stoul(argument.substr(key.size() + 1)));
+	return true;
+}
+
+int main(int argc, char **argv)
+{
+	std::uint32_t numberOfImplements = 4;
+	std::uint32_t numberOfBooms = 1;
+	std::uint32_t numberOfSections = 8;
+	std::uint32_t elementDepth = 1;
+	std::uint32_t latency_ms = 100;
+	std::uint32_t duration_s = 60;
+	std::uint32_t patternInterval_ms = 2000;
+	bool timeWarp = false;
+	for (int i = 1; i < argc; i++)
+	{
+		std::string argument = argv[i];
+		if ("--time_warp" == argument)
+		{
+			timeWarp = true;
+		}
+		else if (!parse_number(argument, "--implements", numberOfImplements) &&
+		    !parse_number(argument, "--booms", numberOfBooms) &&
+		    !parse_number(argument, "--sections", numberOfSections) &&
+		    !parse_number(argument, "--depth", elementDepth) &&
+		    !parse_number(argument, "--latency_ms", latency_ms) &&
+		    !parse_number(argument, "--duration_s", duration_s) &&
+		    !parse_number(argument, "--pattern_ms", patternInterval_ms))
+		{
+			std::cerr << "Usage: implement-simulator [options]" << std::endl;
+			std::cerr << "  --implements=<n>\tNumber of simulated implements (4)" << std::endl;
+			std::cerr << "  --booms=<n>\t\tBooms per implement (1)" << std::endl;
+			std::cerr << "  --sections=<n>\tSections per boom (8)" << std::endl;
+			std::cerr << "  --depth=<n>\t\tFunction elements from the device element down to the sections (1)" << std::endl;
+			std::cerr << "  --latency_ms=<n>\tFrom a setpoint to the actual state (100)" << std::endl;
+			std::cerr << "  --duration_s=<n>\tHow long to run (60)" << std::endl;
+			std::cerr << "  --pattern_ms=<n>\tHow often AOG changes the section states (2000)" << std::endl;
+			std::cerr << "  --time_warp\t\tRun on virtual time, from event to event instead of in real time" << std::endl;
+			return 1;
+		}
+	}
+
+	AsyncLogger::start(std::cout.rdbuf(), "");
+	AppClock::set_virtual(timeWarp);
+	if (timeWarp)
+	{
+		// Every time-warped run starts at the same calendar time, so the task data and logs are the same as well
+		AppClock::set_wall_time(std::chrono::sys_days(std::chrono::year(2026) / 1 / 1));
+	}
+
+	// Two ends of the same virtual bus: channel 0 is the task controller's, channel 1 the implements'
+	const std::string busName = "aog-tc-simulator";
+	Application app(std::make_shared<isobus::VirtualCANPlugin>(busName));
+	app.add_can_driver(std::make_shared<isobus::VirtualCANPlugin>(busName));
+	isobus::CANHardwareInterface::get_can_frame_transmitted_event_dispatcher().add_listener([](const isobus::CANMessageFrame &frame) {
+		if (frame.channel < framesSent.size())
+		{
+			framesSent[frame.channel]++;
+		}
+	});
+	isobus::CANHardwareInterface::get_can_frame_received_event_dispatcher().add_listener([](const isobus::CANMessageFrame &frame) {
+		if (frame.channel < framesReceived.size())
+		{
+			framesReceived[frame.channel]++;
+		}
+	});
+	if (!app.initialize())
+	{
+		std::cerr << "Failed to initialize the task controller" << std::endl;
+		AsyncLogger::stop();
+		return 1;
+	}
+
+	SimulatedImplement::Configuration configuration;
+	configuration.numberOfBooms = static_cast<std::uint8_t>(numberOfBooms);
+	configuration.numberOfSectionsPerBoom = static_cast<std::uint8_t>(numberOfSections);
+	configuration.elementDepth = static_cast<std::uint8_t>(std::max<std::uint32_t>(elementDepth, 1));
+	configuration.latency = std::chrono::milliseconds(latency_ms);
+
+	auto connectStartTime = std::chrono::steady_clock::now();
+	std::vector<ImplementRun> runs(numberOfImplements);
+	for (std::uint32_t i = 0; i < numberOfImplements; i++)
+	{
+		runs[i].implement = std::make_unique<SimulatedImplement>(i + 1, configuration);
+		if (!runs[i].implement->initialize(1))
+		{
+			app.stop();
+			AsyncLogger::stop();
+			return 1;
+		}
+	}
+	std::uint16_t numberOfSectionsPerImplement = runs.empty() ? 0 : runs.front().implement->get_number_of_sections();
+
+	std::mt19937 random(42); // The same patterns on every run
+	SectionMask pattern;
+	LoopProfiler::Histogram updateDurations;
+	auto patternTime = AppClock::now();
+	auto update_all = [&]() {
+		auto updateStart = std::chrono::steady_clock::now();
+		if (!app.update())
+		{
+			return false;
+		}
+		updateDurations.add(static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - updateStart).count()));
+		auto now = AppClock::now();
+		for (auto &run : runs)
+		{
+			run.implement->update();
+			if (!run.isConnected && run.implement->is_connected())
+			{
+				run.isConnected = true;
+				run.connectedTime = std::chrono::steady_clock::now();
+			}
+			if (!run.isMatched && (run.implement->get_actual_states().words == pattern.words))
+			{
+				run.isMatched = true;
+				run.latency.add(static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now - patternTime).count()));
+			}
+		}
+		return true;
+	};
+
+	if (timeWarp)
+	{
+		// Connecting runs on the CAN stack's timers, which are always real time, so it's done before the session starts
+		auto connectDeadline = connectStartTime + std::chrono::seconds(30);
+		while (std::any_of(runs.begin(), runs.end(), [](const ImplementRun &run) { return !run.isConnected; }) &&
+		       (std::chrono::steady_clock::now() < connectDeadline) &&
+		       update_all())
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	}
+
+	// The heartbeat to AOG is the shortest timer of the application
+	constexpr auto MAXIMUM_TIME_STEP = std::chrono::milliseconds(100);
+	auto realStartTime = std::chrono::steady_clock::now();
+	auto startTime = AppClock::now();
+	auto endTime = startTime + std::chrono::seconds(duration_s);
+	patternTime = startTime;
+	while (AppClock::now() < endTime)
+	{
+		if (!update_all())
+		{
+			break;
+		}
+
+		auto now = AppClock::now();
+		if (now - patternTime >= std::chrono::milliseconds(patternInterval_ms))
+		{
+			pattern.clear();
+			for (std::uint16_t section = 0; section < numberOfSectionsPerImplement; section++)
+			{
+				pattern.set(section, 0 != (random() & 1));
+			}
+			for (auto &run : runs)
+			{
+				if (run.isConnected && !run.isMatched)
+				{
+					run.numberOfMissedPatterns++;
+				}
+				run.isMatched = !run.isConnected;
+			}
+			patternTime = now;
+			app.get_task_controller()->update_section_control_enabled(true); // Only sent to the clients that are not enabled yet
+			app.get_task_controller()->update_section_states(pattern);
+		}
+
+		if (!timeWarp)
+		{
+			AppClock::sleep_until(app.get_next_update_time());
+		}
+		else if (!settle_bus())
+		{
+			// Nothing left to react to at this time, skip to the next event
+			auto nextTime = std::min({ patternTime + std::chrono::milliseconds(patternInterval_ms), now + MAXIMUM_TIME_STEP, app.get_task_controller()->get_next_scheduled_section_time() });
+			for (const auto &run : runs)
+			{
+				nextTime = std::min(nextTime, run.implement->get_next_due_time());
+			}
+			AppClock::advance_to(nextTime);
+		}
+	}
+	auto realDuration = std::chrono::steady_clock::now() - realStartTime;
+
+	auto to_ms = [](std::uint64_t duration_ns) { return std::round(static_cast<double>(duration_ns) / 100000.0) / 10.0; };
+	std::cout << std::endl;
+	std::cout << numberOfImplements << " implements of " << numberOfSectionsPerImplement << " sections, DDOP of " << (runs.empty() ? 0 : runs.front().implement->get_pool_size()) << " bytes" << std::endl;
+	for (std::size_t i = 0; i < runs.size(); i++)
+	{
+		const auto &run = runs[i];
+		std::cout << "Implement " << i + 1 << ": ";
+		if (!run.isConnected)
+		{
+			std::cout << "not connected" << std::endl;
+			continue;
+		}
+		std::cout << "connected after " << std::chrono::duration_cast<std::chrono::milliseconds>(run.connectedTime - connectStartTime).count() << " ms, "
+		          << run.implement->get_number_of_set_values() << " set values, "
+		          << run.latency.get_number_of_samples() << " patterns reached (p50 " << to_ms(run.latency.get_percentile(50.0))
+		          << " ms, p99 " << to_ms(run.latency.get_percentile(99.0))
+		          << " ms, max " << to_ms(run.latency.get_maximum()) << " ms), "
+		          << run.numberOfMissedPatterns << " missed" << std::endl;
+	}
+	std::cout << "Main loop update: p50 " << to_ms(updateDurations.get_percentile(50.0)) << " ms, p99 " << to_ms(updateDurations.get_percentile(99.0))
+	          << " ms, max " << to_ms(updateDurations.get_maximum()) << " ms" << std::endl;
+	std::cout << "Simulated " << std::chrono::duration_cast<std::chrono::seconds>(AppClock::now() - startTime).count() << " s in "
+	          << std::chrono::duration_cast<std::chrono::milliseconds>(realDuration).count() << " ms" << std::endl;
+
+	for (auto &run : runs)
+	{
+		run.implement->terminate();
+	}
+	app.stop();
+	AsyncLogger::stop();
+	return 0;
+}
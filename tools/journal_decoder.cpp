@@ -0,0 +1,56 @@
+/**
+ * @author Daan Steenbergen
+ * @brief Decodes the segments of the event journal to text or JSON lines
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright 2026 Daan Steenbergen
+ */
+#include "event_journal.hpp"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+int main(int argc, char **argv)
+{
+	auto format = EventJournal::Format::Text;
+	std::vector<std::string> paths;
+	for (int i = 1; i < argc; i++)
+	{
+		std::string argument = argv[i];
+		if ("--json" == argument)
+		{
+			format = EventJournal::Format::Json;
+		}
+		else
+		{
+			paths.push_back(argument);
+		}
+	}
+
+	if (paths.empty())
+	{
+		std::cerr << "Usage: journal-decoder [--json] <segment>..." << std::endl;
+		std::cerr << "Segments are decoded in the given order, both .tcj and .tcz segments are supported." << std::endl;
+		return 1;
+	}
+
+	int result = 0;
+	std::vector<std::uint8_t> events;
+	for (const auto &path : paths)
+	{
+		if (!EventJournal::read_segment(path, events))
+		{
+			std::cerr << "Unable to read segment " << path << std::endl;
+			result = 1;
+			continue;
+		}
+		if (!EventJournal::decode(events, format, std::cout))
+		{
+			// Expected for the segment that was open when the application stopped unexpectedly
+			std::cerr << "Segment " << path << " ends in a partial event" << std::endl;
+		}
+	}
+	return result;
+}
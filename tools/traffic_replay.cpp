@@ -0,0 +1,325 @@
+/**
+ * @author Daan Steenbergen
+ * @brief Replays a traffic recording into the task controller and records what it sends
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright 2026 Daan Steenbergen
+ */
+#include "app.hpp"
+#include "app_clock.hpp"
+#include "async_logger.hpp"
+#include "log_macros.hpp"
+#include "traffic_recorder.hpp"
+
+#include "isobus/hardware_integration/can_hardware_plugin.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+/// @brief Feeds the received CAN frames of a recording to the task controller at their recorded time
+class ReplayCANPlugin : public isobus::CANHardwarePlugin
+{
+public:
+	explicit ReplayCANPlugin(std::vector<TrafficRecorder::Record> frames) :
+	  frames(std::move(frames))
+	{
+	}
+
+	bool get_is_valid() const override
+	{
+		return isOpen;
+	}
+
+	void open() override
+	{
+		isOpen = true;
+	}
+
+	void close() override
+	{
+		isOpen = false;
+	}
+
+	bool read_frame(isobus::CANMessageFrame &canFrame) override
+	{
+		std::size_t index = nextFrame.load();
+		if (isStarted && (index < frames.size()) && (get_time(frames[index]) <= AppClock::now()))
+		{
+			const auto &record = frames[index];
+			canFrame = {};
+			canFrame.identifier = record.identifier;
+			canFrame.isExtendedFrame = record.isExtendedFrame;
+			canFrame.dataLength = static_cast<std::uint8_t>(record.data.size());
+			std::copy(record.data.begin(), record.data.end(), canFrame.data);
+			nextFrame = index + 1;
+			return true;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(1)); // The receive thread calls this in a loop
+		return false;
+	}
+
+	bool write_frame(const isobus::CANMessageFrame &) override
+	{
+		numberOfFramesWritten++;
+		return true; // Recorded through the CAN hardware interface
+	}
+
+	/**
+	 * @brief Start delivering frames
+	 * @param time The time that maps to the start of the recording
+	 */
+	void start(AppClock::time_point time)
+	{
+		startTime = time;
+		isStarted = true;
+	}
+
+	/// @brief The time of the next frame to deliver, or AppClock::time_point::max() when all were delivered
+	AppClock::time_point get_next_frame_time() const
+	{
+		std::size_t index = nextFrame.load();
+		return index < frames.size() ? get_time(frames[index]) : AppClock::time_point::max();
+	}
+
+	std::size_t get_number_of_frames_read() const
+	{
+		return nextFrame.load();
+	}
+
+	std::uint32_t get_number_of_frames_written() const
+	{
+		return numberOfFramesWritten.load();
+	}
+
+private:
+	AppClock::time_point get_time(const TrafficRecorder::Record &record) const
+	{
+		return startTime + std::chrono::microseconds(record.time_us);
+	}
+
+	const std::vector<TrafficRecorder::Record> frames;
+	std::atomic_bool isOpen = { false };
+	std::atomic_bool isStarted = { false };
+	AppClock::time_point startTime;
+	std::atomic<std::size_t> nextFrame = { 0 };
+	std::atomic<std::uint32_t> numberOfFramesWritten = { 0 };
+};
+
+static const char *get_record_type_name(TrafficRecorder::RecordType type)
+{
+	switch (type)
+	{
+		case TrafficRecorder::RecordType::DatagramReceived:
+			return "udp-rx";
+		case TrafficRecorder::RecordType::DatagramSent:
+			return "udp-tx";
+		case TrafficRecorder::RecordType::CanFrameReceived:
+			return "can-rx";
+		case TrafficRecorder::RecordType::CanFrameSent:
+			return "can-tx";
+	}
+	return "unknown";
+}
+
+static void dump(const std::vector<TrafficRecorder::Record> &records)
+{
+	for (const auto &record : records)
+	{
+		std::cout << std::dec << std::setfill(' ') << std::setw(12) << record.time_us << " " << get_record_type_name(record.type) << " ";
+		if ((TrafficRecorder::RecordType::CanFrameReceived == record.type) || (TrafficRecorder::RecordType::CanFrameSent == record.type))
+		{
+			std::cout << std::hex << std::setfill('0') << std::setw(record.isExtendedFrame ? 8 : 3) << record.identifier << " ";
+		}
+		for (std::uint8_t value : record.data)
+		{
+			std::cout << std::hex << std::setfill('0') << std::setw(2) << static_cast<int>(value);
+		}
+		std::cout << std::endl;
+	}
+	std::cout << std::dec;
+}
+
+static std::map<TrafficRecorder::RecordType, std::size_t> count_records(const std::vector<TrafficRecorder::Record> &records)
+{
+	std::map<TrafficRecorder::RecordType, std::size_t> counts;
+	for (const auto &record : records)
+	{
+		counts[record.type]++;
+	}
+	return counts;
+}
+
+int main(int argc, char **argv)
+{
+	std::string recordingPath;
+	std::string outputPath;
+	std::uint32_t speed = 1;
+	bool isDump = false;
+	for (int i = 1; i < argc; i++)
+	{
+		std::string argument = argv[i];
+		if ("--dump" == argument)
+		{
+			isDump = true;
+		}
+		else if (0 == argument.rfind("--speed=", 0))
+		{
+			speed = static_cast<std::uint32_t>(std::stoul(argument.substr(8)));
+		}
+		else if (0 == argument.rfind("--output=", 0))
+		{
+			outputPath = argument.substr(9);
+		}
+		else if (recordingPath.empty() && (0 != argument.rfind("--", 0)))
+		{
+			recordingPath = argument;
+		}
+		else
+		{
+			recordingPath.clear();
+			break;
+		}
+	}
+	if (recordingPath.empty())
+	{
+		std::cerr << "Usage: traffic-replay [options] <recording.tctr>" << std::endl;
+		std::cerr << "  --speed=<n>\t\tReplay at n times real time, 0 for as fast as possible (1)" << std::endl;
+		std::cerr << "  --output=<file>\tRecord the replayed traffic and what the task controller sends" << std::endl;
+		std::cerr << "  --dump\t\tPrint the records instead of replaying them" << std::endl;
+		return 1;
+	}
+
+	// Started before reading, so the reasons a recording can't be read are shown
+	AsyncLogger::start(std::cout.rdbuf(), "");
+	std::vector<TrafficRecorder::Record> records;
+	std::chrono::system_clock::time_point recordingStartTime;
+	bool isComplete = TrafficRecorder::read(recordingPath, records, recordingStartTime);
+	if (records.empty())
+	{
+		AsyncLogger::stop();
+		return 1;
+	}
+	if (!isComplete)
+	{
+		TC_LOG_WARNING("The recording ends in a partial record, e.g. after a crash, the complete records are used");
+	}
+	if (isDump)
+	{
+		AsyncLogger::stop();
+		dump(records);
+		return 0;
+	}
+
+	std::vector<TrafficRecorder::Record> datagrams;
+	std::vector<TrafficRecorder::Record> frames;
+	for (const auto &record : records)
+	{
+		if (TrafficRecorder::RecordType::DatagramReceived == record.type)
+		{
+			datagrams.push_back(record);
+		}
+		else if (TrafficRecorder::RecordType::CanFrameReceived == record.type)
+		{
+			frames.push_back(record);
+		}
+	}
+
+	// The replay always runs on virtual time, paced to real time unless it runs as fast as possible.
+	// It starts at the time of the recording, so the task data and logs of every replay get the same timestamps.
+	AppClock::set_virtual(true);
+	AppClock::set_wall_time(recordingStartTime);
+	auto canDriver = std::make_shared<ReplayCANPlugin>(frames);
+	Application app(canDriver);
+	if (!outputPath.empty() && !app.record_traffic(outputPath))
+	{
+		AsyncLogger::stop();
+		return 1;
+	}
+	if (!app.initialize())
+	{
+		std::cerr << "Failed to initialize the task controller" << std::endl;
+		AsyncLogger::stop();
+		return 1;
+	}
+
+	// A bit longer than the update interval of the CAN stack's thread, which processes the received frames
+	constexpr auto QUIET_TIME = std::chrono::milliseconds(5);
+	// The heartbeat to AOG is the shortest timer of the application
+	constexpr auto MAXIMUM_TIME_STEP = std::chrono::milliseconds(100);
+	auto realStartTime = std::chrono::steady_clock::now();
+	auto startTime = AppClock::now();
+	auto endTime = startTime + std::chrono::microseconds(records.empty() ? 0 : records.back().time_us) + std::chrono::seconds(1);
+	canDriver->start(startTime);
+	std::size_t nextDatagram = 0;
+	std::size_t lastNumberOfFrames = 0;
+	while (AppClock::now() < endTime)
+	{
+		auto now = AppClock::now();
+		while ((nextDatagram < datagrams.size()) && (startTime + std::chrono::microseconds(datagrams[nextDatagram].time_us) <= now))
+		{
+			app.inject_datagram(datagrams[nextDatagram].data);
+			nextDatagram++;
+		}
+		if (!app.update())
+		{
+			break;
+		}
+
+		if (0 != speed)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			AppClock::advance_to(startTime + (std::chrono::steady_clock::now() - realStartTime) * speed);
+			continue;
+		}
+
+		// As fast as possible: once the stack has processed the frames that are due, skip to the next event
+		auto nextFrameTime = canDriver->get_next_frame_time();
+		std::size_t numberOfFrames = canDriver->get_number_of_frames_read() + canDriver->get_number_of_frames_written();
+		if ((nextFrameTime <= now) || (numberOfFrames != lastNumberOfFrames))
+		{
+			lastNumberOfFrames = numberOfFrames;
+			std::this_thread::sleep_for(QUIET_TIME);
+			continue;
+		}
+		auto nextTime = std::min({ nextFrameTime, now + MAXIMUM_TIME_STEP, app.get_task_controller()->get_next_scheduled_section_time() });
+		if (nextDatagram < datagrams.size())
+		{
+			nextTime = std::min(nextTime, startTime + std::chrono::microseconds(datagrams[nextDatagram].time_us));
+		}
+		AppClock::advance_to(nextTime);
+	}
+	auto realDuration = std::chrono::steady_clock::now() - realStartTime;
+	app.stop();
+	std::vector<TrafficRecorder::Record> outputs;
+	bool hasOutputs = !outputPath.empty() && (TrafficRecorder::read(outputPath, outputs) || !outputs.empty());
+	AsyncLogger::stop();
+
+	std::cout << std::endl;
+	std::cout << "Replayed " << nextDatagram << " datagrams and " << canDriver->get_number_of_frames_read() << " CAN frames of "
+	          << std::chrono::duration_cast<std::chrono::seconds>(AppClock::now() - startTime).count() << " s in "
+	          << std::chrono::duration_cast<std::chrono::milliseconds>(realDuration).count() << " ms" << std::endl;
+
+	auto recordedCounts = count_records(records);
+	std::cout << "Recorded: " << recordedCounts[TrafficRecorder::RecordType::DatagramSent] << " datagrams and "
+	          << recordedCounts[TrafficRecorder::RecordType::CanFrameSent] << " CAN frames sent" << std::endl;
+	if (hasOutputs)
+	{
+		auto replayedCounts = count_records(outputs);
+		std::cout << "Replayed: " << replayedCounts[TrafficRecorder::RecordType::DatagramSent] << " datagrams and "
+		          << replayedCounts[TrafficRecorder::RecordType::CanFrameSent] << " CAN frames sent, see " << outputPath << std::endl;
+	}
+	else
+	{
+		std::cout << "Replayed: " << canDriver->get_number_of_frames_written() << " CAN frames sent" << std::endl;
+	}
+	return 0;
+}